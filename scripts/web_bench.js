@@ -0,0 +1,51 @@
+// Headless benchmark of the web build variants (scalar, wasm SIMD, pthreads).
+// Build the variants with `make web-bench`, then run (from the repository root):
+//   node scripts/web_bench.js [configuration (default: all)] [generations (default: 200)] [results csv]
+// Each variant runs in its own Node process; results are printed as a table and written as csv.
+
+const { execFileSync } = require("child_process");
+const fs = require("fs");
+const path = require("path");
+
+const VARIANTS = ["scalar", "simd", "threads"];
+const bench_dir = path.join(__dirname, "..", "web", "bench");
+const which = process.argv[2] || "all";
+const gens = process.argv[3] || "200";
+const results_path = process.argv[4] || "web_bench.csv";
+
+const results = [];
+for (const variant of VARIANTS) {
+  const script = path.join(bench_dir, "Aagos-bench-" + variant + ".js");
+  if (!fs.existsSync(script)) {
+    console.log("Skipping " + variant + " (" + script + " not built; see make web-bench).");
+    continue;
+  }
+  console.log("==> Web benchmark: " + variant + " <==");
+  let output = "";
+  try {
+    output = execFileSync(process.execPath, [script, which, gens], { encoding: "utf8", maxBuffer: 64 << 20 });
+  } catch (err) {
+    console.log("Benchmark " + variant + " failed: " + err.message);
+    continue;
+  }
+  for (const line of output.split("\n")) {
+    if (!line.startsWith("RESULT,")) continue;
+    const [, name, config, generations, run_sec, gens_per_sec] = line.trim().split(",");
+    results.push({ variant: name, config, generations, run_sec, gens_per_sec });
+  }
+}
+
+if (!results.length) {
+  console.log("No results.");
+  process.exit(1);
+}
+console.table(results.map((r) => ({
+  variant: r.variant,
+  config: r.config,
+  "generations/sec": Number(r.gens_per_sec).toFixed(1),
+  "run (s)": Number(r.run_sec).toFixed(3)
+})));
+const csv = ["variant,config,generations,run_sec,generations_per_sec"]
+  .concat(results.map((r) => [r.variant, r.config, r.generations, r.run_sec, r.gens_per_sec].join(",")));
+fs.writeFileSync(results_path, csv.join("\n") + "\n");
+console.log("Web benchmark results written to " + results_path);
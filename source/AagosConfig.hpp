@@ -13,12 +13,35 @@ EMP_BUILD_CONFIG(AagosConfig,
     VALUE(MAX_GENS, size_t, 50000, "How many generations should the runs go for?"),
     VALUE(SEED, int, 0, "Random number seed (0 for based on time)"),
     VALUE(TOURNAMENT_SIZE, size_t, 2, "How many organisms should be chosen for each tournament?"),
+    VALUE(DRIFT_MODE, bool, false, "While the tournament size is 1 (no selection), only evaluate the population at generations that output it? (ignored with PHYLOGENY_TRACKING)"),
     VALUE(GRADIENT_MODEL, bool, false, "Whether the current experiment uses a gradient model for fitness or trad. fitness"),
+    VALUE(NK_PROCEDURAL_LANDSCAPE, bool, false, "Generate NK landscape values on demand instead of storing the full table? (for large gene sizes)"),
     VALUE(LOAD_ANCESTOR, bool, false, "Should we initialize population with ancestor genotype from file?"),
-    VALUE(LOAD_ANCESTOR_FILE, std::string, "ancestor.csv", "File to load ancestor genotype from"),
+    VALUE(LOAD_ANCESTOR_FILE, std::string, "ancestor.csv", "File to load ancestor genotype from (ancestor list, population snapshot csv, or binary population snapshot)"),
+    VALUE(LOAD_ANCESTOR_THREADS, size_t, 0, "Number of threads to use when loading population snapshots (0 = one per hardware thread)"),
     VALUE(RANDOMIZE_LOAD_ANCESTOR_BITS, bool, false, "Should we randomize the bit values for loaded ancestor?"),
+    VALUE(EVAL_THREADS, size_t, 1, "Number of threads to evaluate the population with (0 = one per hardware thread)"),
     VALUE(LOAD_ENV_FROM_FILE, bool, false, "Should we load the environment from a file?"),
     VALUE(LOAD_ENV_FILE, std::string, "environment.env", "File to load environment from (if configured to load)"),
+    VALUE(SHARE_ENV, bool, false, "Share NK landscapes loaded from file read-only between runs on the same machine? (changes stay private to each run)"),
+    VALUE(SHARED_ENV_DIR, std::string, "/dev/shm", "Where to publish shared copies of non-binary environment files"),
+
+  GROUP(GRID, "Spatial population structure: organisms on a toroidal grid compete in local tournaments"),
+    VALUE(GRID_WIDTH, size_t, 0, "Width of the grid (0 = well-mixed population); POP_SIZE must be a multiple of it"),
+    VALUE(GRID_NEIGHBORHOOD_RADIUS, size_t, 1, "Tournaments are drawn from the (2 * radius + 1)^2 cells around each cell"),
+    VALUE(GRID_TILE_SIZE, size_t, 16, "Side length of the tiles of cells that parents are selected in (split between EVAL_THREADS)"),
+
+  GROUP(ISLANDS, "Island model: split the population into sub-populations stepped in parallel"),
+    VALUE(NUM_ISLANDS, size_t, 1, "Number of islands to split the population (POP_SIZE) between (1 = single well-mixed population)"),
+    VALUE(MIGRATION_INTERVAL, size_t, 100, "How many generations elapse between migrations? (0 = no migration)"),
+    VALUE(MIGRATION_RATE, double, 0.01, "Fraction of each island's population that migrates each migration"),
+    VALUE(MIGRATION_TOPOLOGY, std::string, "ring", "Where do migrants go? ring (next island), full (all other islands), random (a random other island each migration)"),
+
+  GROUP(ENV_BANK, "Environment bank: switch between a fixed set of environments instead of mutating the environment"),
+    VALUE(ENV_BANK_SIZE, size_t, 0, "Number of environments in the bank (0 = no bank); the initial environment plus randomly generated ones"),
+    VALUE(ENV_BANK_FILES, std::string, "", "Comma-separated environment files to fill the bank with instead (overrides ENV_BANK_SIZE and LOAD_ENV_FILE)"),
+    VALUE(ENV_BANK_SCHEDULE, std::string, "cycle", "Order to switch environments in (every CHANGE_FREQUENCY generations): cycle, random, or a list of environment ids (e.g., 0,1,0,2)"),
+    VALUE(ENV_BANK_CACHE_SIZE, size_t, 100000, "Genomes to remember the fitness of in each bank environment (0 = no fitness caching)"),
 
   GROUP(RUN_SECOND_PHASE, "Will run have a second phase with new configuration parameters? (limited set of things can change)"),
     VALUE(PHASE_2_ACTIVE, bool, false, "Should run continue to a second phase with new parameters?"),
@@ -32,6 +55,8 @@ EMP_BUILD_CONFIG(AagosConfig,
     VALUE(PHASE_2_BIT_FLIP_PROB, double, 0.01, "BIT_FLIP_PROB for second phase of evolution"),
     VALUE(PHASE_2_BIT_INS_PROB, double, 0.01, "BIT_INS_PROB for second phase of evolution"),
     VALUE(PHASE_2_BIT_DEL_PROB, double, 0.01, "BIT_DEL_PROB for second phase of evolution"),
+    VALUE(PHASE_2_BRANCHES_FILE, std::string, "", "Branch phase one's final population into each phase two listed in this file (empty = a single phase two; native only)"),
+    VALUE(PHASE_2_BRANCH_PROCESSES, size_t, 0, "Number of phase-two branches to run at once (0 = one per hardware thread)"),
 
   GROUP(GENOME_STRUCTURE, "How should each organism's genome be setup?"),
     VALUE(NUM_BITS, size_t, 128, "Starting number of bits in each organism"),
@@ -51,8 +76,12 @@ EMP_BUILD_CONFIG(AagosConfig,
     VALUE(PRINT_INTERVAL, size_t, 1000, "How many updates between prints?"),
     VALUE(SUMMARY_INTERVAL, size_t, 1000, "How many updates between statistic gathering?"),
     VALUE(SNAPSHOT_INTERVAL, size_t, 10000, "How many updates between snapshots?"),
+    VALUE(SNAPSHOT_BINARY, bool, false, "Should population snapshots also be written in binary (pop_<update>.bin)? (for fast reloading)"),
+    VALUE(ENV_LOG, bool, false, "Log environment changes compactly (environment_log.bin and binary keyframes) instead of writing full environments to environment.csv"),
     VALUE(PHYLOGENY_TRACKING, bool, true, "Should we collect phylogeny data?"),
-    VALUE(DATA_FILEPATH, std::string, "./output/", "what directory should all data files be written to?")
+    VALUE(DATA_FILEPATH, std::string, "./output/", "what directory should all data files be written to?"),
+    VALUE(WEB_STREAM_PORT, size_t, 0, "Port to stream live frames to the web interface on (localhost WebSocket; 0 = no streaming)"),
+    VALUE(WEB_STREAM_INTERVAL, double, 100.0, "Minimum milliseconds between streamed frames")
 )
 
 }
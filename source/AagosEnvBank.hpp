@@ -0,0 +1,225 @@
+#ifndef AAGOS_ENV_BANK_HPP
+#define AAGOS_ENV_BANK_HPP
+
+#include "AagosOrg.hpp"
+#include "AagosKernels.hpp"
+
+#include "emp/base/assert.hpp"
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace aagos {
+
+/// Phenotypes of genomes already evaluated in one (fixed) environment, keyed by genome content (bits
+/// and gene starts). Lookups are safe from several evaluation threads at once: misses are staged per
+/// thread (Fetch, then Store once evaluated) and added to the cache by Commit, which must be called
+/// from a single thread after evaluation. When the cache reaches its capacity, it starts over.
+class AagosFitnessCache {
+public:
+  using genome_t = AagosOrg::Genome;
+  using phenotype_t = AagosOrg::Phenotype;
+  using key_t = emp::vector<uint64_t>;
+
+  struct Entry {
+    double fitness;
+    emp::vector<double> gene_fitness_contributions;
+  };
+
+protected:
+  struct KeyHash {
+    size_t operator()(const key_t & key) const {
+      uint64_t hash = UINT64_C(0xcbf29ce484222325);
+      for (uint64_t word : key) {
+        hash ^= word + UINT64_C(0x9E3779B97F4A7C15) + (hash << 6) + (hash >> 2);
+      }
+      return (size_t)hash;
+    }
+  };
+
+  struct ThreadState {
+    key_t key;                                   ///< Key of the genome last fetched (if it missed).
+    emp::vector<std::pair<key_t, Entry>> staged; ///< Misses evaluated since the last Commit.
+    size_t hits=0;
+  };
+
+  std::unordered_map<key_t, Entry, KeyHash> entries;
+  emp::vector<ThreadState> threads;
+  size_t capacity;
+  size_t total_hits=0;
+  size_t total_misses=0;
+
+  static void MakeKey(const genome_t & genome, key_t & key) {
+    kernels::LoadWords(genome.bits, key);
+    key.push_back((uint64_t)genome.GetNumBits());
+    for (size_t start : genome.gene_starts) key.push_back((uint64_t)start);
+  }
+
+public:
+  AagosFitnessCache(size_t _capacity, size_t num_threads=1)
+    : threads(std::max<size_t>(1, num_threads)), capacity(_capacity) { ; }
+
+  size_t GetSize() const { return entries.size(); }
+  size_t GetCapacity() const { return capacity; }
+  size_t GetHits() const { return total_hits; }
+  size_t GetMisses() const { return total_misses; }
+
+  /// Fill phen from the cache if genome has been evaluated in this environment. Otherwise returns
+  /// false; evaluate the organism, then Store its phenotype (from the same thread).
+  bool Fetch(size_t thread_id, const genome_t & genome, phenotype_t & phen) {
+    emp_assert(thread_id < threads.size());
+    ThreadState & state = threads[thread_id];
+    MakeKey(genome, state.key);
+    const auto it = entries.find(state.key);
+    if (it == entries.end()) return false;
+    phen.fitness = it->second.fitness;
+    phen.gene_fitness_contributions = it->second.gene_fitness_contributions;
+    phen.evaluated = true;
+    ++state.hits;
+    return true;
+  }
+
+  /// Stage the phenotype of the genome that thread_id's last Fetch missed.
+  void Store(size_t thread_id, const phenotype_t & phen) {
+    ThreadState & state = threads[thread_id];
+    state.staged.emplace_back(std::move(state.key), Entry{phen.fitness, phen.gene_fitness_contributions});
+  }
+
+  /// Add staged phenotypes to the cache.
+  void Commit() {
+    for (ThreadState & state : threads) {
+      total_hits += state.hits;
+      total_misses += state.staged.size();
+      state.hits = 0;
+      for (auto & staged : state.staged) {
+        if (entries.size() >= capacity) entries.clear();
+        entries.emplace(std::move(staged.first), std::move(staged.second));
+      }
+      state.staged.clear();
+    }
+  }
+
+  /// Forget everything (e.g., if the environment itself changes).
+  void Clear() {
+    entries.clear();
+    for (ThreadState & state : threads) {
+      state.staged.clear();
+      state.hits = 0;
+    }
+  }
+};
+
+/// A fixed set of environments (fitness models) that a run switches between, each with its own
+/// fitness cache (if cache_capacity > 0). Switching environments only changes which model and cache
+/// are current, so nothing is regenerated or rescored when the run returns to an environment.
+///
+/// Schedules: "cycle" (0, 1, ..., n-1, 0, ...), "random" (a different random environment each
+/// switch), or an explicit, repeating list of environment ids (e.g., "0,1,0,2").
+template<typename MODEL>
+class AagosEnvBank {
+protected:
+  emp::vector<emp::Ptr<MODEL>> envs;
+  emp::vector<emp::Ptr<AagosFitnessCache>> caches;
+  size_t cache_capacity;
+  size_t num_threads;
+  emp::vector<size_t> schedule;   ///< Explicit schedule (empty => cycle or random).
+  bool random_schedule=false;
+  size_t schedule_pos=0;
+  size_t current=0;
+
+public:
+  AagosEnvBank(size_t _cache_capacity, size_t _num_threads)
+    : cache_capacity(_cache_capacity), num_threads(_num_threads) { ; }
+
+  AagosEnvBank(const AagosEnvBank &) = delete;
+  AagosEnvBank & operator=(const AagosEnvBank &) = delete;
+
+  ~AagosEnvBank() {
+    for (auto & env : envs) env.Delete();
+    for (auto & cache : caches) if (cache != nullptr) cache.Delete();
+  }
+
+  /// Add env (the bank takes ownership).
+  void Add(emp::Ptr<MODEL> env) {
+    envs.emplace_back(env);
+    caches.emplace_back(cache_capacity ? emp::NewPtr<AagosFitnessCache>(cache_capacity, num_threads) : nullptr);
+  }
+
+  /// Set the schedule from its description (see above). Returns false (with error set) if the
+  /// description is invalid.
+  bool SetSchedule(const std::string & spec, std::string & error) {
+    schedule.clear();
+    random_schedule = (spec == "random");
+    if (spec == "cycle" || spec == "random") return true;
+    std::string list(spec);
+    std::replace(list.begin(), list.end(), ',', ' ');
+    std::istringstream stream(list);
+    size_t env_id;
+    while (stream >> env_id) {
+      if (env_id >= envs.size()) {
+        error = "Environment bank schedule refers to environment " + std::to_string(env_id) + ", but the bank only has " + std::to_string(envs.size()) + ".";
+        return false;
+      }
+      schedule.emplace_back(env_id);
+    }
+    if (!stream.eof() || schedule.empty()) {
+      error = "Invalid environment bank schedule (" + spec + "); expected cycle, random, or a list of environment ids.";
+      return false;
+    }
+    return true;
+  }
+
+  size_t GetSize() const { return envs.size(); }
+  size_t GetCurrentID() const { return current; }
+  emp::Ptr<MODEL> GetEnv(size_t env_id) const { return envs[env_id]; }
+  emp::Ptr<MODEL> GetCurrent() const { return envs[current]; }
+  /// Fitness cache of the current environment (nullptr if caching is off).
+  emp::Ptr<AagosFitnessCache> GetCurrentCache() const { return caches[current]; }
+
+  /// Take on other's environments and schedule position (e.g., to continue another world's run). Both
+  /// banks must have the same size and schedule; caches are cleared rather than copied.
+  void CopyStateFrom(const AagosEnvBank & other) {
+    emp_assert(other.envs.size() == envs.size(), other.envs.size(), envs.size());
+    for (size_t env_id = 0; env_id < envs.size(); ++env_id) {
+      envs[env_id].Delete();
+      envs[env_id] = emp::NewPtr<MODEL>(*other.envs[env_id]);
+      if (caches[env_id] != nullptr) caches[env_id]->Clear();
+    }
+    schedule_pos = other.schedule_pos;
+    current = other.current;
+  }
+
+  /// Start (or restart) the schedule from its first environment.
+  void Start() {
+    schedule_pos = 0;
+    current = schedule.size() ? schedule[0] : 0;
+  }
+
+  /// Switch to the next scheduled environment; returns its id.
+  size_t Next(emp::Random & random) {
+    emp_assert(envs.size());
+    if (random_schedule) {
+      if (envs.size() > 1) {
+        const size_t pick = random.GetUInt(envs.size() - 1);
+        current = (pick >= current) ? pick + 1 : pick;
+      }
+    } else if (schedule.size()) {
+      schedule_pos = (schedule_pos + 1) % schedule.size();
+      current = schedule[schedule_pos];
+    } else {
+      current = (current + 1) % envs.size();
+    }
+    return current;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef AAGOS_ENV_FILE_HPP
+#define AAGOS_ENV_FILE_HPP
+
+#include "AagosParsing.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace aagos {
+
+/// Binary environment files.
+///
+/// Layout (all fields little-endian, i.e., native on every platform we run on):
+///   - Header (48 bytes; see below)
+///   - Payload
+///     - NK: num_genes tables of 2^(K+1) doubles (table for gene 0 first).
+///     - Gradient: num_genes targets, each packed into ceil(gene_size / 64) uint64 words
+///       (bit i of a target is bit (i % 64) of word (i / 64)).
+/// Payloads can be used directly from a memory-mapped file.
+namespace env_file {
+
+enum class MODEL : uint32_t { NK=0, GRADIENT=1 };
+
+constexpr char MAGIC[8] = {'A','A','G','O','S','E','N','V'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t model;
+  uint64_t num_genes;
+  uint64_t gene_size;
+  uint64_t k;               ///< NK epistasis (gene_size - 1); 0 for gradient environments.
+  uint64_t payload_bytes;
+};
+static_assert(sizeof(Header) == 48, "Binary environment header must be 48 bytes.");
+
+inline Header MakeHeader(MODEL model, size_t num_genes, size_t gene_size, size_t k, size_t payload_bytes) {
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.model = (uint32_t)model;
+  header.num_genes = num_genes;
+  header.gene_size = gene_size;
+  header.k = k;
+  header.payload_bytes = payload_bytes;
+  return header;
+}
+
+inline const char * GetModelName(uint32_t model) {
+  switch ((MODEL)model) {
+    case MODEL::NK: return "nk";
+    case MODEL::GRADIENT: return "gradient";
+    default: return "unknown";
+  }
+}
+
+/// Is model one of the models above?
+inline bool IsKnownModel(uint32_t model) {
+  return model == (uint32_t)MODEL::NK || model == (uint32_t)MODEL::GRADIENT;
+}
+
+/// Does the file start with the binary environment magic number?
+inline bool IsBinary(const parsing::MappedFile & file) {
+  return file.GetSize() >= sizeof(MAGIC) && std::memcmp(file.begin(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/// Read and validate the header of a binary environment file. On success, payload points to the
+/// start of the payload (inside the mapped file).
+inline bool ReadHeader(const parsing::MappedFile & file, const std::string & path,
+                       Header & header, const char *& payload, std::string & error)
+{
+  if (file.GetSize() < sizeof(Header)) {
+    error = path + ": Truncated binary environment header.";
+    return false;
+  }
+  std::memcpy(&header, file.begin(), sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    error = path + ": Not a binary environment file.";
+    return false;
+  }
+  if (header.version != VERSION) {
+    error = path + ": Unsupported binary environment version (" + std::to_string(header.version) + ").";
+    return false;
+  }
+  if (file.GetSize() - sizeof(Header) != header.payload_bytes) {
+    error = path + ": Binary environment payload size (" + std::to_string(file.GetSize() - sizeof(Header))
+            + " bytes) does not match header (" + std::to_string(header.payload_bytes) + " bytes).";
+    return false;
+  }
+  payload = file.begin() + sizeof(Header);
+  return true;
+}
+
+/// Check that header describes an environment of the expected model and dimensions.
+inline bool CheckHeader(const Header & header, const std::string & path, MODEL model,
+                        size_t num_genes, size_t gene_size, std::string & error)
+{
+  if (header.model != (uint32_t)model) {
+    error = path + ": Environment is for the " + std::string(GetModelName(header.model))
+            + " model; expected " + GetModelName((uint32_t)model) + ".";
+    return false;
+  }
+  if (header.num_genes != num_genes || header.gene_size != gene_size) {
+    error = path + ": Environment has " + std::to_string(header.num_genes) + " genes of size "
+            + std::to_string(header.gene_size) + "; expected " + std::to_string(num_genes)
+            + " genes of size " + std::to_string(gene_size) + ".";
+    return false;
+  }
+  return true;
+}
+
+/// Write header followed by the output of write_payload (which is given the output stream).
+template<typename WRITE_FUN>
+bool Write(const std::string & path, const Header & header, WRITE_FUN write_payload) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) return false;
+  out.write((const char *)&header, sizeof(Header));
+  write_payload(out);
+  return (bool)out;
+}
+
+}
+
+}
+
+#endif
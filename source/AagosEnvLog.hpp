@@ -0,0 +1,404 @@
+#ifndef AAGOS_ENV_LOG_HPP
+#define AAGOS_ENV_LOG_HPP
+
+#include "AagosEnvFile.hpp"
+#include "AagosParsing.hpp"
+#include "GradientFitnessModel.hpp"
+#include "NKFitnessModel.hpp"
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace aagos {
+
+/// Environment change logs (ENV_LOG): a compact record of how a run's environment changed, from
+/// which the environment at any update can be rebuilt (see AagosEnvTool materialize).
+///
+/// environment_log.bin holds a header followed by fixed-size records, in the order the changes
+/// happened. Each record says from which update on the change is in effect:
+///   - KEYFRAME: the whole environment is replaced by keyframe <index>, stored as a binary
+///     environment file (environment_key_<index>.envb; see AagosEnvFile.hpp) next to the log.
+///   - NK_STATE: NK landscape value (gene, state = index) is set to value.
+///   - TARGET_BIT: bit index of gene's gradient target is set to value (0 or 1).
+///   - NK_KEYFRAME: as KEYFRAME, but keyframe <index> is a compact NK keyframe
+///     (environment_key_<index>.nkk; see NKKeyframeHeader): procedural and shared landscapes are
+///     stored as their hash key or source file plus the values set since, not as a full table.
+/// Runs log a keyframe when set up, at the start of phase two, and when an environment bank
+/// switches to an environment for the first time (later switches reuse its keyframe). Reader
+/// rebuilds the environment in effect at any update (as AagosEnvTool materialize does).
+namespace env_log {
+
+constexpr char MAGIC[8] = {'A','A','G','O','S','E','L','G'};
+constexpr uint32_t VERSION = 1;
+
+enum class RECORD : uint32_t { KEYFRAME=0, NK_STATE=1, TARGET_BIT=2, NK_KEYFRAME=3 };
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t model;       ///< env_file::MODEL
+  uint64_t num_genes;
+  uint64_t gene_size;
+};
+static_assert(sizeof(Header) == 32, "Environment log header must be 32 bytes.");
+
+struct Record {
+  uint64_t update;      ///< First update evaluated under the change.
+  uint32_t type;        ///< RECORD
+  uint32_t gene;
+  uint64_t index;       ///< Keyframe id, NK state, or target bit.
+  double value;
+};
+static_assert(sizeof(Record) == 32, "Environment log records must be 32 bytes.");
+
+/// Compact NK keyframe: header, then (FILE base) the source file's path, then num_overrides
+/// NKOverride entries. The landscape is the base (procedural values from key, or the environment file
+/// at the source path, which must not have changed since the run) with the overrides applied.
+constexpr char NK_KEYFRAME_MAGIC[8] = {'A','A','G','O','S','N','K','K'};
+
+enum class NK_BASE : uint32_t { PROCEDURAL=0, FILE=1 };
+
+struct NKKeyframeHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t base;          ///< NK_BASE
+  uint64_t num_genes;
+  uint64_t gene_size;
+  uint64_t key;           ///< PROCEDURAL: hash key (see NKLandscape).
+  uint64_t num_overrides;
+  uint64_t path_bytes;    ///< FILE: length of the source path.
+};
+static_assert(sizeof(NKKeyframeHeader) == 56, "Compact NK keyframe header must be 56 bytes.");
+
+struct NKOverride {
+  uint64_t index;         ///< gene * 2^gene_size + state
+  double value;
+};
+static_assert(sizeof(NKOverride) == 16, "Compact NK keyframe entries must be 16 bytes.");
+
+inline std::string GetLogPath(const std::string & dir) { return dir + "environment_log.bin"; }
+inline std::string GetKeyframePath(const std::string & dir, size_t keyframe_id) {
+  return dir + "environment_key_" + std::to_string(keyframe_id) + ".envb";
+}
+inline std::string GetNKKeyframePath(const std::string & dir, size_t keyframe_id) {
+  return dir + "environment_key_" + std::to_string(keyframe_id) + ".nkk";
+}
+
+/// Write a compact NK keyframe (source_path is only used with the FILE base).
+template<typename OVERRIDES_T>
+bool WriteNKKeyframe(const std::string & path, NK_BASE base, size_t num_genes, size_t gene_size,
+                     uint64_t key, const std::string & source_path, const OVERRIDES_T & overrides)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) return false;
+  NKKeyframeHeader header;
+  std::memcpy(header.magic, NK_KEYFRAME_MAGIC, sizeof(NK_KEYFRAME_MAGIC));
+  header.version = VERSION;
+  header.base = (uint32_t)base;
+  header.num_genes = num_genes;
+  header.gene_size = gene_size;
+  header.key = key;
+  header.num_overrides = overrides.size();
+  header.path_bytes = (base == NK_BASE::FILE) ? source_path.size() : 0;
+  out.write((const char *)&header, sizeof(header));
+  out.write(source_path.data(), (std::streamsize)header.path_bytes);
+  for (const auto & entry : overrides) {
+    const NKOverride record{(uint64_t)entry.first, entry.second};
+    out.write((const char *)&record, sizeof(record));
+  }
+  return (bool)out;
+}
+
+/// Read and validate a compact NK keyframe. On success, overrides points to the first of
+/// header.num_overrides entries (inside the mapped file; copy them out with std::memcpy).
+inline bool ReadNKKeyframe(const parsing::MappedFile & file, const std::string & path, NKKeyframeHeader & header,
+                           std::string & source_path, const char *& overrides, std::string & error)
+{
+  if (file.GetSize() < sizeof(NKKeyframeHeader)) {
+    error = path + ": Truncated NK keyframe header.";
+    return false;
+  }
+  std::memcpy(&header, file.begin(), sizeof(NKKeyframeHeader));
+  if (std::memcmp(header.magic, NK_KEYFRAME_MAGIC, sizeof(NK_KEYFRAME_MAGIC)) != 0 || header.version != VERSION
+      || header.base > (uint32_t)NK_BASE::FILE) {
+    error = path + ": Not a (supported) NK keyframe.";
+    return false;
+  }
+  const size_t body = file.GetSize() - sizeof(NKKeyframeHeader);
+  if (header.path_bytes > body || (body - header.path_bytes) / sizeof(NKOverride) < header.num_overrides) {
+    error = path + ": Truncated NK keyframe.";
+    return false;
+  }
+  const char * pos = file.begin() + sizeof(NKKeyframeHeader);
+  source_path.assign(pos, header.path_bytes);
+  overrides = pos + header.path_bytes;
+  return true;
+}
+
+/// Appends records to a run's environment log.
+class Writer {
+protected:
+  std::ofstream out;
+  std::string dir;
+  size_t num_keyframes=0;
+  emp::vector<bool> nk_keyframes;   ///< Is each keyframe a compact NK keyframe?
+
+  void Append(size_t update, RECORD type, size_t gene, size_t index, double value) {
+    const Record record{(uint64_t)update, (uint32_t)type, (uint32_t)gene, (uint64_t)index, value};
+    out.write((const char *)&record, sizeof(Record));
+  }
+
+public:
+  /// Start a new log in directory _dir (which should end with '/'). Returns false if the log
+  /// can't be created.
+  bool Open(const std::string & _dir, env_file::MODEL model, size_t num_genes, size_t gene_size) {
+    dir = _dir;
+    num_keyframes = 0;
+    nk_keyframes.clear();
+    out.open(GetLogPath(dir), std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.model = (uint32_t)model;
+    header.num_genes = num_genes;
+    header.gene_size = gene_size;
+    out.write((const char *)&header, sizeof(Header));
+    return (bool)out;
+  }
+
+  bool IsOpen() const { return out.is_open(); }
+
+  /// Store a keyframe (save(path) should write the current environment as a binary environment
+  /// file, or as a compact NK keyframe if nk_compact); sets keyframe_id. Returns false if the keyframe
+  /// couldn't be written.
+  template<typename SAVE_FUN>
+  bool AddKeyframe(SAVE_FUN save, size_t & keyframe_id, bool nk_compact=false) {
+    keyframe_id = num_keyframes;
+    if (!save(nk_compact ? GetNKKeyframePath(dir, keyframe_id) : GetKeyframePath(dir, keyframe_id))) return false;
+    nk_keyframes.push_back(nk_compact);
+    ++num_keyframes;
+    return true;
+  }
+
+  /// The environment is replaced by keyframe keyframe_id from update on.
+  void LogKeyframe(size_t update, size_t keyframe_id) {
+    emp_assert(keyframe_id < num_keyframes);
+    Append(update, nk_keyframes[keyframe_id] ? RECORD::NK_KEYFRAME : RECORD::KEYFRAME, 0, keyframe_id, 0.0);
+  }
+
+  /// Environment value (gene, index) is set to value from update on.
+  void LogChange(size_t update, RECORD type, size_t gene, size_t index, double value) {
+    Append(update, type, gene, index, value);
+  }
+
+  void Flush() { if (out.is_open()) out.flush(); }
+};
+
+/// Read and validate an environment log. On success, records points to the first of num_records
+/// records (inside the mapped file; copy them out with std::memcpy).
+inline bool Read(const parsing::MappedFile & file, const std::string & path, Header & header,
+                 const char *& records, size_t & num_records, std::string & error)
+{
+  if (file.GetSize() < sizeof(Header)) {
+    error = path + ": Truncated environment log header.";
+    return false;
+  }
+  std::memcpy(&header, file.begin(), sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    error = path + ": Not an environment log.";
+    return false;
+  }
+  if (header.version != VERSION) {
+    error = path + ": Unsupported environment log version (" + std::to_string(header.version) + ").";
+    return false;
+  }
+  // A run that was cut short may leave a partial record at the end; ignore it.
+  records = file.begin() + sizeof(Header);
+  num_records = (file.GetSize() - sizeof(Header)) / sizeof(Record);
+  return true;
+}
+
+/// Rebuild a landscape from a compact NK keyframe into nk. Returns false (see nk.GetLoadError) on
+/// failure.
+inline bool LoadNKKeyframe(NKFitnessModel & nk, const std::string & path) {
+  parsing::MappedFile file(path);
+  NKKeyframeHeader header;
+  std::string source_path;
+  const char * overrides = nullptr;
+  if (!file.IsOpen()) {
+    nk.load_error = file.GetError();
+    return false;
+  }
+  if (!ReadNKKeyframe(file, path, header, source_path, overrides, nk.load_error)) return false;
+  NKLandscape & landscape = nk.GetLandscape();
+  if (header.num_genes != nk.num_genes || header.gene_size != nk.gene_size) {
+    nk.load_error = path + ": Keyframe dimensions don't match the environment log.";
+    return false;
+  }
+  if (header.base == (uint32_t)NK_BASE::PROCEDURAL) {
+    landscape.SetProcedural(header.key);
+  } else if (!nk.LoadLandscape(source_path)) {
+    nk.load_error = path + ": Unable to load the keyframe's source landscape (" + nk.load_error + ").";
+    return false;
+  }
+  for (size_t i = 0; i < header.num_overrides; ++i) {
+    NKOverride entry;
+    std::memcpy(&entry, overrides + i * sizeof(entry), sizeof(entry));
+    if (entry.index >= landscape.GetTotalCount()) {
+      nk.load_error = path + ": Entry " + std::to_string(i) + " is out of range.";
+      return false;
+    }
+    landscape.SetState(entry.index / landscape.GetStateCount(), entry.index % landscape.GetStateCount(), entry.value);
+  }
+  return true;
+}
+
+/// Reads a run's environment log (and keyframes) back, to rebuild the environment in effect at an
+/// update: the last keyframe in effect, plus the changes logged since.
+class Reader {
+public:
+  /// What a Rebuild started from.
+  struct RebuildInfo {
+    size_t keyframe_id=0;
+    size_t keyframe_update=0;
+    size_t num_changes=0;
+  };
+
+protected:
+  std::string dir;
+  std::string log_path;
+  parsing::MappedFile file;
+  Header header;
+  const char * records=nullptr;
+  size_t num_records=0;
+  bool open=false;
+  std::string error;
+
+  Record GetRecord(size_t i) const {
+    Record record;
+    std::memcpy(&record, records + i * sizeof(Record), sizeof(Record));
+    return record;
+  }
+
+  static bool IsKeyframe(const Record & record) {
+    return record.type == (uint32_t)RECORD::KEYFRAME || record.type == (uint32_t)RECORD::NK_KEYFRAME;
+  }
+
+  /// Find the last keyframe record in effect at update (start) and check it suits model.
+  bool FindKeyframe(size_t update, env_file::MODEL model, size_t & start) {
+    if (!IsOpen()) return false;
+    if (header.model != (uint32_t)model) {
+      error = log_path + ": Environment log is for the " + env_file::GetModelName(header.model) + " model.";
+      return false;
+    }
+    start = num_records;
+    for (size_t i = 0; i < num_records; ++i) {
+      const Record record = GetRecord(i);
+      if (record.update <= update && IsKeyframe(record)) start = i;
+    }
+    if (start == num_records) {
+      error = log_path + ": No environment logged for update " + std::to_string(update) + ".";
+      return false;
+    }
+    return true;
+  }
+
+  /// Apply the changes of type logged after record start, up to update; apply(record) checks and
+  /// applies one (returning false if it's out of range).
+  template<typename APPLY_FUN>
+  bool ApplyChanges(size_t start, size_t update, RECORD type, RebuildInfo & info, APPLY_FUN apply) {
+    const Record keyframe = GetRecord(start);
+    info.keyframe_id = keyframe.index;
+    info.keyframe_update = keyframe.update;
+    info.num_changes = 0;
+    for (size_t i = start + 1; i < num_records; ++i) {
+      const Record record = GetRecord(i);
+      if (record.update > update || record.type != (uint32_t)type) continue;
+      if (!apply(record)) {
+        error = log_path + ": Record " + std::to_string(i) + " is out of range.";
+        return false;
+      }
+      ++info.num_changes;
+    }
+    return true;
+  }
+
+public:
+  /// Open the environment log in run_dir.
+  Reader(const std::string & run_dir)
+    : dir(run_dir.size() && run_dir.back() == '/' ? run_dir : run_dir + "/"), log_path(GetLogPath(dir)), file(log_path)
+  {
+    if (!file.IsOpen()) error = file.GetError();
+    else Read(file, log_path, header, records, num_records, error);
+    if (error.empty() && !env_file::IsKnownModel(header.model)) {
+      error = log_path + ": Unknown environment model (" + std::to_string(header.model) + ").";
+    }
+    open = error.empty();
+  }
+
+  Reader(const Reader &) = delete;
+  Reader & operator=(const Reader &) = delete;
+
+  bool IsOpen() const { return open; }
+  const std::string & GetError() const { return error; }
+  const Header & GetHeader() const { return header; }
+  env_file::MODEL GetModel() const { return (env_file::MODEL)header.model; }
+  size_t GetNumGenes() const { return header.num_genes; }
+  size_t GetGeneSize() const { return header.gene_size; }
+
+  /// Rebuild the NK landscape in effect at update into nk (which should have the log's dimensions).
+  /// Returns false (see GetError) on failure.
+  bool Rebuild(size_t update, NKFitnessModel & nk, RebuildInfo & info) {
+    size_t start = 0;
+    if (!FindKeyframe(update, env_file::MODEL::NK, start)) return false;
+    const Record keyframe = GetRecord(start);
+    const bool nk_compact = (keyframe.type == (uint32_t)RECORD::NK_KEYFRAME);
+    const std::string keyframe_path = nk_compact ? GetNKKeyframePath(dir, keyframe.index) : GetKeyframePath(dir, keyframe.index);
+    if (nk_compact ? !LoadNKKeyframe(nk, keyframe_path) : !nk.LoadLandscape(keyframe_path)) {
+      error = nk.GetLoadError();
+      return false;
+    }
+    NKLandscape & landscape = nk.GetLandscape();
+    return ApplyChanges(start, update, RECORD::NK_STATE, info, [&landscape](const Record & record) {
+      if (record.gene >= landscape.GetN() || record.index >= landscape.GetStateCount()) return false;
+      landscape.SetState(record.gene, record.index, record.value);
+      return true;
+    });
+  }
+
+  /// Rebuild the gradient targets in effect at update into gradient (which should have the log's
+  /// dimensions). Returns false (see GetError) on failure.
+  bool Rebuild(size_t update, GradientFitnessModel & gradient, RebuildInfo & info) {
+    size_t start = 0;
+    if (!FindKeyframe(update, env_file::MODEL::GRADIENT, start)) return false;
+    const Record keyframe = GetRecord(start);
+    if (keyframe.type != (uint32_t)RECORD::KEYFRAME) {
+      error = GetNKKeyframePath(dir, keyframe.index) + ": NK keyframe in a gradient log.";
+      return false;
+    }
+    if (!gradient.LoadTargets(GetKeyframePath(dir, keyframe.index))) {
+      error = gradient.GetLoadError();
+      return false;
+    }
+    const size_t gene_size = gradient.gene_size;
+    const bool success = ApplyChanges(start, update, RECORD::TARGET_BIT, info, [&gradient, gene_size](const Record & record) {
+      if (record.gene >= gradient.targets.size() || record.index >= gene_size) return false;
+      gradient.targets[record.gene].Set(record.index, record.value != 0.0);
+      return true;
+    });
+    gradient.PackTargets();
+    return success;
+  }
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef AAGOS_EVALUATORS_HPP
+#define AAGOS_EVALUATORS_HPP
+
+#include "AagosOrg.hpp"
+#include "AagosKernels.hpp"
+#include "GradientFitnessModel.hpp"
+#include "NKFitnessModel.hpp"
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace aagos {
+
+/// Fitness evaluation of a genome under an environment (shared by AagosWorld and batch tools such as
+/// AagosCrossEval). Each evaluator returns the genome's fitness and, if contributions isn't null,
+/// writes each gene's fitness contribution to contributions[0, num_genes). Safe to call from several
+/// threads at once (scratch space is per thread).
+namespace eval {
+
+/// Gradient model: each gene contributes the fraction of its sites that match its target.
+inline double EvaluateGradient(const GradientFitnessModel & model, const AagosOrg::Genome & genome,
+                               size_t num_genes, size_t gene_size, double * contributions=nullptr)
+{
+  thread_local emp::vector<uint64_t> genome_words;
+  thread_local emp::vector<uint64_t> gene_words;
+  const size_t num_bits = genome.GetNumBits();
+  kernels::LoadWords(genome.bits, genome_words);
+  gene_words.resize(kernels::NumWords(gene_size));
+  double fitness = 0.0;
+  for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
+    emp_assert(gene_id < genome.gene_starts.size());
+    // Isolate gene (as if rotated to the front of the genome and resized to gene_size).
+    kernels::ExtractGene(genome_words.data(), num_bits, genome.gene_starts[gene_id], gene_size, gene_words.data());
+    // - Remember, we assume the first index of gene_starts maps to the first index of the target bitstring.
+    emp_assert(genome.gene_starts.size() == model.targets.size());
+    const size_t mismatches = kernels::CountMismatches(gene_words.data(), model.GetTargetWords(gene_id), gene_words.size());
+    const double fitness_contribution = (double)(gene_size - mismatches) / (double)gene_size;
+    if (contributions) contributions[gene_id] = fitness_contribution;
+    fitness += fitness_contribution;
+  }
+  return fitness;
+}
+
+/// NK model: each gene contributes its landscape value for the gene's bits.
+inline double EvaluateNK(const NKFitnessModel & model, const AagosOrg::Genome & genome,
+                         size_t num_genes, size_t gene_size, double * contributions=nullptr)
+{
+  thread_local emp::vector<uint64_t> genome_words;
+  const size_t num_bits = genome.GetNumBits();
+  kernels::LoadWords(genome.bits, genome_words);
+  double fitness = 0.0;
+  for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
+    emp_assert(gene_id < genome.gene_starts.size());
+    emp_assert(genome.gene_starts[gene_id] < num_bits, genome.gene_starts[gene_id], num_bits);
+    // Isolate gene (as if rotated to the front of the genome and resized to gene_size).
+    uint64_t gene_word = 0;
+    kernels::ExtractGene(genome_words.data(), num_bits, genome.gene_starts[gene_id], std::min<size_t>(gene_size, 32), &gene_word);
+    const double fitness_contribution = model.landscape.GetFitness(gene_id, (uint32_t)gene_word);
+    if (contributions) contributions[gene_id] = fitness_contribution;
+    fitness += fitness_contribution;
+  }
+  return fitness;
+}
+
+}
+
+}
+
+#endif
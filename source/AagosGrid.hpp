@@ -0,0 +1,104 @@
+#ifndef AAGOS_GRID_HPP
+#define AAGOS_GRID_HPP
+
+#include "AagosThreadPool.hpp"
+
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace aagos {
+
+/// Spatial population structure: organisms live on a width x height toroidal grid (organism id =
+/// y * width + x), and each cell's parent is the winner of a tournament among the cells in its
+/// (2 * radius + 1) x (2 * radius + 1) neighborhood (itself included).
+///
+/// Parents are chosen for every cell up front, tile by tile (tile_size x tile_size blocks of cells,
+/// whose neighborhoods overlap and stay in cache), with tiles split between threads. Tournament
+/// competitors come from a counter-based generator keyed on (seed, update, cell, competitor), so the
+/// chosen parents don't depend on the number of threads or on the order tiles are processed in.
+class AagosGrid {
+protected:
+  size_t width;
+  size_t height;
+  size_t radius;
+  size_t tile_size;
+  size_t tiles_x;
+  size_t tiles_y;
+
+  /// SplitMix64 finalizer.
+  static uint64_t Mix(uint64_t x) {
+    x += UINT64_C(0x9E3779B97F4A7C15);
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+  }
+
+  /// Cell at offset (dx, dy) from (x, y), wrapping around the edges.
+  size_t GetNeighbor(size_t x, size_t y, size_t dx, size_t dy) const {
+    // dx, dy in [0, 2 * radius]; shift by width/height first so the subtraction can't underflow.
+    const size_t nx = (x + width + dx - radius % width) % width;
+    const size_t ny = (y + height + dy - radius % height) % height;
+    return ny * width + nx;
+  }
+
+  /// Choose parents for the cells of tile tile_id.
+  template<typename FITNESS_FUN>
+  void SelectTile(size_t tile_id, size_t tournament_size, uint64_t key, const FITNESS_FUN & fitness,
+                  emp::vector<size_t> & parents) const
+  {
+    const size_t span = 2 * radius + 1;
+    const size_t neighborhood = span * span;
+    const size_t x0 = (tile_id % tiles_x) * tile_size;
+    const size_t y0 = (tile_id / tiles_x) * tile_size;
+    const size_t x1 = std::min(width, x0 + tile_size);
+    const size_t y1 = std::min(height, y0 + tile_size);
+    for (size_t y = y0; y < y1; ++y) {
+      for (size_t x = x0; x < x1; ++x) {
+        const size_t cell = y * width + x;
+        const uint64_t cell_key = Mix(key ^ Mix(cell));
+        size_t best_id = cell;
+        double best_fitness = 0.0;
+        for (size_t k = 0; k < tournament_size; ++k) {
+          const size_t offset = (size_t)(Mix(cell_key + k) % neighborhood);
+          const size_t id = GetNeighbor(x, y, offset % span, offset / span);
+          const double id_fitness = fitness(id);
+          if (k == 0 || id_fitness > best_fitness) {
+            best_id = id;
+            best_fitness = id_fitness;
+          }
+        }
+        parents[cell] = best_id;
+      }
+    }
+  }
+
+public:
+  AagosGrid(size_t _width, size_t _height, size_t _radius, size_t _tile_size)
+    : width(_width), height(_height), radius(_radius), tile_size(std::max<size_t>(1, _tile_size)),
+      tiles_x((width + tile_size - 1) / tile_size), tiles_y((height + tile_size - 1) / tile_size) { ; }
+
+  size_t GetWidth() const { return width; }
+  size_t GetHeight() const { return height; }
+  size_t GetRadius() const { return radius; }
+  size_t GetNumTiles() const { return tiles_x * tiles_y; }
+
+  /// Choose a parent for every cell (parents[cell]; resized to width * height). fitness(id) must be
+  /// safe to call from several threads at once.
+  template<typename FITNESS_FUN>
+  void SelectParents(size_t tournament_size, uint64_t seed, size_t update, const FITNESS_FUN & fitness,
+                     AagosThreadPool & pool, emp::vector<size_t> & parents) const
+  {
+    parents.resize(width * height);
+    const uint64_t key = Mix(seed ^ Mix((uint64_t)update));
+    pool.Run(GetNumTiles(), [&](size_t begin, size_t end, size_t) {
+      for (size_t tile_id = begin; tile_id < end; ++tile_id) SelectTile(tile_id, tournament_size, key, fitness, parents);
+    });
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef AAGOS_ISLANDS_HPP
+#define AAGOS_ISLANDS_HPP
+
+#include "AagosConfig.hpp"
+#include "AagosWorld.hpp"
+#include "AagosThreadPool.hpp"
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/data/DataFile.hpp"
+#include "emp/math/Random.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+namespace aagos {
+
+/// A single island: an AagosWorld that the island model steps phase by phase.
+class AagosIsland : public AagosWorld {
+public:
+  using AagosWorld::AagosWorld;
+  using AagosWorld::ActivateEvoPhaseTwo;
+};
+
+/// Island model: NUM_ISLANDS sub-populations (POP_SIZE split between them), each an AagosWorld
+/// with its own random number stream, stepped in parallel (one thread per island, up to the
+/// number of hardware threads). Every MIGRATION_INTERVAL generations, each island sends copies of
+/// MIGRATION_RATE * (island size) random organisms to other islands (MIGRATION_TOPOLOGY: ring =>
+/// next island; full => spread over all other islands; random => one random other island per
+/// migration), where they replace random residents.
+///
+/// All islands share the same environment (their environments are drawn from identically seeded
+/// streams). Each island writes the usual output files to DATA_FILEPATH/island_<id>/, and global
+/// plus per-island summary statistics are written to DATA_FILEPATH/island_stats.csv.
+class AagosIslandModel {
+public:
+  using genome_t = AagosWorld::genome_t;
+  using org_t = AagosWorld::org_t;
+
+  enum class TOPOLOGY { RING=0, FULL, RANDOM };
+
+protected:
+  AagosConfig & config;
+  size_t num_islands;
+  TOPOLOGY topology=TOPOLOGY::RING;
+  std::string output_path;
+
+  emp::vector<emp::Ptr<AagosConfig>> island_configs;
+  emp::vector<emp::Ptr<AagosIsland>> islands;
+  emp::Ptr<AagosThreadPool> pool;
+  emp::Ptr<emp::Random> migration_random;   ///< Random topology destinations (main thread only).
+  emp::Ptr<emp::DataFile> stats_file;
+
+  /// Exchange buffers: exchange[dst * num_islands + src] holds genomes migrating from src to dst.
+  /// Each buffer has a single writer (src, while emigrating) and a single reader (dst, while
+  /// immigrating), and the two phases are separated by the thread pool's barrier, so no locks are
+  /// needed.
+  emp::vector<emp::vector<genome_t>> exchange;
+  emp::vector<size_t> destinations;         ///< Random topology: each island's current destination.
+  emp::vector<size_t> immigrants;           ///< Organisms received by each island (running total).
+
+  /// Copy random organisms from island src into its outgoing exchange buffers.
+  void Emigrate(size_t src) {
+    AagosIsland & island = *islands[src];
+    emp::Random & random = island.GetRandom();
+    const size_t island_size = island.GetSize();
+    const size_t count = GetEmigrantCount(config, island_size);
+    const size_t offset = random.GetUInt(num_islands - 1);
+    for (size_t k = 0; k < count; ++k) {
+      const size_t dst = GetDestination(topology, num_islands, src, k, offset, destinations[src]);
+      exchange[dst * num_islands + src].emplace_back(island.GetOrg(random.GetUInt(island_size)).GetGenome());
+    }
+  }
+
+  /// Replace random residents of island dst with organisms waiting in its incoming exchange buffers.
+  void Immigrate(size_t dst) {
+    AagosIsland & island = *islands[dst];
+    emp::Random & random = island.GetRandom();
+    for (size_t src = 0; src < num_islands; ++src) {
+      auto & buffer = exchange[dst * num_islands + src];
+      for (const genome_t & genome : buffer) island.InjectAt(genome, emp::WorldPosition(random.GetUInt(island.GetSize())));
+      immigrants[dst] += buffer.size();
+      buffer.clear();
+    }
+  }
+
+  void SetupStatsFile() {
+    stats_file = emp::NewPtr<emp::DataFile>(output_path + "island_stats.csv");
+    stats_file->AddFun<size_t>([this]() { return islands[0]->GetUpdate(); }, "update", "current generation");
+    stats_file->AddFun<size_t>([this]() { return islands[0]->GetPhase(); }, "evo_phase", "Current phase of evolution");
+    // Global statistics (over every island).
+    stats_file->AddFun<double>([this]() {
+      double total = 0.0; size_t count = 0;
+      for (auto island : islands) {
+        for (size_t org_id = 0; org_id < island->GetSize(); ++org_id) total += island->GetOrg(org_id).GetPhenotype().fitness;
+        count += island->GetSize();
+      }
+      return count ? total / (double)count : 0.0;
+    }, "mean_fitness", "Mean fitness over all islands");
+    stats_file->AddFun<double>([this]() {
+      double max_fitness = 0.0;
+      for (auto island : islands) max_fitness = std::max(max_fitness, GetMaxFitness(*island));
+      return max_fitness;
+    }, "max_fitness", "Max fitness over all islands");
+    stats_file->AddFun<double>([this]() {
+      double total = 0.0; size_t count = 0;
+      for (auto island : islands) {
+        for (size_t org_id = 0; org_id < island->GetSize(); ++org_id) total += (double)island->GetOrg(org_id).GetNumBits();
+        count += island->GetSize();
+      }
+      return count ? total / (double)count : 0.0;
+    }, "mean_genome_length", "Mean genome length over all islands");
+    // Per-island statistics.
+    for (size_t island_id = 0; island_id < num_islands; ++island_id) {
+      const std::string prefix = "island_" + emp::to_string(island_id) + "_";
+      stats_file->AddFun<double>([this, island_id]() { return GetMeanFitness(*islands[island_id]); },
+                                 prefix + "mean_fitness", "Mean fitness on island");
+      stats_file->AddFun<double>([this, island_id]() { return GetMaxFitness(*islands[island_id]); },
+                                 prefix + "max_fitness", "Max fitness on island");
+      stats_file->AddFun<size_t>([this, island_id]() { return immigrants[island_id]; },
+                                 prefix + "immigrants", "Total organisms received from other islands");
+    }
+    stats_file->PrintHeaderKeys();
+  }
+
+  static double GetMeanFitness(AagosIsland & island) {
+    double total = 0.0;
+    for (size_t org_id = 0; org_id < island.GetSize(); ++org_id) total += island.GetOrg(org_id).GetPhenotype().fitness;
+    return island.GetSize() ? total / (double)island.GetSize() : 0.0;
+  }
+
+  static double GetMaxFitness(AagosIsland & island) {
+    double max_fitness = 0.0;
+    for (size_t org_id = 0; org_id < island.GetSize(); ++org_id) {
+      max_fitness = std::max(max_fitness, island.GetOrg(org_id).GetPhenotype().fitness);
+    }
+    return max_fitness;
+  }
+
+  /// Run a single generation on every island (in parallel), then migrate if it's time.
+  void Step() {
+    pool->Run(num_islands, [this](size_t begin, size_t end, size_t) {
+      for (size_t island_id = begin; island_id < end; ++island_id) islands[island_id]->RunStep(false);
+    });
+    // Population is evaluated (and not yet replaced) here.
+    const size_t u = islands[0]->GetUpdate();
+    const size_t summary_interval = config.SUMMARY_INTERVAL();
+    if (summary_interval && !(u % summary_interval)) stats_file->Update();
+
+    const bool migrate = config.MIGRATION_INTERVAL() && u && !(u % config.MIGRATION_INTERVAL());
+    if (migrate && topology == TOPOLOGY::RANDOM) DrawRandomDestinations(*migration_random, destinations);
+    pool->Run(num_islands, [this, migrate](size_t begin, size_t end, size_t) {
+      for (size_t island_id = begin; island_id < end; ++island_id) {
+        islands[island_id]->AdvanceWorld();
+        if (migrate) Emigrate(island_id);
+      }
+    });
+    if (migrate) {
+      pool->Run(num_islands, [this](size_t begin, size_t end, size_t) {
+        for (size_t island_id = begin; island_id < end; ++island_id) Immigrate(island_id);
+      });
+    }
+  }
+
+public:
+  AagosIslandModel(AagosConfig & cfg) : config(cfg), num_islands(cfg.NUM_ISLANDS()) { ; }
+
+  // Helpers shared with other island drivers (e.g., AagosMPI.cc).
+
+  static bool ParseTopology(const std::string & name, TOPOLOGY & topology) {
+    if (name == "ring") topology = TOPOLOGY::RING;
+    else if (name == "full") topology = TOPOLOGY::FULL;
+    else if (name == "random") topology = TOPOLOGY::RANDOM;
+    else return false;
+    return true;
+  }
+
+  /// Island that emigrant number k from island src is sent to. offset is the source island's random
+  /// starting point (full topology); random_dst is its destination this migration (random topology).
+  static size_t GetDestination(TOPOLOGY topology, size_t num_islands, size_t src, size_t k, size_t offset,
+                               size_t random_dst) {
+    switch (topology) {
+      case TOPOLOGY::RING: return (src + 1) % num_islands;
+      case TOPOLOGY::FULL: return (src + 1 + (offset + k) % (num_islands - 1)) % num_islands;
+      case TOPOLOGY::RANDOM: return random_dst;
+    }
+    return src;
+  }
+
+  /// Random topology: draw each island's destination (another island) for this migration.
+  static void DrawRandomDestinations(emp::Random & random, emp::vector<size_t> & destinations) {
+    const size_t num_islands = destinations.size();
+    for (size_t src = 0; src < num_islands; ++src) {
+      destinations[src] = (src + 1 + random.GetUInt(num_islands - 1)) % num_islands;
+    }
+  }
+
+  /// Number of organisms an island of island_size sends each migration.
+  static size_t GetEmigrantCount(const AagosConfig & cfg, size_t island_size) {
+    return std::min(island_size, (size_t)std::llround(cfg.MIGRATION_RATE() * (double)island_size));
+  }
+
+  /// Population size of island island_id (POP_SIZE split as evenly as possible).
+  static size_t GetIslandSize(const AagosConfig & cfg, size_t num_islands, size_t island_id) {
+    return cfg.POP_SIZE() / num_islands + ((island_id < cfg.POP_SIZE() % num_islands) ? 1 : 0);
+  }
+
+  /// Seed shared by all islands' environments (and island seeds are offset from). Drawn from the
+  /// clock if SEED is 0.
+  static int ResolveBaseSeed(const AagosConfig & cfg) {
+    if (cfg.SEED()) return cfg.SEED();
+    emp::Random seed_random(-1);
+    return (int)seed_random.GetUInt(1, 1 << 30);
+  }
+
+  /// Configure island island_id (of num_islands) from the run configuration.
+  static void ConfigureIsland(AagosConfig & cfg, AagosConfig & island_config, size_t num_islands,
+                              size_t island_id, int base_seed, const std::string & output_path) {
+    std::ostringstream config_stream;
+    cfg.Write(config_stream);
+    std::istringstream stream(config_stream.str());
+    island_config.Read(stream);
+    island_config.NUM_ISLANDS(1);
+    island_config.POP_SIZE(GetIslandSize(cfg, num_islands, island_id));
+    island_config.SEED(base_seed + (int)island_id);
+    island_config.EVAL_THREADS(1); // Parallelism comes from stepping islands concurrently.
+    island_config.DATA_FILEPATH(output_path + "island_" + emp::to_string(island_id) + "/");
+    // Only the first island reports progress to the console.
+    if (island_id) island_config.PRINT_INTERVAL(std::numeric_limits<size_t>::max());
+  }
+
+  AagosIslandModel(const AagosIslandModel &) = delete;
+  AagosIslandModel & operator=(const AagosIslandModel &) = delete;
+
+  ~AagosIslandModel() {
+    for (auto island : islands) island.Delete();
+    for (auto island_config : island_configs) island_config.Delete();
+    if (pool != nullptr) pool.Delete();
+    if (migration_random != nullptr) migration_random.Delete();
+    if (stats_file != nullptr) stats_file.Delete();
+  }
+
+  size_t GetNumIslands() const { return num_islands; }
+  AagosIsland & GetIsland(size_t island_id) { return *islands[island_id]; }
+
+  void Setup() {
+    std::cout << "-- Setting up island model -- " << std::endl;
+    if (num_islands < 2) {
+      std::cout << "Island model requires NUM_ISLANDS > 1. Exiting..." << std::endl;
+      exit(-1);
+    }
+    if (config.POP_SIZE() < num_islands) {
+      std::cout << "POP_SIZE (" << config.POP_SIZE() << ") must be at least NUM_ISLANDS (" << num_islands << "). Exiting..." << std::endl;
+      exit(-1);
+    }
+    if (!ParseTopology(config.MIGRATION_TOPOLOGY(), topology)) {
+      std::cout << "Unknown MIGRATION_TOPOLOGY (" << config.MIGRATION_TOPOLOGY() << "); expected ring, full, or random. Exiting..." << std::endl;
+      exit(-1);
+    }
+    output_path = config.DATA_FILEPATH();
+    if (output_path.back() != '/') output_path += '/';
+    mkdir(output_path.c_str(), ACCESSPERMS);
+
+    // Every island shares the base seed's environment; populations get their own streams.
+    const int base_seed = ResolveBaseSeed(config);
+    for (size_t island_id = 0; island_id < num_islands; ++island_id) {
+      emp::Ptr<AagosConfig> island_config = emp::NewPtr<AagosConfig>();
+      ConfigureIsland(config, *island_config, num_islands, island_id, base_seed, output_path);
+      island_configs.emplace_back(island_config);
+      islands.emplace_back(emp::NewPtr<AagosIsland>(*island_config));
+      islands.back()->SetEnvironmentSeed(base_seed);
+    }
+    for (auto island : islands) island->Setup();
+
+    migration_random = emp::NewPtr<emp::Random>(base_seed);
+    exchange.resize(num_islands * num_islands);
+    destinations.assign(num_islands, 0);
+    immigrants.assign(num_islands, 0);
+    pool = emp::NewPtr<AagosThreadPool>(std::min(num_islands, AagosThreadPool::ResolveNumThreads(0)));
+    std::cout << "Stepping " << num_islands << " islands on " << pool->GetNumThreads() << " thread(s)." << std::endl;
+    SetupStatsFile();
+  }
+
+  /// Run every island for the configured number of generations (as AagosWorld::Run does).
+  void Run() {
+    for (size_t gen = 0; gen <= config.MAX_GENS(); ++gen) Step();
+    if (!config.PHASE_2_ACTIVE()) return;
+    for (auto island : islands) island->ActivateEvoPhaseTwo();
+    for (size_t gen = 0; gen <= config.PHASE_2_MAX_GENS(); ++gen) Step();
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef AAGOS_KERNELS_HPP
+#define AAGOS_KERNELS_HPP
+
+#include "emp/base/vector.hpp"
+#include "emp/bits/Bits.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+namespace aagos {
+
+/// Word-level kernels for fitness evaluation (gene extraction and scoring). Genomes are unpacked
+/// into uint64 words once per evaluation (bit i => word i/64, bit i%64); genes are then read out of
+/// the words directly instead of through a rotated copy of the genome.
+/// Web builds with -msimd128 (make web-simd) score gradient genes with wasm SIMD.
+namespace kernels {
+
+/// Number of words needed to hold num_bits bits.
+inline size_t NumWords(size_t num_bits) { return (num_bits + 63) / 64; }
+
+/// Unpack bits into words (resized to match).
+inline void LoadWords(const emp::BitVector & bits, emp::vector<uint64_t> & words) {
+  words.resize(NumWords(bits.GetSize()));
+  for (size_t w = 0; w < words.size(); ++w) words[w] = bits.GetUInt64(w);
+}
+
+/// Read count (<= 64) bits starting at pos; the range must not run past the end of the bits.
+inline uint64_t ReadBits(const uint64_t * words, size_t pos, size_t count) {
+  const size_t w = pos >> 6;
+  const size_t offset = pos & 63;
+  uint64_t value = words[w] >> offset;
+  if (offset && offset + count > 64) value |= words[w + 1] << (64 - offset);
+  return (count == 64) ? value : value & ((UINT64_C(1) << count) - 1);
+}
+
+/// Read count (<= 64, <= num_bits) bits starting at pos, wrapping around the end of the genome.
+inline uint64_t ReadBitsCircular(const uint64_t * words, size_t num_bits, size_t pos, size_t count) {
+  const size_t first = (pos + count <= num_bits) ? count : num_bits - pos;
+  uint64_t value = ReadBits(words, pos, first);
+  if (first < count) value |= ReadBits(words, 0, count - first) << first;
+  return value;
+}
+
+/// Extract the gene_size bits starting at gene_start (wrapping around the genome) into
+/// NumWords(gene_size) words of out. Equivalent to rotating the genome so gene_start is at the
+/// front and resizing to gene_size (genes longer than the genome are zero-padded).
+inline void ExtractGene(const uint64_t * words, size_t num_bits, size_t gene_start, size_t gene_size,
+                        uint64_t * out) {
+  const size_t window = (gene_size < num_bits) ? gene_size : num_bits;
+  for (size_t w = 0; w < NumWords(gene_size); ++w) {
+    const size_t begin = w * 64;
+    if (begin >= window) { out[w] = 0; continue; }
+    const size_t count = (window - begin < 64) ? window - begin : 64;
+    out[w] = ReadBitsCircular(words, num_bits, (gene_start + begin) % num_bits, count);
+  }
+}
+
+/// Number of differing bits between a and b (num_words words each).
+inline size_t CountMismatches(const uint64_t * a, const uint64_t * b, size_t num_words) {
+  size_t count = 0;
+  size_t w = 0;
+#ifdef __wasm_simd128__
+  // Per-byte popcounts, widened and accumulated in 32-bit lanes.
+  v128_t totals = wasm_i32x4_splat(0);
+  for (; w + 2 <= num_words; w += 2) {
+    const v128_t diff = wasm_v128_xor(wasm_v128_load(a + w), wasm_v128_load(b + w));
+    const v128_t byte_counts = wasm_i8x16_popcnt(diff);
+    totals = wasm_i32x4_add(totals, wasm_u32x4_extadd_pairwise_u16x8(wasm_u16x8_extadd_pairwise_u8x16(byte_counts)));
+  }
+  count = (size_t)wasm_u32x4_extract_lane(totals, 0) + (size_t)wasm_u32x4_extract_lane(totals, 1)
+        + (size_t)wasm_u32x4_extract_lane(totals, 2) + (size_t)wasm_u32x4_extract_lane(totals, 3);
+#endif
+  for (; w < num_words; ++w) count += (size_t)std::popcount(a[w] ^ b[w]);
+  return count;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef AAGOS_PARSING_HPP
+#define AAGOS_PARSING_HPP
+
+#include "emp/bits/Bits.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace aagos {
+
+/// Streaming, allocation-free helpers for parsing Aagos input files (environments, ancestors).
+namespace parsing {
+
+/// Read-only view of a file's contents. Natively, the file is memory-mapped; under Emscripten it is
+/// read into a buffer.
+class MappedFile {
+protected:
+  const char * data=nullptr;
+  size_t size=0;
+  bool mapped=false;
+  std::string buffer;   ///< Backing storage when the file is not memory-mapped.
+  std::string error;
+
+public:
+  MappedFile(const std::string & path) {
+#ifndef __EMSCRIPTEN__
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { error = "Failed to open file (" + path + ")."; return; }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      error = "Failed to stat file (" + path + ").";
+      close(fd);
+      return;
+    }
+    size = (size_t)info.st_size;
+    if (size > 0) {
+      void * addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        error = "Failed to map file (" + path + ").";
+        size = 0;
+        close(fd);
+        return;
+      }
+      madvise(addr, size, MADV_SEQUENTIAL);
+      data = (const char *)addr;
+      mapped = true;
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) { error = "Failed to open file (" + path + ")."; return; }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+#ifndef __EMSCRIPTEN__
+    if (mapped) munmap((void *)data, size);
+#endif
+  }
+
+  bool IsOpen() const { return error.empty(); }
+  const std::string & GetError() const { return error; }
+  const char * begin() const { return data; }
+  const char * end() const { return data + size; }
+  size_t GetSize() const { return size; }
+};
+
+/// Cursor over a character range that tracks the current line number (for error messages).
+class Cursor {
+protected:
+  const char * cur;
+  const char * stop;
+  size_t line=1;
+
+public:
+  Cursor(const char * _begin, const char * _end) : cur(_begin), stop(_end) { ; }
+  Cursor(const MappedFile & file) : cur(file.begin()), stop(file.end()) { ; }
+
+  bool AtEnd() const { return cur >= stop; }
+  bool AtLineEnd() const { return AtEnd() || *cur == '\n'; }
+  char Peek() const { return AtEnd() ? '\0' : *cur; }
+  size_t GetLine() const { return line; }
+  const char * GetPos() const { return cur; }
+
+  /// Skip spaces and tabs (and carriage returns), but not newlines.
+  void SkipSpaces() {
+    while (cur < stop && (*cur == ' ' || *cur == '\t' || *cur == '\r')) ++cur;
+  }
+
+  /// Skip all whitespace, including newlines.
+  void SkipWhitespace() {
+    while (cur < stop && (*cur == ' ' || *cur == '\t' || *cur == '\r' || *cur == '\n')) {
+      if (*cur == '\n') ++line;
+      ++cur;
+    }
+  }
+
+  /// Advance to the start of the next line.
+  void SkipLine() {
+    while (cur < stop && *cur != '\n') ++cur;
+    if (cur < stop) { ++cur; ++line; }
+  }
+
+  /// Advance to the first character of the next line that is not blank and not a '#' comment.
+  /// Returns false if no such line exists.
+  bool NextContentLine() {
+    while (true) {
+      SkipWhitespace();
+      if (AtEnd()) return false;
+      if (*cur == '#') { SkipLine(); continue; }
+      return true;
+    }
+  }
+
+  /// Advance to the first non-blank character of the next line that starts with c (ignoring leading
+  /// spaces), skipping any other lines. Returns false if no such line exists.
+  bool NextLineStartingWith(char c) {
+    while (NextContentLine()) {
+      SkipSpaces();
+      if (Peek() == c) return true;
+      SkipLine();
+    }
+    return false;
+  }
+
+  /// Advance to the next occurrence of c on the current line (or to the end of the line).
+  void SkipToOnLine(char c) {
+    while (cur < stop && *cur != c && *cur != '\n') ++cur;
+  }
+
+  /// If the next character is c, consume it and return true.
+  bool Consume(char c) {
+    if (cur < stop && *cur == c) { ++cur; return true; }
+    return false;
+  }
+
+  bool ParseDouble(double & value) {
+#ifdef __EMSCRIPTEN__
+    // Older emscripten libc++ has no floating-point from_chars; parse a bounded copy with strtod
+    // (rejecting what from_chars would: leading whitespace or '+', and out-of-range values).
+    char buffer[64];
+    const size_t len = std::min<size_t>((size_t)(stop - cur), sizeof(buffer) - 1);
+    if (!len || std::isspace((unsigned char)*cur) || *cur == '+') return false;
+    std::memcpy(buffer, cur, len);
+    buffer[len] = '\0';
+    char * end = nullptr;
+    errno = 0;
+    value = std::strtod(buffer, &end);
+    if (end == buffer || errno == ERANGE) return false;
+    cur += end - buffer;
+    return true;
+#else
+    auto result = std::from_chars(cur, stop, value);
+    if (result.ec != std::errc()) return false;
+    cur = result.ptr;
+    return true;
+#endif
+  }
+
+  bool ParseSize(size_t & value) {
+    auto result = std::from_chars(cur, stop, value);
+    if (result.ec != std::errc()) return false;
+    cur = result.ptr;
+    return true;
+  }
+
+  /// Length of the run of '0'/'1' characters starting at the cursor.
+  size_t BitRunLength() const {
+    const char * pos = cur;
+    while (pos < stop && (*pos == '0' || *pos == '1')) ++pos;
+    return (size_t)(pos - cur);
+  }
+
+  /// Parse a run of '0'/'1' characters into bits (resized to match). As with emp::to_string, the
+  /// first character is the highest-order bit.
+  /// Returns the number of characters consumed (0 => no bitstring at cursor).
+  size_t ParseBits(emp::BitVector & bits) {
+    const size_t len = BitRunLength();
+    bits.Resize(len);
+    if (!len) return 0;
+    // Character i holds bit (len - i - 1), so bit b is found at cur[len - b - 1].
+    const char * last = cur + len - 1;
+    const size_t num_words = len / 64;
+    for (size_t w = 0; w < num_words; ++w) {
+      uint64_t word = 0;
+      const char * src = last - (w * 64);
+      for (size_t j = 0; j < 64; ++j) {
+        word |= (uint64_t)(*(src - j) == '1') << j;
+      }
+      bits.SetUInt64(w, word);
+    }
+    for (size_t b = num_words * 64; b < len; ++b) {
+      bits.Set(b, *(last - b) == '1');
+    }
+    cur += len;
+    return len;
+  }
+};
+
+/// Parse str (e.g., a command-line argument) as a non-negative integer. Returns false unless the whole
+/// string is a valid number.
+inline bool ParseSize(const std::string & str, size_t & value) {
+  const char * stop = str.data() + str.size();
+  auto result = std::from_chars(str.data(), stop, value);
+  return str.size() && result.ec == std::errc() && result.ptr == stop;
+}
+
+/// Format a parse error message of the form "path:line: message".
+inline std::string FormatError(const std::string & path, size_t line, const std::string & msg) {
+  return path + ":" + std::to_string(line) + ": " + msg;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef AAGOS_PHASE_TIMER_HPP
+#define AAGOS_PHASE_TIMER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+// Phase timing is compiled out unless AAGOS_TIMING is defined (e.g., make timing).
+#define AAGOS_TIMER_CONCAT_IMPL(a, b) a##b
+#define AAGOS_TIMER_CONCAT(a, b) AAGOS_TIMER_CONCAT_IMPL(a, b)
+
+#ifdef AAGOS_TIMING
+  /// Charge the remainder of the enclosing scope to the given phase of the given timer.
+  #define AAGOS_TIME_PHASE(timer, phase) \
+    aagos::AagosPhaseTimer::Scope AAGOS_TIMER_CONCAT(aagos_phase_scope_, __LINE__)((timer), aagos::AagosPhaseTimer::PHASE::phase)
+#else
+  #define AAGOS_TIME_PHASE(timer, phase)
+#endif
+
+namespace aagos {
+
+/// Accumulates wall-clock time spent in each phase of a generation.
+/// Phases nest: entering a phase pauses whichever phase was active, so time is only ever charged
+/// to the innermost phase (e.g., time spent mutating offspring is not also charged to birth).
+class AagosPhaseTimer {
+public:
+  enum class PHASE {
+    EVALUATION=0,
+    BIRTH,
+    MUTATION,
+    SYSTEMATICS,
+    STATS,
+    OUTPUT,
+    ENV_CHANGE,
+    NUM_PHASES
+  };
+
+  static constexpr size_t NUM_PHASES = (size_t)PHASE::NUM_PHASES;
+
+  /// RAII helper: charges time to a phase for the lifetime of the scope.
+  class Scope {
+  protected:
+    AagosPhaseTimer & timer;
+    PHASE prev_phase;
+  public:
+    Scope(AagosPhaseTimer & t, PHASE phase) : timer(t), prev_phase(t.Enter(phase)) { ; }
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+    ~Scope() { timer.Exit(prev_phase); }
+  };
+
+protected:
+  using clock_t = std::chrono::steady_clock;
+
+  std::array<clock_t::duration, NUM_PHASES> totals;
+  PHASE active=PHASE::NUM_PHASES;   ///< Phase currently being charged (NUM_PHASES => none).
+  clock_t::time_point last_mark;
+
+  /// Charge time elapsed since the last mark to the active phase.
+  void Charge(const clock_t::time_point & now) {
+    if (active != PHASE::NUM_PHASES) totals[(size_t)active] += now - last_mark;
+    last_mark = now;
+  }
+
+public:
+  AagosPhaseTimer() { Reset(); }
+
+  /// Start charging time to phase. Returns the previously active phase.
+  PHASE Enter(PHASE phase) {
+    Charge(clock_t::now());
+    const PHASE prev = active;
+    active = phase;
+    return prev;
+  }
+
+  /// Stop charging time to the active phase, resume charging prev_phase.
+  void Exit(PHASE prev_phase) {
+    Charge(clock_t::now());
+    active = prev_phase;
+  }
+
+  void Reset() {
+    totals.fill(clock_t::duration::zero());
+    active = PHASE::NUM_PHASES;
+    last_mark = clock_t::now();
+  }
+
+  /// Cumulative seconds charged to phase.
+  double GetSeconds(PHASE phase) const {
+    return std::chrono::duration<double>(totals[(size_t)phase]).count();
+  }
+
+  /// Cumulative seconds charged to all phases.
+  double GetTotalSeconds() const {
+    double total = 0.0;
+    for (size_t i = 0; i < NUM_PHASES; ++i) total += GetSeconds((PHASE)i);
+    return total;
+  }
+
+  static const char * GetName(PHASE phase) {
+    switch (phase) {
+      case PHASE::EVALUATION: return "evaluation";
+      case PHASE::BIRTH: return "birth";
+      case PHASE::MUTATION: return "mutation";
+      case PHASE::SYSTEMATICS: return "systematics";
+      case PHASE::STATS: return "stats";
+      case PHASE::OUTPUT: return "output";
+      case PHASE::ENV_CHANGE: return "env_change";
+      default: return "unknown";
+    }
+  }
+
+  /// Print a one-line summary of cumulative time per phase.
+  void Print(std::ostream & out=std::cout) const {
+    out << "timing (s):";
+    for (size_t i = 0; i < NUM_PHASES; ++i) {
+      out << " " << GetName((PHASE)i) << "=" << GetSeconds((PHASE)i);
+    }
+    out << " total=" << GetTotalSeconds();
+  }
+};
+
+}
+
+#endif
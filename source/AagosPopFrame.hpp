@@ -0,0 +1,321 @@
+#ifndef AAGOS_POP_FRAME_HPP
+#define AAGOS_POP_FRAME_HPP
+
+#include "AagosWorld.hpp"
+
+#include "emp/base/vector.hpp"
+#include "emp/bits/Bits.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace aagos {
+
+/// Compact description of everything the web interface draws for a single generation.
+/// Frames are captured from a world, and can be serialized to a flat byte buffer so that a world
+/// stepping in a Web Worker can hand them to the UI thread.
+///
+/// A frame can be serialized as a delta against a base frame that the receiver already holds: each
+/// organism identical to one in the base (e.g., an unmutated offspring) is sent as that organism's
+/// index. Frames in a sequence carry a frame_id, and a delta frame only loads into a frame whose
+/// frame_id matches its base (Deserialize sets missing_base otherwise; ask for a full frame).
+struct AagosPopFrame {
+  struct Org {
+    size_t org_id=0;
+    bool evaluated=false;
+    double fitness=0.0;
+    size_t coding_sites=0;
+    size_t neutral_sites=0;
+    emp::vector<size_t> gene_starts;
+    emp::vector<double> gene_fitness_contributions;
+    emp::BitVector bits;
+
+    /// Same genome and phenotype (wherever in the population)?
+    bool Matches(const Org & other) const {
+      return evaluated == other.evaluated && fitness == other.fitness
+             && coding_sites == other.coding_sites && neutral_sites == other.neutral_sites
+             && gene_starts == other.gene_starts && bits == other.bits
+             && gene_fitness_contributions == other.gene_fitness_contributions;
+    }
+
+    /// Hash of the organism's genome (for matching organisms against a base frame).
+    uint64_t GetGenomeHash() const {
+      uint64_t hash = UINT64_C(0xcbf29ce484222325) ^ (uint64_t)bits.GetSize();
+      auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * UINT64_C(0x100000001b3); hash ^= hash >> 29; };
+      for (size_t w = 0; w < (bits.GetSize() + 63) / 64; ++w) mix(bits.GetUInt64(w));
+      for (size_t start : gene_starts) mix((uint64_t)start);
+      return hash;
+    }
+  };
+
+  /// Organism entries in a serialized frame.
+  enum class ORG_ENTRY : uint8_t { FULL=0, BASE=1 };
+
+  size_t frame_id=0;          ///< Position in a frame sequence (0 => not part of one; e.g., captured locally).
+  bool missing_base=false;    ///< Did the last Deserialize fail because this frame isn't the delta's base?
+  size_t update=0;
+  size_t evo_phase=0;
+  size_t pop_size=0;
+  size_t num_genes=0;
+  size_t gene_size=0;
+  size_t most_fit_id=0;
+  size_t max_genome_size=0;   ///< Largest genome among orgs in this frame.
+  bool full_pop=false;        ///< Does orgs hold the full population (or just the most fit organism)?
+  bool has_env=false;         ///< Does gradient_env hold the environment? (Only sent when it changes.)
+  bool finished=false;        ///< Has the run finished (all phases complete)?
+  bool draw=true;             ///< Should the population be redrawn? (False if only the statistics are new.)
+  bool has_summary=false;     ///< Does summary hold population-wide per-position aggregates?
+
+  // Population-wide statistics.
+  double mean_fitness=0.0;
+  double mean_coding_sites=0.0;
+  double mean_neutral_sites=0.0;
+  double mean_genome_length=0.0;
+
+  emp::vector<Org> orgs;
+  emp::vector<emp::BitVector> gradient_env;   ///< Gene targets (gradient model only).
+
+  /// Per-position population aggregates (if has_summary) over summary_positions (MAX_SIZE) genome
+  /// positions, packed as: gene occupancy counts (summary_positions x num_genes, position-major),
+  /// number of orgs with a 1 at each position (summary_positions), and the genome length histogram
+  /// (summary_positions + 1). Its size does not depend on the population size.
+  size_t summary_positions=0;
+  emp::vector<uint32_t> summary;
+
+  size_t GetSummaryOccupancyOffset() const { return 0; }
+  size_t GetSummaryOnesOffset() const { return summary_positions * num_genes; }
+  size_t GetSummaryLengthsOffset() const { return summary_positions * (num_genes + 1); }
+
+  /// Most fit organism in this frame.
+  const Org & GetMostFitOrg() const {
+    emp_assert(orgs.size());
+    if (!full_pop) return orgs[0];
+    return orgs[most_fit_id];
+  }
+
+  /// Capture the current state of world. If full_pop is false, only the most fit organism is
+  /// recorded. The environment is recorded if include_env is true (gradient model only), and the
+  /// population summary if include_summary is true.
+  void Capture(AagosWorld & world, bool full_pop_, bool include_env, bool include_summary=false) {
+    using org_t = AagosWorld::org_t;
+    world.EvaluatePopulation(); // Drift mode may not have evaluated this generation yet.
+    frame_id = 0;
+    const auto & config = world.GetConfig();
+    update = world.GetUpdate();
+    evo_phase = world.GetPhase();
+    pop_size = world.GetSize();
+    num_genes = config.NUM_GENES();
+    gene_size = config.GENE_SIZE();
+    most_fit_id = world.GetMostFitID();
+    full_pop = full_pop_;
+    has_env = include_env && config.GRADIENT_MODEL();
+    finished = false;
+    draw = true;
+    has_summary = include_summary;
+    summary_positions = include_summary ? config.MAX_SIZE() : 0;
+    summary.assign(include_summary ? summary_positions * (num_genes + 2) + 1 : 0, 0);
+    uint32_t * occupancy_counts = summary.data() + GetSummaryOccupancyOffset();
+    uint32_t * one_counts = summary.data() + GetSummaryOnesOffset();
+    uint32_t * length_counts = summary.data() + GetSummaryLengthsOffset();
+
+    orgs.resize(full_pop ? pop_size : (pop_size ? 1 : 0));
+    max_genome_size = 0;
+    double total_fitness = 0.0, total_coding = 0.0, total_neutral = 0.0, total_length = 0.0;
+    for (size_t org_id = 0; org_id < pop_size; ++org_id) {
+      org_t & org = world.GetOrg(org_id);
+      const auto & phen = org.GetPhenotype();
+      const auto & occupancy = org.GetGeneOccupancyHistogram().GetHistCounts();
+      const size_t neutral = occupancy[0];
+      const size_t coding = org.GetNumBits() - neutral;
+      total_fitness += phen.fitness;
+      total_coding += (double)coding;
+      total_neutral += (double)neutral;
+      total_length += (double)org.GetNumBits();
+      if (include_summary) {
+        // Genomes longer than MAX_SIZE (e.g., loaded ancestors) are only summarized up to MAX_SIZE.
+        const auto & bits = org.GetBits();
+        const auto & gene_starts = org.GetGeneStarts();
+        const size_t num_bits = org.GetNumBits();
+        const size_t summarized_bits = emp::Min(num_bits, summary_positions);
+        const size_t gene_sites = emp::Min(gene_size, num_bits);
+        ++length_counts[summarized_bits];
+        for (size_t pos = 0; pos < summarized_bits; ++pos) one_counts[pos] += (uint32_t)bits.Get(pos);
+        for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
+          for (size_t k = 0; k < gene_sites; ++k) {
+            const size_t pos = (gene_starts[gene_id] + k) % num_bits;
+            if (pos < summarized_bits) ++occupancy_counts[pos * num_genes + gene_id];
+          }
+        }
+      }
+      if (!full_pop && org_id != most_fit_id) continue;
+      Org & frame_org = orgs[full_pop ? org_id : 0];
+      frame_org.org_id = org_id;
+      frame_org.evaluated = phen.IsEvaluated();
+      frame_org.fitness = phen.fitness;
+      frame_org.coding_sites = coding;
+      frame_org.neutral_sites = neutral;
+      frame_org.gene_starts = org.GetGeneStarts();
+      frame_org.gene_fitness_contributions = phen.gene_fitness_contributions;
+      frame_org.bits = org.GetBits();
+      max_genome_size = emp::Max(max_genome_size, org.GetNumBits());
+    }
+    const double denom = pop_size ? (double)pop_size : 1.0;
+    mean_fitness = total_fitness / denom;
+    mean_coding_sites = total_coding / denom;
+    mean_neutral_sites = total_neutral / denom;
+    mean_genome_length = total_length / denom;
+
+    if (has_env) gradient_env = world.GetGradientFitnessModel().targets;
+    else gradient_env.clear();
+  }
+
+  /// Serialize frame into buffer (replacing its contents). If base is given (a frame in the same
+  /// sequence that the receiver holds), organisms found in base are sent by reference.
+  void Serialize(emp::vector<unsigned char> & buffer, const AagosPopFrame * base=nullptr) const {
+    emp_assert(base == nullptr || (frame_id && base->frame_id));
+    buffer.clear();
+    auto put = [&buffer](auto value) {
+      static_assert(std::is_trivially_copyable<decltype(value)>::value, "Can only put trivially copyable values.");
+      const size_t pos = buffer.size();
+      buffer.resize(pos + sizeof(value));
+      std::memcpy(buffer.data() + pos, &value, sizeof(value));
+    };
+    auto put_bits = [&put](const emp::BitVector & bits) {
+      put((uint64_t)bits.GetSize());
+      for (size_t w = 0; w < (bits.GetSize() + 63) / 64; ++w) {
+        uint64_t word = 0;
+        const size_t word_bits = emp::Min<size_t>(64, bits.GetSize() - w * 64);
+        for (size_t b = 0; b < word_bits; ++b) word |= (uint64_t)bits.Get(w * 64 + b) << b;
+        put(word);
+      }
+    };
+    put((uint64_t)frame_id); put((uint64_t)(base ? base->frame_id : 0));
+    put((uint64_t)update); put((uint64_t)evo_phase); put((uint64_t)pop_size);
+    put((uint64_t)num_genes); put((uint64_t)gene_size); put((uint64_t)most_fit_id);
+    put((uint64_t)max_genome_size);
+    put((uint8_t)full_pop); put((uint8_t)has_env); put((uint8_t)finished); put((uint8_t)draw);
+    put((uint8_t)has_summary);
+    put(mean_fitness); put(mean_coding_sites); put(mean_neutral_sites); put(mean_genome_length);
+    put((uint64_t)orgs.size());
+    std::unordered_multimap<uint64_t, size_t> base_orgs;
+    if (base) {
+      base_orgs.reserve(base->orgs.size());
+      for (size_t i = 0; i < base->orgs.size(); ++i) base_orgs.emplace(base->orgs[i].GetGenomeHash(), i);
+    }
+    for (const Org & org : orgs) {
+      if (base) {
+        auto range = base_orgs.equal_range(org.GetGenomeHash());
+        auto match = std::find_if(range.first, range.second, [&](const auto & entry) { return base->orgs[entry.second].Matches(org); });
+        if (match != range.second) {
+          put((uint8_t)ORG_ENTRY::BASE); put((uint64_t)org.org_id); put((uint64_t)match->second);
+          continue;
+        }
+      }
+      put((uint8_t)ORG_ENTRY::FULL);
+      put((uint64_t)org.org_id); put((uint8_t)org.evaluated); put(org.fitness);
+      put((uint64_t)org.coding_sites); put((uint64_t)org.neutral_sites);
+      for (size_t g = 0; g < num_genes; ++g) put((uint64_t)org.gene_starts[g]);
+      for (size_t g = 0; g < num_genes; ++g) put(org.gene_fitness_contributions[g]);
+      put_bits(org.bits);
+    }
+    if (has_env) {
+      for (size_t g = 0; g < num_genes; ++g) put_bits(gradient_env[g]);
+    }
+    if (has_summary) {
+      put((uint64_t)summary_positions);
+      for (uint32_t count : summary) put(count);
+    }
+  }
+
+  /// Load frame from a buffer produced by Serialize. Returns false if the buffer is malformed, or
+  /// (leaving the frame untouched, with missing_base set) if it's a delta against a frame other than
+  /// this one.
+  bool Deserialize(const unsigned char * data, size_t size) {
+    size_t pos = 0;
+    bool ok = true;
+    missing_base = false;
+    auto get = [&](auto & value) {
+      if (pos + sizeof(value) > size) { ok = false; return; }
+      std::memcpy(&value, data + pos, sizeof(value));
+      pos += sizeof(value);
+    };
+    auto get_size = [&]() { uint64_t value = 0; get(value); return (size_t)value; };
+    auto get_flag = [&]() { uint8_t value = 0; get(value); return value != 0; };
+    auto get_bits = [&](emp::BitVector & bits) {
+      const size_t num_bits = get_size();
+      if (!ok || pos + ((num_bits + 63) / 64) * sizeof(uint64_t) > size) { ok = false; return; }
+      bits.Resize(num_bits);
+      for (size_t w = 0; w < (num_bits + 63) / 64; ++w) {
+        uint64_t word = 0;
+        get(word);
+        const size_t word_bits = emp::Min<size_t>(64, num_bits - w * 64);
+        for (size_t b = 0; b < word_bits; ++b) bits.Set(w * 64 + b, (word >> b) & 1);
+      }
+    };
+    const size_t new_frame_id = get_size();
+    const size_t base_id = get_size();
+    if (!ok) return false;
+    if (base_id && base_id != frame_id) {
+      missing_base = true;
+      return false;
+    }
+    frame_id = 0; // Until this frame has loaded.
+    update = get_size(); evo_phase = get_size(); pop_size = get_size();
+    num_genes = get_size(); gene_size = get_size(); most_fit_id = get_size();
+    max_genome_size = get_size();
+    full_pop = get_flag(); has_env = get_flag(); finished = get_flag(); draw = get_flag();
+    has_summary = get_flag();
+    get(mean_fitness); get(mean_coding_sites); get(mean_neutral_sites); get(mean_genome_length);
+    const size_t num_orgs = get_size();
+    if (!ok || num_orgs > size) return false; // Guard against garbage sizes.
+    emp::vector<Org> base_orgs;
+    if (base_id) std::swap(base_orgs, orgs);
+    orgs.resize(num_orgs);
+    for (Org & org : orgs) {
+      uint8_t entry = 0;
+      get(entry);
+      if (entry == (uint8_t)ORG_ENTRY::BASE) {
+        const size_t org_id = get_size();
+        const size_t base_index = get_size();
+        if (!ok || !base_id || base_index >= base_orgs.size()) return false;
+        org = base_orgs[base_index];
+        org.org_id = org_id;
+        continue;
+      }
+      if (entry != (uint8_t)ORG_ENTRY::FULL) return false;
+      org.org_id = get_size(); org.evaluated = get_flag(); get(org.fitness);
+      org.coding_sites = get_size(); org.neutral_sites = get_size();
+      org.gene_starts.resize(num_genes);
+      org.gene_fitness_contributions.resize(num_genes);
+      for (size_t g = 0; g < num_genes; ++g) org.gene_starts[g] = get_size();
+      for (size_t g = 0; g < num_genes; ++g) get(org.gene_fitness_contributions[g]);
+      get_bits(org.bits);
+      if (!ok) return false;
+    }
+    gradient_env.clear();
+    if (has_env) {
+      gradient_env.resize(num_genes);
+      for (auto & target : gradient_env) get_bits(target);
+    }
+    summary_positions = 0;
+    summary.clear();
+    if (has_summary) {
+      summary_positions = get_size();
+      const size_t summary_size = summary_positions * (num_genes + 2) + 1;
+      if (!ok || pos + summary_size * sizeof(uint32_t) > size) return false;
+      summary.resize(summary_size);
+      for (uint32_t & count : summary) get(count);
+    }
+    if (!ok || pos != size) return false;
+    frame_id = new_frame_id;
+    return true;
+  }
+};
+
+}
+
+#endif
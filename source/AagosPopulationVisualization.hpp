@@ -1,22 +1,21 @@
 #ifndef AAGOS_WEB_POP_VIS_H
 #define AAGOS_WEB_POP_VIS_H
 
-#include "AagosWorld.hpp"
-#include "AagosConfig.hpp"
-#include "AagosOrg.hpp"
+#include "AagosPopFrame.hpp"
 
+#include "emp/base/vector.hpp"
 #include "emp/web/web.hpp"
 
+#include <cstdint>
+
 namespace UI = emp::web;
 
-// NOTE - tooltip functionality is currently **really** gross because of the way the world updates
 // NOTE - at the moment, this will explode if multiple instances of this object exist at once
 class AagosPopulationVisualization  {
 public:
-  using world_t = AagosWorld;
-  using org_t = typename AagosWorld::org_t;
+  using frame_t = aagos::AagosPopFrame;
 
-  enum class POP_DRAW_MODE { FULL_POP=0, MAX_FIT };
+  enum class POP_DRAW_MODE { FULL_POP=0, MAX_FIT, SUMMARY };
 
 protected:
 
@@ -36,7 +35,21 @@ protected:
   POP_DRAW_MODE draw_mode=POP_DRAW_MODE::MAX_FIT;
   // POP_DRAW_MODE draw_mode=POP_DRAW_MODE::FULL_POP;
 
-  void InitializeVariables(world_t & world) {
+  // Packed population/environment data. Javascript reads these in place (as typed array views over
+  // the wasm heap), so they must not be modified between an Update*Data call and the next draw.
+  static constexpr size_t ORG_FIELDS=4;       // org_id, num_bits, is_evaluated, offset into pop_words
+  static constexpr size_t INDICATOR_FIELDS=3; // position, rank, number of occupants
+  emp::vector<uint32_t> pop_orgs;
+  emp::vector<uint32_t> pop_words;            // Genomes, 32 bits per word.
+  emp::vector<uint32_t> pop_gene_starts;      // num_genes per org
+  emp::vector<double> pop_contributions;      // num_genes per org
+  emp::vector<uint32_t> pop_indicators;       // num_genes * gene_size per org
+  emp::vector<uint32_t> env_words;            // Gene targets, (gene_size + 31) / 32 words per target.
+  emp::vector<uint32_t> summary_counts;       // Population summary (see AagosPopFrame::summary).
+  emp::vector<size_t> occupant_counts;        // Scratch space for computing gene indicators.
+  emp::vector<size_t> last_occupant;
+
+  void InitializeVariables(size_t num_genes) {
     // jswrap whatever it is that we need to jswrap
 
     // Initialize javascript object aagos_pop_vis
@@ -46,12 +59,13 @@ protected:
       emp.AagosPopVis[elem_id] = {};
     }, element_id.c_str());
     // Initialize population data.
-    InitializeGeneColorScale(world);
+    InitializeGeneColorScale(num_genes);
     InitializePopData();
     InitializeGradientEnvData();
+    InitializeSummaryData();
   }
 
-  void InitializeGeneColorScale(world_t & world) {
+  void InitializeGeneColorScale(size_t num_genes) {
     EM_ASM({
       const elem_id = UTF8ToString($0);
       const num_genes = $1;
@@ -59,286 +73,198 @@ protected:
       emp.AagosPopVis[elem_id]["gene_color_scale"] = d3.scaleSequential(d3.interpolateRainbow).domain([0, num_genes]);
       // emp.AagosPopVis[elem_id]["gene_color_scale"] = d3.scaleOrdinal().domain([0, num_genes]).range(d3["schemeAccent"]);
     }, element_id.c_str(),
-       world.GetConfig().NUM_GENES());
+       num_genes);
   }
 
   void InitializePopData() {
     EM_ASM({
       var elem_id = UTF8ToString($0);
-      emp.AagosPopVis[elem_id]["pop"] = [];
-      emp.AagosPopVis[elem_id]["max_genome_size"] = 0;
-      emp.AagosPopVis[elem_id]["most_fit_id"] = 0;
-    }, element_id.c_str());
+      var vis_info = emp.AagosPopVis[elem_id];
+      vis_info["pop_data"] = {"num_orgs": 0, "num_genes": 0, "gene_size": 0,
+                              "orgs_ptr": 0, "words_ptr": 0, "words_len": 0,
+                              "gene_starts_ptr": 0, "contributions_ptr": 0, "indicators_ptr": 0};
+      vis_info["max_genome_size"] = 0;
+      vis_info["most_fit_id"] = 0;
+      // Typed array views over the packed population data in the wasm heap. Views are rebuilt on
+      // each call because growing wasm memory detaches any views that already exist.
+      vis_info["GetPopViews"] = function() {
+        const data = vis_info["pop_data"];
+        const num_genes = data["num_genes"];
+        const num_indicators = data["num_orgs"] * num_genes * data["gene_size"];
+        const u32_view = function(ptr, len) { return HEAPU32.subarray(ptr >> 2, (ptr >> 2) + len); };
+        return {"orgs": u32_view(data["orgs_ptr"], data["num_orgs"] * $1),
+                "words": u32_view(data["words_ptr"], data["words_len"]),
+                "gene_starts": u32_view(data["gene_starts_ptr"], data["num_orgs"] * num_genes),
+                "contributions": HEAPF64.subarray(data["contributions_ptr"] >> 3, (data["contributions_ptr"] >> 3) + data["num_orgs"] * num_genes),
+                "indicators": u32_view(data["indicators_ptr"], num_indicators * $2)};
+      };
+    }, element_id.c_str(), ORG_FIELDS, INDICATOR_FIELDS);
   }
 
   void InitializeGradientEnvData() {
     EM_ASM({
       var elem_id = UTF8ToString($0);
-      emp.AagosPopVis[elem_id]["gradient_env"] = [];
-      emp.AagosPopVis[elem_id]["num_gene_targets"] = 0;
-      emp.AagosPopVis[elem_id]["gene_target_size"] = 0;
+      var vis_info = emp.AagosPopVis[elem_id];
+      vis_info["env_data"] = {"words_ptr": 0, "words_per_target": 0};
+      vis_info["num_gene_targets"] = 0;
+      vis_info["gene_target_size"] = 0;
+      vis_info["GetEnvWords"] = function() {
+        const data = vis_info["env_data"];
+        const len = vis_info["num_gene_targets"] * data["words_per_target"];
+        return HEAPU32.subarray(data["words_ptr"] >> 2, (data["words_ptr"] >> 2) + len);
+      };
     }, element_id.c_str());
   }
 
-  void UpdatePopDataFull(world_t & world) {
-    if (!init || !world.IsSetup()) return;
-
-    // info to update: bits, gene starts, num genes, gene size, num_bits
+  void InitializeSummaryData() {
     EM_ASM({
-      const elem_id = UTF8ToString($0);
-      // Clear population information.
-      emp.AagosPopVis[elem_id]['pop'] = [];
-      emp.AagosPopVis[elem_id]['max_genome_size'] = 0;
-      emp.AagosPopVis[elem_id]['most_fit_id'] = 0;
-
+      var elem_id = UTF8ToString($0);
+      var vis_info = emp.AagosPopVis[elem_id];
+      vis_info["summary_data"] = {"counts_ptr": 0, "positions": 0, "num_genes": 0, "pop_size": 0};
+      vis_info["summary_layout"] = null;
+      vis_info["GetSummaryCounts"] = function() {
+        const data = vis_info["summary_data"];
+        const len = data["positions"] * (data["num_genes"] + 2) + 1;
+        return HEAPU32.subarray(data["counts_ptr"] >> 2, (data["counts_ptr"] >> 2) + len);
+      };
     }, element_id.c_str());
+  }
+
+  /// Append bits to words, 32 bits per word (bit i is bit i%32 of word i/32).
+  static void PackBits(const emp::BitVector & bits, emp::vector<uint32_t> & words) {
+    const size_t num_bits = bits.GetSize();
+    const size_t full_words = num_bits / 32;
+    for (size_t w = 0; w < full_words; ++w) words.emplace_back(bits.GetUInt32(w));
+    if (num_bits % 32) {
+      uint32_t word = 0;
+      for (size_t b = full_words * 32; b < num_bits; ++b) word |= (uint32_t)bits.Get(b) << (b % 32);
+      words.emplace_back(word);
+    }
+  }
 
+  /// Pack population data from frame into the typed array buffers and point javascript at them.
+  /// In max fit draw mode, only the most fit organism is packed (regardless of whether the frame
+  /// holds the full population).
+  void UpdatePopData(const frame_t & frame) {
+    if (!init || !frame.orgs.size()) return;
+
+    const bool max_fit_only = (draw_mode == POP_DRAW_MODE::MAX_FIT);
+    const size_t num_genes = frame.num_genes;
+    const size_t gene_size = frame.gene_size;
+    pop_orgs.clear();
+    pop_words.clear();
+    pop_gene_starts.clear();
+    pop_contributions.clear();
+    pop_indicators.clear();
+    size_t num_orgs = 0;
     size_t max_genome_size = 0;
-    for (size_t org_id = 0; org_id < world.GetSize(); ++org_id) {
-      org_t & org = world.GetOrg(org_id);
-      const size_t num_bits = org.GetNumBits();
-      const size_t gene_size = org.GetGeneSize();
-      const bool is_evaluated = org.GetPhenotype().IsEvaluated();
+    for (const auto & org : frame.orgs) {
+      if (max_fit_only && org.org_id != frame.most_fit_id) continue;
+      ++num_orgs;
+      const size_t num_bits = org.bits.GetSize();
       max_genome_size = num_bits > max_genome_size ? num_bits : max_genome_size;
-      auto & gene_starts = org.GetGeneStarts();
-      std::ostringstream stream;
-      stream << org.GetBits();
-      const std::string bits(stream.str());
-      stream.str(std::string());
-      for (size_t gene_id = 0; gene_id < gene_starts.size(); ++gene_id) {
-        if (gene_id) stream << ",";
-        stream << gene_starts[gene_id];
+      pop_orgs.emplace_back((uint32_t)org.org_id);
+      pop_orgs.emplace_back((uint32_t)num_bits);
+      pop_orgs.emplace_back((uint32_t)org.evaluated);
+      pop_orgs.emplace_back((uint32_t)pop_words.size());
+      PackBits(org.bits, pop_words);
+      for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
+        pop_gene_starts.emplace_back((uint32_t)org.gene_starts[gene_id]);
+        // Gene fitness contributions are only meaningful if the organism has been evaluated.
+        pop_contributions.emplace_back(org.evaluated ? org.gene_fitness_contributions[gene_id] : 0.0);
       }
-      const std::string gene_starts_str(stream.str());
-      EM_ASM({
-        const elem_id = UTF8ToString($0);
-        const org_id = $1;
-        const bits = UTF8ToString($2).split('').map(Number).reverse();
-        const gene_starts = UTF8ToString($3).split(',').map(Number);
-        const gene_size = $4;
-        const is_evaluated = $5;
-        const num_bits = bits.length;
-        var gene_occupancy = new Map();
-        var position_occupants = new Map();
-        var gene_indicators = [];
-        for (let gene_id = 0; gene_id < gene_starts.length; gene_id++) {
-          gene_occupancy.set(gene_id, []);
-          var start = gene_starts[gene_id];
-          for (let k = 0; k < gene_size; k++) {
-            const position = (start + k) % num_bits;
-            gene_occupancy.get(gene_id).push(position);
-            if (!(position_occupants.has(position))) {
-              position_occupants.set(position, new Set());
+      // Gene indicators: for each site of each gene, the genome position it occupies, its rank
+      // among the genes occupying that position, and the number of genes occupying that position.
+      const size_t first_indicator = pop_indicators.size();
+      occupant_counts.assign(num_bits, 0);
+      last_occupant.assign(num_bits, 0);
+      for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
+        for (size_t k = 0; k < gene_size; ++k) {
+          const size_t pos = num_bits ? (org.gene_starts[gene_id] + k) % num_bits : 0;
+          size_t rank = 0;
+          if (num_bits) {
+            // A gene that wraps around the genome only counts once at each position.
+            if (last_occupant[pos] != gene_id + 1) {
+              last_occupant[pos] = gene_id + 1;
+              ++occupant_counts[pos];
             }
-            gene_indicators.push({'gene_id': gene_id,
-                                  'is_evaluated': is_evaluated,
-                                  'pos': position,
-                                  'indicator_rank': position_occupants.get(position).size,
-                                  'gene_fitness_contribution': 0});
-            position_occupants.get(position).add(gene_id);
+            rank = occupant_counts[pos] - 1;
           }
+          pop_indicators.emplace_back((uint32_t)pos);
+          pop_indicators.emplace_back((uint32_t)rank);
+          pop_indicators.emplace_back(0);
         }
-        for (let i = 0; i < gene_indicators.length; i++) {
-          gene_indicators[i]['rank']
-        }
-        emp.AagosPopVis[elem_id]['pop'].push({'org_id': org_id,
-                                              'bits': bits,
-                                              'is_evaluated': is_evaluated,
-                                              'gene_starts': gene_starts,
-                                              'position_occupants': position_occupants,
-                                              'gene_occupancy': gene_occupancy,
-                                              'gene_indicators': gene_indicators,
-                                              'gene_fitness_contributions': new Array(gene_starts.length)});
-      }, element_id.c_str(),       // 0
-         org_id,                   // 1
-         bits.c_str(),             // 2
-         gene_starts_str.c_str(),  // 3
-         gene_size,                // 4
-         is_evaluated);            // 5
-
-      // Update gene fitness contributions (but only if the organism has been evaluated)
-      if (is_evaluated) {
-          for (size_t gene_id = 0; gene_id < gene_starts.size(); ++gene_id) {
-          const double gene_fitness = org.GetPhenotype().gene_fitness_contributions[gene_id];
-          EM_ASM({
-            const elem_id = UTF8ToString($0);
-            const org_id = $1;
-            const gene_id = $2;
-            const gene_fitness = $3;
-            const gene_size = $4;
-            const num_genes = emp.AagosPopVis[elem_id]['pop'][org_id].gene_starts.length;
-            emp.AagosPopVis[elem_id]['pop'][org_id]['gene_fitness_contributions'][gene_id] = gene_fitness;
-            const indicator_start = gene_id * gene_size;
-            const indicator_stop = (indicator_start) + gene_size;
-            for (let i = indicator_start; i < indicator_stop; ++i) {
-              emp.AagosPopVis[elem_id]['pop'][org_id]['gene_indicators'][i]['gene_fitness_contribution'] = gene_fitness;
-            }
-          }, element_id.c_str(),
-            org_id,
-            gene_id,
-            gene_fitness,
-            gene_size);
-        }
+      }
+      for (size_t i = first_indicator; i < pop_indicators.size(); i += INDICATOR_FIELDS) {
+        pop_indicators[i + 2] = num_bits ? (uint32_t)occupant_counts[pop_indicators[i]] : 1;
       }
     }
 
-
     EM_ASM({
-      var elem_id = UTF8ToString($0);
-      var most_fit_id = $1;
-      var max_genome_size = $2;
-      emp.AagosPopVis[elem_id]['most_fit_id'] = most_fit_id;
-      emp.AagosPopVis[elem_id]['max_genome_size'] = max_genome_size;
-    }, element_id.c_str(),   // 0
-       world.GetMostFitID(), // 1
-       max_genome_size);     // 2
+      const elem_id = UTF8ToString($0);
+      var vis_info = emp.AagosPopVis[elem_id];
+      vis_info["pop_data"] = {"num_orgs": $1, "num_genes": $2, "gene_size": $3,
+                              "orgs_ptr": $4, "words_ptr": $5, "words_len": $6,
+                              "gene_starts_ptr": $7, "contributions_ptr": $8, "indicators_ptr": $9};
+      vis_info["most_fit_id"] = $10;
+      vis_info["max_genome_size"] = $11;
+    }, element_id.c_str(),          // 0
+       num_orgs,                    // 1
+       num_genes,                   // 2
+       gene_size,                   // 3
+       pop_orgs.data(),             // 4
+       pop_words.data(),            // 5
+       pop_words.size(),            // 6
+       pop_gene_starts.data(),      // 7
+       pop_contributions.data(),    // 8
+       pop_indicators.data(),       // 9
+       frame.most_fit_id,           // 10
+       max_genome_size);            // 11
   }
 
-  // Do this separately instead of relying on D3 filters to save time!
-  // - todo merge update pop data max fit & full pop where possible?
-  void UpdatePopDataMaxFit(world_t & world) {
-    if (!init || !world.IsSetup()) return;
-
-    const size_t most_fit_id = world.GetMostFitID();
-    org_t & org = world.GetOrg(most_fit_id);
-    const size_t genome_size = org.GetNumBits();
-    const size_t gene_size = org.GetGeneSize();
-    const bool is_evaluated = org.GetPhenotype().IsEvaluated();
-
-    // Collect string representation of bits
-    std::ostringstream stream;
-    stream << org.GetBits();
-    const std::string bits(stream.str());
-    stream.str(std::string());
-    // Collect string representation of gene starts
-    auto & gene_starts = org.GetGeneStarts();
-    for (size_t gene_id = 0; gene_id < gene_starts.size(); ++gene_id) {
-      if (gene_id) stream << ",";
-      // const size_t lr_gene_start = (genome_size - gene_starts[gene_id]);
-      stream << gene_starts[gene_id];
-    }
-    const std::string gene_starts_str(stream.str());
-
-    // info to update: bits, gene starts, num genes, gene size, num_bits
+  /// Copy the population summary from frame (if it has one) and point javascript at it.
+  void UpdateSummaryData(const frame_t & frame) {
+    if (!init || !frame.has_summary) return;
+    summary_counts = frame.summary;
     EM_ASM({
       const elem_id = UTF8ToString($0);
-      const most_fit_id = $1;
-      const genome_size = $2;
-      const gene_starts = UTF8ToString($3).split(',').map(Number);
-      const bits = UTF8ToString($4).split('').map(Number).reverse(); // Reverse because representation r=>l, want to draw l=>r
-      const gene_size = $5;
-      const is_evaluated = $6;
-      emp.AagosPopVis[elem_id]['most_fit_id'] = most_fit_id;
-      emp.AagosPopVis[elem_id]['max_genome_size'] = genome_size;
-
-      // Clear population information.
-      emp.AagosPopVis[elem_id]['pop'] = [];
-
-      var gene_occupancy = new Map();
-      var position_occupants = new Map();
-      var gene_indicators = [];
-      for (let gene_id = 0; gene_id < gene_starts.length; gene_id++) {
-        gene_occupancy.set(gene_id, []);
-        var start = gene_starts[gene_id];
-        for (let k = 0; k < gene_size; k++) {
-          const position = (start + k) % genome_size;
-          gene_occupancy.get(gene_id).push(position);
-          if (!(position_occupants.has(position))) {
-            position_occupants.set(position, new Set());
-          }
-          gene_indicators.push({'gene_id': gene_id,
-                                'pos': position,
-                                'indicator_rank': position_occupants.get(position).size,
-                                'is_evaluated': is_evaluated,
-                                'gene_fitness_contribution': 0});
-          position_occupants.get(position).add(gene_id);
-        }
-      }
-      for (let i = 0; i < gene_indicators.length; i++) {
-        gene_indicators[i]['rank']
-      }
-      emp.AagosPopVis[elem_id]['pop'].push({'org_id': most_fit_id,
-                                            'bits': bits,
-                                            'gene_starts': gene_starts,
-                                            'is_evaluated': is_evaluated,
-                                            'position_occupants': position_occupants,
-                                            'gene_occupancy': gene_occupancy,
-                                            'gene_indicators': gene_indicators,
-                                            'gene_fitness_contributions': new Array(gene_starts.length)});
-    }, element_id.c_str(),      // 0
-       most_fit_id,             // 1
-       genome_size,             // 2
-       gene_starts_str.c_str(), // 3
-       bits.c_str(),            // 4
-       gene_size,               // 5
-       is_evaluated);           // 6
-
-    // Update gene fitness contributions (only if org has been evaluated)
-    if (is_evaluated) {
-      for (size_t gene_id = 0; gene_id < gene_starts.size(); ++gene_id) {
-        const double gene_fitness = org.GetPhenotype().gene_fitness_contributions[gene_id];
-        EM_ASM({
-          const elem_id = UTF8ToString($0);
-          const gene_id = $1;
-          const gene_fitness = $2;
-          const gene_size = $3;
-          const num_genes = emp.AagosPopVis[elem_id]['pop'][0].gene_starts.length;
-          emp.AagosPopVis[elem_id]['pop'][0]['gene_fitness_contributions'][gene_id] = gene_fitness;
-          const indicator_start = gene_id * gene_size;
-          const indicator_stop = (indicator_start) + gene_size;
-          for (let i = indicator_start; i < indicator_stop; ++i) {
-            emp.AagosPopVis[elem_id]['pop'][0]['gene_indicators'][i]['gene_fitness_contribution'] = gene_fitness;
-          }
-        }, element_id.c_str(),
-            gene_id,
-            gene_fitness,
-            gene_size);
-      }
-    }
+      emp.AagosPopVis[elem_id]["summary_data"] = {"counts_ptr": $1, "positions": $2, "num_genes": $3, "pop_size": $4};
+    }, element_id.c_str(),        // 0
+       summary_counts.data(),     // 1
+       frame.summary_positions,   // 2
+       frame.num_genes,           // 3
+       frame.pop_size);           // 4
   }
 
-  void UpdateGradientEnvData(world_t & world) {
-    // std::cout << "Update env data..." << std::endl;
-    emp_assert(world.GetConfig().GRADIENT_MODEL());
-    if (!init || !world.IsSetup()) return;
-    const size_t num_gene_targets = world.GetConfig().NUM_GENES();
-    const size_t gene_target_size = world.GetConfig().GENE_SIZE();
-    // info to update: gradient env, num genes, gene sizes
-    EM_ASM({
-      const elem_id = UTF8ToString($0);
-      const num_gene_targets = $1;
-      const gene_target_size = $2;
-      emp.AagosPopVis[elem_id]['gradient_env'] = [];
-      emp.AagosPopVis[elem_id]['num_gene_targets'] = num_gene_targets;
-      emp.AagosPopVis[elem_id]['gene_target_size'] = gene_target_size;
-    }, element_id.c_str(), // 0
-       num_gene_targets,   // 1
-       gene_target_size);  // 2
-
-    const auto & gene_targets = world.GetGradientFitnessModel().targets;
+  /// Pack gene targets from frame into the environment buffer (only if frame carries the environment).
+  void UpdateGradientEnvData(const frame_t & frame) {
+    if (!init || !frame.has_env) return;
+    const size_t num_gene_targets = frame.num_genes;
+    const size_t gene_target_size = frame.gene_size;
+    env_words.clear();
     for (size_t gene_id = 0; gene_id < num_gene_targets; ++gene_id) {
-      std::ostringstream stream;
-      stream << gene_targets[gene_id];
-      const std::string gene_bits(stream.str());
-      EM_ASM({
-        const elem_id = UTF8ToString($0);
-        const gene_bits = UTF8ToString($1).split('').map(Number).reverse();
-        const gene_id = $2;
-        emp.AagosPopVis[elem_id]["gradient_env"].push(({"bits":gene_bits,"id":gene_id}));
-      }, element_id.c_str(),
-         gene_bits.c_str(),
-         gene_id);
+      PackBits(frame.gradient_env[gene_id], env_words);
     }
-    // std::cout << "..done updating the environment" << std::endl;
+    EM_ASM({
+      const elem_id = UTF8ToString($0);
+      var vis_info = emp.AagosPopVis[elem_id];
+      vis_info["num_gene_targets"] = $1;
+      vis_info["gene_target_size"] = $2;
+      vis_info["env_data"] = {"words_ptr": $3, "words_per_target": $4};
+    }, element_id.c_str(),            // 0
+       num_gene_targets,              // 1
+       gene_target_size,              // 2
+       env_words.data(),              // 3
+       (gene_target_size + 31) / 32); // 4
   }
 
 public:
   AagosPopulationVisualization(const std::string & id="pop-vis") : element_id(id), vis_div(id) { ; }
 
-  void Setup(world_t & world) {
+  void Setup(size_t num_genes) {
     std::cout << "Pop visualization setup" << std::endl;
 
-    InitializeVariables(world);
+    InitializeVariables(num_genes);
 
     // Clean out contents of vis_div
     vis_div.Clear();
@@ -353,7 +279,7 @@ public:
     vis_div.Div(element_id + "-gene-targets-row")
       << UI::Div(element_id + "-gene-targets-flex-row").SetAttr("class", "d-flex flex-row flex-wrap justify-content-center list-group-horizontal");
 
-    for (size_t gene_id = 0; gene_id < world.GetConfig().NUM_GENES(); ++gene_id) {
+    for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
       vis_div.Div(element_id + "-gene-targets-flex-row")
         << UI::Div(element_id + "-gene-target-" + emp::to_string(gene_id) + "-list-group-item").SetAttr("class", "list-group-item border border-dark rounded-0 m-1 p-0")
         << UI::Div(element_id + "-gene-target-" + emp::to_string(gene_id) + "-d-flex-container").SetAttr("class", "d-flex align-items-center h-100")
@@ -362,7 +288,7 @@ public:
       vis_div.Div(element_id + "-gene-target-" + emp::to_string(gene_id) + "-d-flex-container")
         << UI::Div(element_id + "-gene-target-" + emp::to_string(gene_id) + "-canvas-div");
       // NOTE - 'element_id + "-gene-target" + emp::to_string(gene_id) + "-canvas-div"' is where we'll
-      //         put each gene target svg
+      //         put each gene target canvas
     }
 
     vis_div << UI::Element("hr", element_id + "-gene-targets-hr");
@@ -371,7 +297,8 @@ public:
     vis_div << UI::Div(element_id + "-population-label-row").SetAttr("class", "row justify-content-center");
     vis_div.Div(element_id + "-population-label-row")
       << UI::Element("h5", element_id + "-population-label").SetAttr("class", "card-title")
-      << ((draw_mode == POP_DRAW_MODE::MAX_FIT) ? "Max Fit Organism" : "Population");
+      << ((draw_mode == POP_DRAW_MODE::MAX_FIT) ? "Max Fit Organism"
+          : ((draw_mode == POP_DRAW_MODE::SUMMARY) ? "Population Summary" : "Population"));
     vis_div << UI::Div(element_id + "-population-canvas-row").SetAttr("class", "row");
     vis_div.Div(element_id + "-population-canvas-row")
       << UI::Div(element_id + "-population-canvas-div")
@@ -380,67 +307,365 @@ public:
         .SetCSS("overflow-x", "scroll")
         .SetCSS("max-height", emp::to_string(pop_view_max_height_px) + "px");
 
-    // vis_div << UI::Div(element_id + "-tooltip")
-    //             .SetCSS("opacity", 0)
-    //             .SetCSS("position", "absolute")
-    //             .SetAttr("class", "tooltip");
-
-    // Add SVG to #element_id
+    // Add canvases to #element_id
     EM_ASM({
       const elem_id = UTF8ToString($0);
       const num_genes = $1;
+      var vis_info = emp.AagosPopVis[elem_id];
 
-      // ---- Configure population view (div/svg/canvas/data-canvas) ----
+      // ---- Configure population view (scrolling div/sizer/canvas) ----
+      // The sizer has the size of the full population drawing so that the div scrolls as before, but
+      // the canvas only covers (and only draws) the visible part of it.
       const pop_canvas_div_id = elem_id+"-population-canvas-div";
-      emp.AagosPopVis[elem_id]["pop_canvas_div_id"] = pop_canvas_div_id;
+      vis_info["pop_canvas_div_id"] = pop_canvas_div_id;
+      vis_info["pop_layout"] = null;
 
       var pop_canvas_div = d3.select("#"+pop_canvas_div_id);
       pop_canvas_div.select("*").remove();
 
-      var pop_svg = pop_canvas_div.append("svg")
-                                  .attr("width",1)
-                                  .attr("height",1)
-                                  .attr("id","AagosPopVis-"+elem_id+"-pop-svg")
-                                  .attr("class","AagosPopVis-svg");
-
-      var pop_canvas = pop_svg.append("g")
-                              .attr("id","AagosPopVis-"+elem_id+"-pop-canvas")
-                              .attr("class","AagosPopVis-canvas");
-
-      var pop_data_canvas = pop_canvas.append("g")
-                                      .attr("id","AagosPopVis-"+elem_id+"-pop-data-canvas")
-                                      .attr("class","AagosPopVis-canvas AagosPopVis-data-canvas");
-
-      // Setup gene target canvas/svg
-      emp.AagosPopVis[elem_id]["gene_target_canvas_div_ids"] = [];
+      var pop_sizer = pop_canvas_div.append("div")
+                                    .attr("id","AagosPopVis-"+elem_id+"-pop-sizer")
+                                    .style("position","relative")
+                                    .style("width","1px")
+                                    .style("height","1px");
+
+      var pop_canvas = pop_sizer.append("canvas")
+                                .attr("id","AagosPopVis-"+elem_id+"-pop-canvas")
+                                .attr("class","AagosPopVis-canvas AagosPopVis-data-canvas")
+                                .attr("width",1)
+                                .attr("height",1)
+                                .style("position","absolute")
+                                .style("left","0px")
+                                .style("top","0px");
+
+      d3.select("#AagosPopVis-"+elem_id+"-tooltip").remove();
+      var tool_tip = d3.select("body").append("div")
+                       .attr("id","AagosPopVis-"+elem_id+"-tooltip")
+                       .attr("class","d3-tip")
+                       .style("position","absolute")
+                       .style("pointer-events","none")
+                       .style("opacity",0);
+
+      // The population canvas either shows organisms ("Pop") or the population summary ("Summary").
+      vis_info["renderer"] = "Pop";
+      pop_canvas_div.on("scroll", function() { vis_info["Render" + vis_info["renderer"]](); });
+
+      // Tooltips: the active renderer's hit test gives the tooltip rows under the mouse (given in
+      // coordinates relative to the top-left corner of the full drawing).
+      pop_canvas.on("mousemove", function() {
+        const event = d3.event;
+        const div = document.getElementById(pop_canvas_div_id);
+        const rows = vis_info[vis_info["renderer"] + "Tooltip"](event.offsetX + div.scrollLeft,
+                                                                 event.offsetY + div.scrollTop);
+        if (rows == null) {
+          tool_tip.style("opacity",0);
+          return;
+        }
+        var content = "<table class='table  table-sm table-dark'>";
+        rows.forEach(function(row) { content += "<tr><th>" + row[0] + "</th><td>" + row[1] + "</td></tr>"; });
+        content += "</table>";
+        tool_tip.html(content)
+                .style("left", (event.pageX + 12) + "px")
+                .style("top", (event.pageY + 12) + "px")
+                .style("opacity",1);
+      });
+      pop_canvas.on("mouseout", function() { tool_tip.style("opacity",0); });
+
+      // Size the population canvas to the visible part of a drawing of the given size. Returns the
+      // canvas context (with device pixel ratio applied) and the visible region.
+      vis_info["PrepareCanvas"] = function(width, height) {
+        const div = document.getElementById(pop_canvas_div_id);
+        const canvas = document.getElementById("AagosPopVis-"+elem_id+"-pop-canvas");
+        const view = {"scroll_x": div.scrollLeft,
+                      "scroll_y": div.scrollTop,
+                      "width": Math.max(1, Math.min(div.clientWidth, width)),
+                      "height": Math.max(1, Math.min(div.clientHeight, height))};
+        const ratio = window.devicePixelRatio || 1;
+        canvas.style.left = view.scroll_x + "px";
+        canvas.style.top = view.scroll_y + "px";
+        canvas.style.width = view.width + "px";
+        canvas.style.height = view.height + "px";
+        canvas.width = Math.round(view.width * ratio);
+        canvas.height = Math.round(view.height * ratio);
+        view.ctx = canvas.getContext("2d");
+        view.ctx.setTransform(ratio, 0, 0, ratio, 0, 0);
+        view.ctx.clearRect(0, 0, view.width, view.height);
+        return view;
+      };
+
+      vis_info["PopTooltip"] = function(x, y) {
+        const layout = vis_info["pop_layout"];
+        if (!layout) return null;
+        const hit = vis_info["FindIndicator"](x - layout.margins.left, y - layout.margins.top);
+        if (hit == null) return null;
+        return [["Gene ID: ", hit["gene_id"]],
+                ["Fitness contribution: ", hit["gene_fitness_contribution"]]];
+      };
+
+      // Returns the gene indicator at data coordinates (x, y) (i.e., relative to the top-left
+      // corner of the first organism's first bit), or null if there isn't one.
+      vis_info["FindIndicator"] = function(x, y) {
+        const layout = vis_info["pop_layout"];
+        if (x < 0 || y < 0) return null;
+        const org_i = Math.floor(y / layout.org_height);
+        const local_y = y - org_i * layout.org_height;
+        const pos = Math.floor(x / layout.bit_width);
+        if (org_i >= layout.pop_size || local_y >= layout.bit_height) return null;
+        const views = vis_info["GetPopViews"]();
+        const pop_data = vis_info["pop_data"];
+        const org_fields = layout.org_fields;
+        const indicator_fields = layout.indicator_fields;
+        if (pos >= views.orgs[org_i * org_fields + 1] || !views.orgs[org_i * org_fields + 2]) return null;
+        const num_genes = pop_data["num_genes"];
+        const gene_size = pop_data["gene_size"];
+        const indicators_per_org = num_genes * gene_size;
+        for (let i = org_i * indicators_per_org; i < (org_i + 1) * indicators_per_org; i++) {
+          if (views.indicators[i * indicator_fields] != pos) continue;
+          const rank = views.indicators[i * indicator_fields + 1];
+          const height = layout.bit_height / views.indicators[i * indicator_fields + 2];
+          if (local_y < height * rank || local_y >= height * (rank + 1)) continue;
+          const gene_id = Math.floor((i % indicators_per_org) / gene_size);
+          return {"gene_id": gene_id,
+                  "gene_fitness_contribution": views.contributions[org_i * num_genes + gene_id]};
+        }
+        return null;
+      };
+
+      // Draw the visible part of the population (as described by pop_layout).
+      vis_info["RenderPop"] = function() {
+        const layout = vis_info["pop_layout"];
+        if (!layout) return;
+        const margins = layout.margins;
+        const view = vis_info["PrepareCanvas"](layout.width, layout.height);
+        const scroll_x = view.scroll_x;
+        const scroll_y = view.scroll_y;
+        const view_width = view.width;
+        const view_height = view.height;
+        var ctx = view.ctx;
+
+        const views = vis_info["GetPopViews"]();
+        const pop_data = vis_info["pop_data"];
+        const num_genes = pop_data["num_genes"];
+        const gene_size = pop_data["gene_size"];
+        const indicators_per_org = num_genes * gene_size;
+        const org_fields = layout.org_fields;
+        const indicator_fields = layout.indicator_fields;
+        const bit_width = layout.bit_width;
+        const bit_height = layout.bit_height;
+        const org_height = layout.org_height;
+        const gene_colors = d3.range(num_genes).map(vis_info["gene_color_scale"]);
+
+        // Visible organisms/positions.
+        const first_org = Math.max(0, Math.floor(scroll_y / org_height));
+        const end_org = Math.min(layout.pop_size, Math.ceil((scroll_y + view_height - margins.top) / org_height));
+        const first_bit = Math.max(0, Math.floor(scroll_x / bit_width));
+        const end_bit = Math.ceil((scroll_x + view_width - margins.left) / bit_width);
+        const draw_text = (bit_width >= 8 && bit_height >= 8);
+
+        ctx.save();
+        ctx.beginPath();
+        ctx.rect(margins.left, margins.top, view_width - margins.left, view_height - margins.top);
+        ctx.clip();
+        ctx.translate(margins.left - scroll_x, margins.top - scroll_y);
+        ctx.lineWidth = 1;
+        ctx.strokeStyle = "gray";
+        ctx.textAlign = "center";
+        ctx.textBaseline = "middle";
+        ctx.font = Math.floor(Math.min(bit_width, bit_height) * 0.6) + "px sans-serif";
+        for (let org_i = first_org; org_i < end_org; org_i++) {
+          const y = org_i * org_height;
+          const num_bits = views.orgs[org_i * org_fields + 1];
+          const word_offset = views.orgs[org_i * org_fields + 3];
+          const org_end_bit = Math.min(end_bit, num_bits);
+          if (org_end_bit <= first_bit) continue;
+          ctx.fillStyle = "white";
+          ctx.fillRect(first_bit * bit_width, y, (org_end_bit - first_bit) * bit_width, bit_height);
+          for (let i = org_i * indicators_per_org; i < (org_i + 1) * indicators_per_org; i++) {
+            const pos = views.indicators[i * indicator_fields];
+            if (pos < first_bit || pos >= org_end_bit) continue;
+            const rank = views.indicators[i * indicator_fields + 1];
+            const height = bit_height / views.indicators[i * indicator_fields + 2];
+            ctx.fillStyle = gene_colors[Math.floor((i % indicators_per_org) / gene_size)];
+            ctx.fillRect(pos * bit_width, y + height * rank, bit_width, height);
+          }
+          ctx.fillStyle = "black";
+          for (let bit_i = first_bit; bit_i < org_end_bit; bit_i++) {
+            ctx.strokeRect(bit_i * bit_width, y, bit_width, bit_height);
+            if (draw_text) {
+              const bit = (views.words[word_offset + (bit_i >>> 5)] >>> (bit_i & 31)) & 1;
+              ctx.fillText(bit, bit_i * bit_width + (bit_width / 2.0), y + (bit_height / 2.0));
+            }
+          }
+        }
+        ctx.restore();
+
+        // --- Axes (fixed in the margins while scrolling) ---
+        ctx.fillStyle = "white";
+        ctx.fillRect(0, 0, view_width, margins.top);
+        ctx.fillRect(0, 0, margins.left, view_height);
+        ctx.strokeStyle = "black";
+        ctx.fillStyle = "black";
+        ctx.font = "10px sans-serif";
+        ctx.beginPath();
+        ctx.moveTo(margins.left, margins.top - 0.5);
+        ctx.lineTo(view_width, margins.top - 0.5);
+        layout.x_scale.ticks().forEach(function(tick) {
+          const x = Math.round(margins.left + layout.x_scale(tick) - scroll_x) + 0.5;
+          if (x < margins.left || x > view_width) return;
+          ctx.moveTo(x, margins.top);
+          ctx.lineTo(x, margins.top - 6);
+          ctx.textAlign = "center";
+          ctx.textBaseline = "bottom";
+          ctx.fillText(tick, x, margins.top - 7);
+        });
+        if (layout.pop_size > 1) {
+          ctx.moveTo(margins.left - 0.5, margins.top);
+          ctx.lineTo(margins.left - 0.5, view_height);
+          layout.y_scale.ticks().forEach(function(tick) {
+            const y = Math.round(margins.top + layout.y_scale(tick) - scroll_y) + 0.5;
+            if (y < margins.top || y > view_height) return;
+            ctx.moveTo(margins.left, y);
+            ctx.lineTo(margins.left - 6, y);
+            ctx.textAlign = "right";
+            ctx.textBaseline = "middle";
+            ctx.fillText(tick, margins.left - 7, y);
+          });
+        }
+        ctx.stroke();
+      };
+
+      // Draw the population summary (as described by summary_layout): gene occupancy density and
+      // frequency of 1s at each position, and the genome length distribution.
+      vis_info["RenderSummary"] = function() {
+        const layout = vis_info["summary_layout"];
+        if (!layout) return;
+        const view = vis_info["PrepareCanvas"](layout.width, layout.height);
+        var ctx = view.ctx;
+        const data = vis_info["summary_data"];
+        const counts = vis_info["GetSummaryCounts"]();
+        const positions = data["positions"];
+        const num_genes = data["num_genes"];
+        const pop_size = Math.max(1, data["pop_size"]);
+        const ones_offset = positions * num_genes;
+        const lengths_offset = positions * (num_genes + 1);
+        const margins = layout.margins;
+        const cell_width = layout.cell_width;
+        const row_height = layout.row_height;
+        const gene_colors = d3.range(num_genes).map(vis_info["gene_color_scale"]);
+
+        ctx.save();
+        ctx.translate(-view.scroll_x, -view.scroll_y);
+        // Gene occupancy density: one row per gene.
+        for (let gene_id = 0; gene_id < num_genes; gene_id++) {
+          ctx.fillStyle = gene_colors[gene_id];
+          for (let pos = 0; pos < positions; pos++) {
+            const density = counts[pos * num_genes + gene_id] / pop_size;
+            if (!density) continue;
+            ctx.globalAlpha = density;
+            ctx.fillRect(margins.left + pos * cell_width, margins.top + gene_id * row_height, cell_width, row_height);
+          }
+        }
+        ctx.globalAlpha = 1;
+        // Frequency of 1s among genomes long enough to have each position.
+        const bits_y = margins.top + num_genes * row_height;
+        var covered = data["pop_size"];
+        for (let pos = 0; pos < positions; pos++) {
+          covered -= counts[lengths_offset + pos];
+          if (covered <= 0) break;
+          ctx.fillStyle = d3.interpolateGreys(counts[ones_offset + pos] / covered);
+          ctx.fillRect(margins.left + pos * cell_width, bits_y, cell_width, row_height);
+        }
+        // Genome length histogram.
+        var max_count = 1;
+        for (let len = 0; len <= positions; len++) max_count = Math.max(max_count, counts[lengths_offset + len]);
+        ctx.fillStyle = "steelblue";
+        for (let len = 0; len <= positions; len++) {
+          const bar_height = layout.hist_height * counts[lengths_offset + len] / max_count;
+          if (!bar_height) continue;
+          ctx.fillRect(margins.left + len * cell_width, layout.hist_top + layout.hist_height - bar_height, Math.max(1, cell_width), bar_height);
+        }
+        ctx.strokeStyle = "gray";
+        ctx.lineWidth = 1;
+        ctx.strokeRect(margins.left, margins.top, positions * cell_width, (num_genes + 1) * row_height);
+        ctx.strokeRect(margins.left, layout.hist_top, (positions + 1) * cell_width, layout.hist_height);
+        // Row labels and position axis.
+        ctx.fillStyle = "black";
+        ctx.font = "10px sans-serif";
+        ctx.textAlign = "right";
+        ctx.textBaseline = "middle";
+        for (let gene_id = 0; gene_id < num_genes; gene_id++) {
+          ctx.fillText("Gene " + gene_id, margins.left - 6, margins.top + (gene_id + 0.5) * row_height);
+        }
+        ctx.fillText("Freq. of 1s", margins.left - 6, bits_y + 0.5 * row_height);
+        ctx.fillText("Genome length", margins.left - 6, layout.hist_top + 0.5 * layout.hist_height);
+        ctx.textAlign = "center";
+        ctx.textBaseline = "bottom";
+        ctx.beginPath();
+        layout.x_scale.ticks().forEach(function(tick) {
+          const x = Math.round(margins.left + layout.x_scale(tick)) + 0.5;
+          ctx.moveTo(x, margins.top);
+          ctx.lineTo(x, margins.top - 6);
+          ctx.fillText(tick, x, margins.top - 7);
+        });
+        ctx.stroke();
+        ctx.restore();
+      };
+
+      vis_info["SummaryTooltip"] = function(x, y) {
+        const layout = vis_info["summary_layout"];
+        if (!layout) return null;
+        const data = vis_info["summary_data"];
+        const counts = vis_info["GetSummaryCounts"]();
+        const positions = data["positions"];
+        const num_genes = data["num_genes"];
+        const pop_size = Math.max(1, data["pop_size"]);
+        const lengths_offset = positions * (num_genes + 1);
+        const pos = Math.floor((x - layout.margins.left) / layout.cell_width);
+        if (pos < 0 || pos > positions) return null;
+        if (y >= layout.hist_top && y < layout.hist_top + layout.hist_height) {
+          return [["Genome length: ", (pos == positions ? "&ge; " : "") + pos],
+                  ["Organisms: ", counts[lengths_offset + pos]]];
+        }
+        const row = Math.floor((y - layout.margins.top) / layout.row_height);
+        if (y < layout.margins.top || row > num_genes || pos == positions) return null;
+        if (row < num_genes) {
+          return [["Position: ", pos],
+                  ["Gene ID: ", row],
+                  ["Occupancy: ", (counts[pos * num_genes + row] / pop_size).toFixed(3)]];
+        }
+        var covered = data["pop_size"];
+        for (let len = 0; len <= pos; len++) covered -= counts[lengths_offset + len];
+        return [["Position: ", pos],
+                ["Frequency of 1s: ", covered > 0 ? (counts[positions * num_genes + pos] / covered).toFixed(3) : "-"],
+                ["Genomes this long: ", covered]];
+      };
+
+      // Setup gene target canvases
+      vis_info["gene_target_canvas_div_ids"] = [];
       for (let gene_id = 0; gene_id < num_genes; gene_id++) {
         const gene_target_canvas_div_id = elem_id + "-gene-target-" + gene_id + "-canvas-div";
-        emp.AagosPopVis[elem_id]["gene_target_canvas_div_ids"].push(gene_target_canvas_div_id);
+        vis_info["gene_target_canvas_div_ids"].push(gene_target_canvas_div_id);
 
         var gene_target_canvas_div = d3.select("#"+gene_target_canvas_div_id);
 
         gene_target_canvas_div.select("*").remove(); // Clean out any old stuff.
 
-        var gene_target_svg = gene_target_canvas_div.append("svg")
-                                                    .attr("width", 1)
-                                                    .attr("height", 1)
-                                                    .attr("id", "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-svg")
-                                                    .attr("class", "AagosPopVis-svg");
-        var gene_target_canvas = gene_target_svg.append("g")
-                                                .attr("id", "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-canvas");
-        var gene_target_data_canvas = gene_target_canvas.append("g")
-                                                        .attr("id","AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-data-canvas")
-                                                        .attr("class","AagosPopVis-canvas AagosPopVis-data-canvas");
-
+        gene_target_canvas_div.append("canvas")
+                              .attr("width", 1)
+                              .attr("height", 1)
+                              .attr("id", "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-canvas")
+                              .attr("class", "AagosPopVis-canvas AagosPopVis-data-canvas")
+                              .style("display", "block");
       }
 
-    }, element_id.c_str(), world.GetConfig().NUM_GENES());
+    }, element_id.c_str(), num_genes);
 
     init = true;
   }
 
-  void DrawGradientEnv(world_t & world, bool update_data=true) {
-    if (update_data) UpdateGradientEnvData(world);
+  /// Draw gene targets. Environment data is only updated if frame carries the environment.
+  void DrawGradientEnv(const frame_t & frame, bool update_data=true) {
+    if (update_data) UpdateGradientEnvData(frame);
     EM_ASM({
       const elem_id = UTF8ToString($0);
       const bit_height = $1;
@@ -449,111 +674,115 @@ public:
       var gene_colors = vis_info["gene_color_scale"];
       const num_gene_targets = vis_info["num_gene_targets"];
       const gene_target_size = vis_info["gene_target_size"];
-      const max_genome_size = vis_info["max_genome_size"];
 
       const margins = ({top: 5, right: 5, bottom: 5, left: 5}); // todo - make class param
 
-      if (!"org_bit_width" in vis_info) {
+      if (!("org_bit_width" in vis_info)) {
         vis_info["org_bit_width"] = 15; // todo - make class param
       }
-      if (!"org_bit_height" in vis_info) {
+      if (!("org_bit_height" in vis_info)) {
         vis_info["org_bit_height"] = bit_height;
       }
 
       const org_bit_height = Math.min(bit_height, vis_info["org_bit_height"]);
       const org_bit_width = vis_info["org_bit_width"];
 
-      const gene_target_width = gene_target_size * org_bit_width;
-      const gene_target_height = org_bit_height;
-
-      const canvas_width = gene_target_width + margins.left + margins.right;
-      const canvas_height = gene_target_height + margins.top + margins.bottom;
+      const canvas_width = gene_target_size * org_bit_width + margins.left + margins.right;
+      const canvas_height = org_bit_height + margins.top + margins.bottom;
+      const ratio = window.devicePixelRatio || 1;
 
-      var gene_target_x_domain = ([0, gene_target_size]);
-      var gene_target_x_range = ([0, canvas_width - margins.left - margins.right]);
-      var x_scale = d3.scaleLinear().domain(gene_target_x_domain).range(gene_target_x_range);
+      const env_words = vis_info["GetEnvWords"]();
+      const words_per_target = vis_info["env_data"]["words_per_target"];
 
       for (let gene_id = 0; gene_id < num_gene_targets; ++gene_id) {
-        div_id = vis_info["gene_target_canvas_div_ids"][gene_id];
-        svg_id = "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-svg";
-        canvas_id = "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-canvas";
-        data_canvas_id = "AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-data-canvas";
-
-        // todo - update min width of div w/width of single gene + label!
-
-        var svg = d3.select("#"+svg_id);
-        svg.attr("width", canvas_width);
-        svg.attr("height", canvas_height);
-
-        var canvas = d3.select("#"+canvas_id);
-        canvas.attr("transform", "translate(" + margins.left + "," + margins.top + ")");
-
-        var data_canvas = d3.select("#"+data_canvas_id);
-        data_canvas.selectAll("*").remove();
-
-        var bits = data_canvas.selectAll("rect.bit").data(vis_info["gradient_env"][gene_id]["bits"]);
-        bits.enter()
-            .append("rect")
-            .attr("class", "bit")
-            .attr("id", function(bit, bit_i) {
-              return "AagosPopVis-"+elem_id+"-gene-target-"+gene_id + "-bit-" + bit_i;
-            })
-            .attr("transform", function(bit, bit_i) {
-              const x_trans = x_scale(bit_i);
-              const y_trans = 0;
-              return "translate(" + x_trans + "," + y_trans + ")";
-            })
-            .attr("height", org_bit_height)
-            .attr("width", org_bit_width)
-            .attr("fill", function(bit, bit_i) {
-              return gene_colors(gene_id);
-            })
-            .attr("stroke", "gray");
-        var bit_text = data_canvas.selectAll("text.bit").data(vis_info["gradient_env"][gene_id]["bits"]);
-        bit_text.enter()
-                .append("text")
-                .attr("class", "bit-text")
-                .attr("transform", function(bit, bit_i) {
-                  const x_trans = x_scale(bit_i) + (org_bit_width / 2.0);
-                  const y_trans = (org_bit_height / 2.0);
-                  return "translate(" + x_trans + "," + y_trans + ")";
-                })
-                .attr("dominant-baseline", "middle")
-                .attr("text-anchor", "middle")
-                .text(function(bit, bit_i) {
-                  return bit;
-                });
-
+        var canvas = document.getElementById("AagosPopVis-"+elem_id+"-gene-target-"+gene_id+"-canvas");
+        if (!canvas) continue;
+        canvas.style.width = canvas_width + "px";
+        canvas.style.height = canvas_height + "px";
+        canvas.width = Math.round(canvas_width * ratio);
+        canvas.height = Math.round(canvas_height * ratio);
+
+        var ctx = canvas.getContext("2d");
+        ctx.setTransform(ratio, 0, 0, ratio, margins.left * ratio, margins.top * ratio);
+        ctx.clearRect(-margins.left, -margins.top, canvas_width, canvas_height);
+        ctx.fillStyle = gene_colors(gene_id);
+        ctx.fillRect(0, 0, gene_target_size * org_bit_width, org_bit_height);
+        ctx.lineWidth = 1;
+        ctx.strokeStyle = "gray";
+        ctx.textAlign = "center";
+        ctx.textBaseline = "middle";
+        ctx.font = Math.floor(Math.min(org_bit_width, org_bit_height) * 0.6) + "px sans-serif";
+        ctx.fillStyle = "black";
+        const target_offset = gene_id * words_per_target;
+        for (let bit_i = 0; bit_i < gene_target_size; bit_i++) {
+          ctx.strokeRect(bit_i * org_bit_width, 0, org_bit_width, org_bit_height);
+          const bit = (env_words[target_offset + (bit_i >>> 5)] >>> (bit_i & 31)) & 1;
+          ctx.fillText(bit, bit_i * org_bit_width + (org_bit_width / 2.0), org_bit_height / 2.0);
+        }
       }
 
     }, element_id.c_str(),
        pop_org_height);
   }
 
-  void DrawPop(world_t & world, bool update_data=true) {
-    if (update_data && draw_mode == POP_DRAW_MODE::FULL_POP) {
-      UpdatePopDataFull(world);
-    } else if (update_data && draw_mode == POP_DRAW_MODE::MAX_FIT) {
-      UpdatePopDataMaxFit(world);
+  /// Draw per-position aggregates over the whole population (summary draw mode). Drawing cost does
+  /// not depend on population size.
+  void DrawSummary(const frame_t & frame, bool update_data=true) {
+    if (update_data) UpdateSummaryData(frame);
+
+    EM_ASM({
+      const elem_id = UTF8ToString($0);
+      var vis_info = emp.AagosPopVis[elem_id];
+      const data = vis_info["summary_data"];
+      const positions = data["positions"];
+      const num_genes = data["num_genes"];
+
+      const width = $('#' + elem_id).width(); // Width of surrounding div
+      const margins = ({top:20, right:25, bottom:20, left:90});
+      const row_height = 14;
+      const hist_height = 80;
+      const min_cell_width = 2;
+      // Leave room for the genome length histogram's last bin (genomes >= MAX_SIZE).
+      const cell_width = Math.max(min_cell_width, (width - margins.left - margins.right) / (positions + 1));
+      const hist_top = margins.top + (num_genes + 1) * row_height + 10;
+
+      vis_info["summary_layout"] = {"margins": margins,
+                                    "width": (positions + 1) * cell_width + margins.left + margins.right,
+                                    "height": hist_top + hist_height + margins.bottom,
+                                    "cell_width": cell_width,
+                                    "row_height": row_height,
+                                    "hist_top": hist_top,
+                                    "hist_height": hist_height,
+                                    "x_scale": d3.scaleLinear().domain([0, positions]).range([0, positions * cell_width])};
+      vis_info["pop_layout"] = null;
+      vis_info["renderer"] = "Summary";
+
+      d3.select("#AagosPopVis-"+elem_id+"-pop-sizer")
+        .style("width", vis_info["summary_layout"].width + "px")
+        .style("height", vis_info["summary_layout"].height + "px");
+      vis_info["RenderSummary"]();
+    }, element_id.c_str());
+
+    data_drawn=true;
+  }
+
+  /// Draw the population (or just the most fit organism in max fit draw mode, or the population
+  /// summary in summary draw mode).
+  void DrawPop(const frame_t & frame, bool update_data=true) {
+    if (draw_mode == POP_DRAW_MODE::SUMMARY) {
+      DrawSummary(frame, update_data);
+      return;
     }
+    if (update_data) UpdatePopData(frame);
 
     EM_ASM({
-      // todo - move redundant stuff elsewhere/one-shot (no need to do multiple times)
       const elem_id = UTF8ToString($0);
       const org_height = $1;
       const pop_view_max_height_px = $2;
-      // const enable_tooltips = $3;
 
       var vis_info = emp.AagosPopVis[elem_id];
-      const pop_size = vis_info["pop"].length;
+      const pop_size = vis_info["pop_data"]["num_orgs"];
       const max_genome_size = vis_info["max_genome_size"];
-      const most_fit_id = vis_info["most_fit_id"];
-      var gene_colors = vis_info["gene_color_scale"];
-
-      const pop_div_id = emp.AagosPopVis[elem_id]["pop_canvas_div_id"];
-      const pop_svg_id =  "#AagosPopVis-" + elem_id + "-pop-svg";
-      const pop_canvas_id = "#AagosPopVis-" + elem_id + "-pop-canvas";
-      const pop_data_canvas_id = "#AagosPopVis-" + elem_id + "-pop-data-canvas";
 
       const width = $('#' + elem_id).width(); // Width of surrounding div
       const margins = ({top:20, right:25, bottom:20, left:30}); // todo - make dynamic
@@ -565,186 +794,61 @@ public:
       min_canvas_width = (max_genome_size+1) * min_bit_width;
 
       var canvas_width = width - margins.left - margins.right;
-      // todo - compute the min width based on a minimum bit size
       // If page is super small, allow left-right scrolling (don't shrink genomes too small)
       if (canvas_width < min_canvas_width) {
         canvas_width = min_canvas_width;
       }
 
-      // Configure x/y range/domains (with a little bit of wiggle room)
-      var pop_x_domain = ([0, max_genome_size]);
-      var pop_x_range  = ([0, canvas_width]);
-      var pop_y_domain = ([0, pop_size]);
-      var pop_y_range  = ([0, canvas_height]);
-      var pop_x_scale  = d3.scaleLinear().domain(pop_x_domain).range(pop_x_range);
-      var pop_y_scale  = d3.scaleLinear().domain(pop_y_domain).range(pop_y_range);
-
-      // Grab the pop svg to re-size appropriately!
-      var svg = d3.select(pop_svg_id);
-      svg.attr("width", canvas_width + margins.left + margins.right);
-      svg.attr("height", height);
+      var pop_x_scale  = d3.scaleLinear().domain([0, max_genome_size]).range([0, canvas_width]);
+      var pop_y_scale  = d3.scaleLinear().domain([0, pop_size]).range([0, canvas_height]);
 
       const org_bit_width = pop_x_scale(1);
       const org_bit_height = pop_y_scale(0.9);
       vis_info["org_bit_width"] = org_bit_width;
       vis_info["org_bit_height"] = org_bit_height;
 
-      // Grab the pop canvas inside of the svg, add transform to respect margins.
-      var pop_canvas = d3.select(pop_canvas_id);
-      pop_canvas.attr("transform", "translate(" + margins.left + "," + margins.top + ")");
-
-      // --- Axes ---
-      pop_canvas.selectAll(".axis").remove();
-      if (pop_size > 1) {
-        var y_axis = d3.axisLeft();
-        y_axis.scale(pop_y_scale);
-        pop_canvas.append("g").attr("class", "axis y_axis")
-                              .attr("id", "AagosPopVis-"+elem_id+"-pop-y-axis")
-                              .call(y_axis);
-      }
-
-      var x_axis = d3.axisTop();
-      x_axis.scale(pop_x_scale);
-      pop_canvas.append("g").attr("class", "axis x_axis")
-                            .attr("id", "AagosPopVis-"+elem_id+"-pop-x-axis")
-                            .call(x_axis);
-
-      var axes = pop_canvas.selectAll(".axis");
-      axes.selectAll("path").style({"fill": "none", "stroke": "black", "shape-rendering": "crispEdges"});
-      axes.selectAll("text").style({"font-family": "sans-serif", "font-size": "10px"});
-
-      d3.selectAll(".d3-tip").remove(); // todo - move this out of the draw function...
-      var tool_tip = d3.tip()
-        .attr("class", "d3-tip")
-        .html(function(indicator) {
-          content =
-            "<table class='table  table-sm table-dark'>" +
-              "<tr><th>Gene ID: </th><td>" + indicator["gene_id"] + "</td></tr>" +
-              "<tr><th>Fitness contribution: </th><td>" + indicator["gene_fitness_contribution"] + "</td></tr>" +
-            "</table>";
-          return content;
-        });
-      svg.call(tool_tip);
-
-      var pop_data_canvas = d3.select(pop_data_canvas_id);
-      pop_data_canvas.selectAll("*").remove();
-      var organisms = pop_data_canvas.selectAll("g").data(vis_info["pop"]);
-      organisms.enter()
-               .append("g")
-               .attr("class", "AagosPopVis-organism")
-               .attr("id", function(org) {
-                  return "AagosPopVis-"+elem_id+"-organism-"+org.org_id;
-                })
-               .attr("transform", function(org, org_i) {
-                 const y_trans = pop_y_scale(org_i);
-                 const x_trans = pop_x_scale(0);
-                 return "translate(" + x_trans + "," + y_trans + ")";
-                })
-                .each(function(org) {
-                      var bits = d3.select(this).selectAll("rect.bit").data(org["bits"]);
-                      const rect_height = org_bit_height;
-                      const rect_width = org_bit_width;
-                      const is_evaluated = org['is_evaluated'];
-                      bits.enter()
-                          .append("rect")
-                          .attr("class", "bit")
-                          .attr("transform", function(bit, bit_i) {
-                            return "translate(" + pop_x_scale(bit_i) + ",0)";
-                          })
-                          .attr("height", rect_height)
-                          .attr("width", rect_width)
-                          .attr("fill", "white")
-                          .attr("stroke", "gray");
-
-                      var genes = d3.select(this).selectAll("rect.gene-indicator").data(org["gene_indicators"]);
-                      genes.enter()
-                           .append("rect")
-                           .attr("class", "gene-indicator")
-                           .attr("transform", function(indicator) {
-                              const pos = indicator['pos'];
-                              const num_occupants = org['position_occupants'].get(pos).size;
-                              const rank = indicator['indicator_rank'];
-                              const height = rect_height / num_occupants; // this should never be 0
-                              const x_trans = pop_x_scale(pos);
-                              const y_trans = height * rank;
-                              return "translate(" + x_trans + "," + y_trans + ")";
-                           })
-                           .attr("height", function(indicator) {
-                              const pos = indicator['pos'];
-                              const num_occupants = org['position_occupants'].get(pos).size;
-                              const height = rect_height / num_occupants;
-                              return height;
-                           })
-                           .attr("width", rect_width)
-                           .attr("fill", function(indicator) {
-                             const gene_id = indicator['gene_id'];
-                             return gene_colors(gene_id);
-                           });
-
-                      var bit_text = d3.select(this).selectAll("text").data(org["bits"]);
-                      bit_text.enter()
-                        .append("text")
-                        .attr("class", "bit-text")
-                        .attr("transform", function(bit, bit_i) {
-                          const x_trans = pop_x_scale(bit_i) + (rect_width / 2.0);
-                          const y_trans = (rect_height / 2.0);
-                          return "translate(" + x_trans + "," + y_trans + ")";
-                        })
-                        .attr("dominant-baseline", "middle")
-                        .attr("text-anchor", "middle")
-                        .text(function(bit, bit_i) {
-                          return bit;
-                        });
-
-                      // Draw transparent box over gene indicators to have
-                      if (is_evaluated) {
-                        var gene_indicator_hover_boxes = d3.select(this).selectAll("rect.gene-indicator-hover").data(org["gene_indicators"]);
-                        gene_indicator_hover_boxes.enter()
-                          .append("rect")
-                          .attr("class", "gene-indicator-hover")
-                          .attr("id", function(indicator, indicator_i) {
-                            return elem_id + "-gene-indicator-hover-" + indicator_i;
-                          })
-                          .attr("transform", function(indicator) {
-                            const pos = indicator['pos'];
-                            const num_occupants = org['position_occupants'].get(pos).size;
-                            const rank = indicator['indicator_rank'];
-                            const height = rect_height / num_occupants; // this should never be 0
-                            const x_trans = pop_x_scale(pos);
-                            const y_trans = height * rank;
-                            return "translate(" + x_trans + "," + y_trans + ")";
-                          })
-                          .attr("height", function(indicator) {
-                            const pos = indicator['pos'];
-                            const num_occupants = org['position_occupants'].get(pos).size;
-                            const height = rect_height / num_occupants;
-                            return height;
-                          })
-                          .attr("width", rect_width)
-                          .style("opacity", "0")
-                          .attr("label", function(indicator) {
-                            const gene_id = indicator['gene_id'];
-                            const fitness_contribution = org['gene_fitness_contributions'][gene_id];
-                            return "Gene fitness contribution = " + fitness_contribution;
-                          })
-                          .on('mouseover', tool_tip.show)
-                          .on('mouseout', tool_tip.hide);
-                      }
-                    });
+      vis_info["pop_layout"] = {"margins": margins,
+                                "width": canvas_width + margins.left + margins.right,
+                                "height": height,
+                                "pop_size": pop_size,
+                                "org_height": org_height,
+                                "bit_width": org_bit_width,
+                                "bit_height": org_bit_height,
+                                "x_scale": pop_x_scale,
+                                "y_scale": pop_y_scale,
+                                "org_fields": $3,
+                                "indicator_fields": $4};
+      vis_info["summary_layout"] = null;
+      vis_info["renderer"] = "Pop";
+
+      // Size the sizer to the full drawing (for scrolling), then draw the visible part.
+      d3.select("#AagosPopVis-"+elem_id+"-pop-sizer")
+        .style("width", (canvas_width + margins.left + margins.right) + "px")
+        .style("height", height + "px");
+      vis_info["RenderPop"]();
 
     }, element_id.c_str(),
        draw_mode==POP_DRAW_MODE::FULL_POP ? pop_org_height : max_fit_org_height,
-       pop_view_max_height_px);
+       pop_view_max_height_px,
+       ORG_FIELDS,
+       INDICATOR_FIELDS);
 
     data_drawn=true;
   }
 
   void Clear() {
-    // Clear environment text
-    // Clear population
+    // Clear environment and population canvases
     EM_ASM({
-      $(".AagosPopVis-data-canvas").html("");
-    });
+      const elem_id = UTF8ToString($0);
+      if (emp.AagosPopVis && emp.AagosPopVis[elem_id]) {
+        emp.AagosPopVis[elem_id]["pop_layout"] = null;
+        emp.AagosPopVis[elem_id]["summary_layout"] = null;
+      }
+      $(".AagosPopVis-data-canvas").each(function() {
+        this.getContext("2d").clearRect(0, 0, this.width, this.height);
+      });
+      $("#AagosPopVis-" + elem_id + "-tooltip").css("opacity", 0);
+    }, element_id.c_str());
   }
 
   void SetDrawModeFullPop() {
@@ -761,8 +865,16 @@ public:
       $("#" + elem_id + "-population-label").html("Max Fit Organism");
     }, element_id.c_str());
   }
+  void SetDrawModeSummary() {
+    draw_mode = POP_DRAW_MODE::SUMMARY;
+    EM_ASM({
+      const elem_id = UTF8ToString($0);
+      $("#" + elem_id + "-population-label").html("Population Summary");
+    }, element_id.c_str());
+  }
   bool IsDrawModeFullPop() const { return draw_mode == POP_DRAW_MODE::FULL_POP; }
   bool IsDrawModeMaxFit() const { return draw_mode == POP_DRAW_MODE::MAX_FIT; }
+  bool IsDrawModeSummary() const { return draw_mode == POP_DRAW_MODE::SUMMARY; }
   // bool IsPrevTooltips() const { return prev_tooltops; } // ew this is bad
 
 };
@@ -0,0 +1,234 @@
+#ifndef AAGOS_RUN_ARCHIVE_HPP
+#define AAGOS_RUN_ARCHIVE_HPP
+
+#include "AagosConfig.hpp"
+#include "AagosOrg.hpp"
+#include "AagosParsing.hpp"
+#include "AagosSnapshot.hpp"
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace aagos {
+
+/// Index over the output of a recorded run (as written to DATA_FILEPATH) for playback:
+///   - pop_<update>.csv / pop_<update>.bin population snapshots (binary preferred when both exist)
+///   - environment.csv environment states
+///   - run_config.csv run configuration
+///   - environment_log.bin (only noted: environments logged with ENV_LOG aren't in environment.csv)
+/// Snapshots are only read when requested, so any recorded update can be loaded directly.
+class AagosRunArchive {
+public:
+  using genome_t = AagosOrg::Genome;
+
+  struct EnvRecord {
+    size_t update=0;
+    size_t evo_phase=0;
+    size_t begin=0;     ///< Offset of the environment state in the environment file.
+    size_t length=0;
+    bool summary=false; ///< Only a summary was recorded (large procedural or shared NK landscape).
+  };
+
+  static constexpr size_t NO_RECORD = (size_t)-1;
+
+protected:
+  std::map<size_t, std::string> snapshot_paths;   ///< update => snapshot path
+  emp::vector<size_t> updates;                    ///< Snapshot updates (ascending)
+  emp::Ptr<parsing::MappedFile> env_file=nullptr;
+  emp::vector<EnvRecord> env_records;             ///< Ordered by update
+  emp::vector<std::pair<std::string, std::string>> config_params;
+  bool env_log=false;
+  std::string error;
+
+  static std::string GetBaseName(const std::string & path) {
+    const size_t slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+  }
+
+  bool AddSnapshot(const std::string & path, size_t update, bool binary) {
+    parsing::MappedFile file(path);
+    if (!file.IsOpen()) { error = file.GetError(); return false; }
+    if (binary ? !snapshot::IsBinarySnapshot(file) : !snapshot::IsCSVSnapshot(file)) {
+      error = path + ": Not a population snapshot.";
+      return false;
+    }
+    // Prefer binary snapshots (faster to load) when both formats were written.
+    auto it = snapshot_paths.find(update);
+    if (it == snapshot_paths.end()) {
+      updates.insert(std::upper_bound(updates.begin(), updates.end(), update), update);
+      snapshot_paths[update] = path;
+    } else if (binary) {
+      it->second = path;
+    }
+    return true;
+  }
+
+  bool AddEnvironment(const std::string & path) {
+    emp::Ptr<parsing::MappedFile> file = emp::NewPtr<parsing::MappedFile>(path);
+    if (!file->IsOpen()) {
+      error = file->GetError();
+      file.Delete();
+      return false;
+    }
+    // Rows: update,evo_phase,"env_state"
+    emp::vector<EnvRecord> records;
+    parsing::Cursor cursor(*file);
+    cursor.SkipLine(); // Header
+    while (cursor.NextContentLine()) {
+      EnvRecord record;
+      if (!cursor.ParseSize(record.update) || !cursor.Consume(',')
+          || !cursor.ParseSize(record.evo_phase) || !cursor.Consume(',') || !cursor.Consume('"')) {
+        error = parsing::FormatError(path, cursor.GetLine(), "Expected update,evo_phase,\"env_state\".");
+        file.Delete();
+        return false;
+      }
+      record.begin = (size_t)(cursor.GetPos() - file->begin());
+      cursor.SkipToOnLine('"');
+      if (!cursor.Consume('"')) {
+        error = parsing::FormatError(path, cursor.GetLine(), "Unterminated environment state.");
+        file.Delete();
+        return false;
+      }
+      record.length = (size_t)(cursor.GetPos() - file->begin()) - record.begin - 1;
+      // See AagosWorld::SetupEnvironmentFile.
+      const std::string prefix(file->begin() + record.begin, std::min<size_t>(record.length, 24));
+      record.summary = (prefix.compare(0, 23, "procedural NK landscape") == 0
+                        || prefix.compare(0, 19, "shared NK landscape") == 0);
+      records.emplace_back(record);
+      cursor.SkipLine();
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const EnvRecord & a, const EnvRecord & b) { return a.update < b.update; });
+    if (env_file != nullptr) env_file.Delete();
+    env_file = file;
+    env_records = std::move(records);
+    return true;
+  }
+
+  bool AddConfig(const std::string & path) {
+    parsing::MappedFile file(path);
+    if (!file.IsOpen()) { error = file.GetError(); return false; }
+    // Rows: parameter,value
+    emp::vector<std::pair<std::string, std::string>> params;
+    parsing::Cursor cursor(file);
+    cursor.SkipLine(); // Header
+    while (cursor.NextContentLine()) {
+      const char * name_begin = cursor.GetPos();
+      cursor.SkipToOnLine(',');
+      const std::string name(name_begin, cursor.GetPos());
+      if (!cursor.Consume(',')) {
+        error = parsing::FormatError(path, cursor.GetLine(), "Expected parameter,value.");
+        return false;
+      }
+      const char * value_begin = cursor.GetPos();
+      cursor.SkipToOnLine('\n');
+      const char * value_end = cursor.GetPos();
+      while (value_end > value_begin && *(value_end - 1) == '\r') --value_end;
+      params.emplace_back(name, std::string(value_begin, value_end));
+    }
+    config_params = std::move(params);
+    return true;
+  }
+
+public:
+  AagosRunArchive() = default;
+  AagosRunArchive(const AagosRunArchive &) = delete;
+  AagosRunArchive & operator=(const AagosRunArchive &) = delete;
+  ~AagosRunArchive() { if (env_file != nullptr) env_file.Delete(); }
+
+  void Clear() {
+    snapshot_paths.clear();
+    updates.clear();
+    if (env_file != nullptr) env_file.Delete();
+    env_file = nullptr;
+    env_records.clear();
+    config_params.clear();
+    env_log = false;
+    error.clear();
+  }
+
+  /// Add a file from a run's output directory. Files are recognized by name (pop_<update>.csv,
+  /// pop_<update>.bin, environment.csv, run_config.csv, environment_log.bin); other files are ignored.
+  /// Returns false (see GetError) if a recognized file could not be read.
+  bool AddFile(const std::string & path) {
+    const std::string name(GetBaseName(path));
+    if (name == "environment.csv") return AddEnvironment(path);
+    if (name == "run_config.csv") return AddConfig(path);
+    if (name == "environment_log.bin") { env_log = true; return true; }
+    const bool csv = name.size() > 8 && name.compare(name.size() - 4, 4, ".csv") == 0;
+    const bool binary = name.size() > 8 && name.compare(name.size() - 4, 4, ".bin") == 0;
+    if (name.compare(0, 4, "pop_") == 0 && (csv || binary)) {
+      const std::string update_str(name.substr(4, name.size() - 8));
+      size_t update = 0;
+      parsing::Cursor cursor(update_str.data(), update_str.data() + update_str.size());
+      if (cursor.ParseSize(update) && cursor.AtEnd()) return AddSnapshot(path, update, binary);
+    }
+    return true;
+  }
+
+  bool HasSnapshots() const { return updates.size(); }
+  bool HasConfig() const { return config_params.size(); }
+  bool HasEnvironment() const { return env_records.size(); }
+  /// Was the run's environment logged with ENV_LOG (environment_log.bin) instead?
+  bool HasEnvLog() const { return env_log; }
+  /// Do any environment.csv rows only summarize the environment?
+  bool HasEnvSummaries() const {
+    return std::any_of(env_records.begin(), env_records.end(), [](const EnvRecord & record) { return record.summary; });
+  }
+  const std::string & GetError() const { return error; }
+
+  /// Updates with a population snapshot (ascending).
+  const emp::vector<size_t> & GetUpdates() const { return updates; }
+
+  /// Set config to the recorded run's configuration (parameters config doesn't have are ignored).
+  void ApplyConfig(AagosConfig & config) const {
+    for (const auto & param : config_params) {
+      if (config.Has(param.first)) config.Set(param.first, param.second);
+    }
+  }
+
+  /// Load the population recorded at update. Returns false (see GetError) on failure.
+  bool LoadGenomes(size_t update, size_t num_genes, size_t gene_size, emp::vector<genome_t> & genomes) {
+    auto it = snapshot_paths.find(update);
+    if (it == snapshot_paths.end()) {
+      error = "No population snapshot for update " + std::to_string(update) + ".";
+      return false;
+    }
+    const std::string & path = it->second;
+    parsing::MappedFile file(path);
+    if (!file.IsOpen()) { error = file.GetError(); return false; }
+    const bool success = snapshot::IsBinarySnapshot(file)
+      ? snapshot::LoadBinary(file, path, num_genes, gene_size, 0, genomes, error)
+      : snapshot::LoadCSV(file, path, num_genes, gene_size, 0, genomes, error);
+    if (success && !genomes.size()) {
+      error = path + ": Snapshot has no organisms.";
+      return false;
+    }
+    return success;
+  }
+
+  /// Id of the environment record in effect at update (i.e., the latest one recorded at or before
+  /// update), or NO_RECORD if there isn't one.
+  size_t FindEnvRecord(size_t update) const {
+    auto it = std::upper_bound(env_records.begin(), env_records.end(), update,
+                               [](size_t u, const EnvRecord & record) { return u < record.update; });
+    return (it == env_records.begin()) ? NO_RECORD : (size_t)(it - env_records.begin()) - 1;
+  }
+
+  const EnvRecord & GetEnvRecord(size_t record_id) const { return env_records[record_id]; }
+
+  /// Environment state of a record, in the format written to environment.csv.
+  std::string GetEnvState(size_t record_id) const {
+    const EnvRecord & record = env_records[record_id];
+    return std::string(env_file->begin() + record.begin, record.length);
+  }
+};
+
+}
+
+#endif
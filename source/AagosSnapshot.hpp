@@ -0,0 +1,345 @@
+#ifndef AAGOS_SNAPSHOT_HPP
+#define AAGOS_SNAPSHOT_HPP
+
+#include "AagosOrg.hpp"
+#include "AagosParsing.hpp"
+
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+namespace aagos {
+
+/// Loading populations from DoPopulationSnapshot output (pop_<update>.csv) and writing/loading the
+/// equivalent binary snapshots (pop_<update>.bin).
+///
+/// Binary snapshot layout (little-endian):
+///   - Header (48 bytes; see below)
+///   - pop_size uint64 record offsets (relative to the start of the file)
+///   - pop_size records: ancestral_id, num_bits, num_genes gene starts (all uint64), then the genome
+///     bits packed into ceil(num_bits / 64) uint64 words (bit i is bit (i % 64) of word (i / 64)).
+namespace snapshot {
+
+using genome_t = AagosOrg::Genome;
+
+constexpr char MAGIC[8] = {'A','A','G','O','S','P','O','P'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t evo_phase;
+  uint64_t update;
+  uint64_t pop_size;
+  uint64_t num_genes;
+  uint64_t gene_size;
+};
+static_assert(sizeof(Header) == 48, "Binary snapshot header must be 48 bytes.");
+
+/// Does the file look like a CSV population snapshot (i.e., does it start with the snapshot header)?
+inline bool IsCSVSnapshot(const parsing::MappedFile & file) {
+  const std::string prefix("update,evo_phase,org_id,");
+  return file.GetSize() >= prefix.size() && std::memcmp(file.begin(), prefix.data(), prefix.size()) == 0;
+}
+
+inline bool IsBinarySnapshot(const parsing::MappedFile & file) {
+  return file.GetSize() >= sizeof(MAGIC) && std::memcmp(file.begin(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/// Number of threads to use for parsing (0 => one per hardware thread).
+inline size_t GetNumThreads(size_t requested, size_t num_items) {
+#ifdef __EMSCRIPTEN__
+  (void)requested; (void)num_items;
+  return 1;
+#else
+  size_t threads = requested ? requested : (size_t)std::thread::hardware_concurrency();
+  threads = std::max<size_t>(1, threads);
+  // Not worth spinning up threads for tiny populations.
+  return std::min(threads, std::max<size_t>(1, num_items / 256));
+#endif
+}
+
+/// Run fun(begin, end, thread_id) over [0, num_items) split into contiguous blocks.
+template<typename FUN>
+void ParallelFor(size_t num_items, size_t num_threads, FUN fun) {
+#ifndef __EMSCRIPTEN__
+  if (num_threads > 1) {
+    emp::vector<std::thread> workers;
+    const size_t block = (num_items + num_threads - 1) / num_threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      const size_t begin = std::min(num_items, t * block);
+      const size_t end = std::min(num_items, begin + block);
+      workers.emplace_back([&fun, begin, end, t]() { fun(begin, end, t); });
+    }
+    for (auto & worker : workers) worker.join();
+    return;
+  }
+#endif
+  (void)num_threads;
+  fun(0, num_items, 0);
+}
+
+/// Parse a CSV population snapshot. Genomes are loaded from the ancestral_id, gene_starts, and
+/// genome_bitstring columns. Returns false (with error set) on failure.
+inline bool LoadCSV(const parsing::MappedFile & file, const std::string & path, size_t num_genes,
+                    size_t gene_size, size_t num_threads, emp::vector<genome_t> & genomes,
+                    std::string & error)
+{
+  // Find the start of every line so that lines can be parsed independently.
+  emp::vector<const char *> line_starts;
+  for (const char * pos = file.begin(); pos < file.end(); ) {
+    line_starts.emplace_back(pos);
+    const char * nl = (const char *)std::memchr(pos, '\n', (size_t)(file.end() - pos));
+    pos = nl ? nl + 1 : file.end();
+  }
+  auto line_end = [&line_starts, &file](size_t line_id) {
+    return (line_id + 1 < line_starts.size()) ? line_starts[line_id + 1] : file.end();
+  };
+
+  // Locate the columns we need from the header line.
+  const size_t NOT_FOUND = (size_t)-1;
+  size_t ancestral_col = NOT_FOUND, gene_starts_col = NOT_FOUND, bits_col = NOT_FOUND;
+  {
+    const char * pos = line_starts[0];
+    const char * end = line_end(0);
+    for (size_t col = 0; pos < end; ++col) {
+      const char * field_end = pos;
+      while (field_end < end && *field_end != ',' && *field_end != '\n' && *field_end != '\r') ++field_end;
+      const std::string name(pos, field_end);
+      if (name == "ancestral_id") ancestral_col = col;
+      else if (name == "gene_starts") gene_starts_col = col;
+      else if (name == "genome_bitstring") bits_col = col;
+      pos = field_end + 1;
+    }
+  }
+  if (ancestral_col == NOT_FOUND || gene_starts_col == NOT_FOUND || bits_col == NOT_FOUND) {
+    error = parsing::FormatError(path, 1, "Snapshot is missing ancestral_id, gene_starts, or genome_bitstring column.");
+    return false;
+  }
+
+  // Skip blank lines.
+  emp::vector<size_t> org_lines;
+  for (size_t line_id = 1; line_id < line_starts.size(); ++line_id) {
+    parsing::Cursor cursor(line_starts[line_id], line_end(line_id));
+    cursor.SkipWhitespace();
+    if (!cursor.AtEnd()) org_lines.emplace_back(line_id);
+  }
+
+  genomes.clear();
+  genomes.reserve(org_lines.size());
+  for (size_t i = 0; i < org_lines.size(); ++i) genomes.emplace_back(0, num_genes, gene_size);
+  num_threads = GetNumThreads(num_threads, org_lines.size());
+  emp::vector<std::string> errors(num_threads);
+  ParallelFor(org_lines.size(), num_threads, [&](size_t begin, size_t end, size_t thread_id) {
+    for (size_t i = begin; i < end; ++i) {
+      const size_t line_id = org_lines[i];
+      parsing::Cursor cursor(line_starts[line_id], line_end(line_id));
+      genome_t & genome = genomes[i];
+      auto fail = [&](const std::string & msg) {
+        errors[thread_id] = parsing::FormatError(path, line_id + 1, msg);
+      };
+      bool ok = true;
+      for (size_t col = 0; ok && !cursor.AtLineEnd(); ++col) {
+        if (col == ancestral_col) {
+          if (!cursor.ParseSize(genome.ancestral_id)) { fail("Invalid ancestral_id."); ok = false; }
+        } else if (col == gene_starts_col) {
+          // "[s,s,...,s]"
+          if (!cursor.Consume('"') || !cursor.Consume('[')) { fail("Invalid gene_starts."); ok = false; break; }
+          for (size_t g = 0; g < num_genes; ++g) {
+            if ((g && !cursor.Consume(',')) || !cursor.ParseSize(genome.gene_starts[g])) {
+              fail("Expected " + std::to_string(num_genes) + " gene start positions."); ok = false; break;
+            }
+          }
+          if (ok && (!cursor.Consume(']') || !cursor.Consume('"'))) { fail("Unexpected number of gene start positions."); ok = false; }
+        } else if (col == bits_col) {
+          if (!cursor.ParseBits(genome.bits)) { fail("Invalid genome_bitstring."); ok = false; }
+        } else if (cursor.Consume('"')) {
+          // Skip quoted field (may contain commas).
+          cursor.SkipToOnLine('"');
+          cursor.Consume('"');
+        } else {
+          cursor.SkipToOnLine(',');
+        }
+        if (ok && !cursor.AtLineEnd() && !cursor.Consume(',')) { fail("Malformed field " + std::to_string(col) + "."); ok = false; }
+        if (col >= bits_col && col >= gene_starts_col && col >= ancestral_col) break; // Nothing else needed.
+      }
+      if (!ok) return;
+      if (!genome.bits.GetSize()) { fail("Missing genome_bitstring."); return; }
+      for (size_t start : genome.gene_starts) {
+        if (start >= genome.bits.GetSize()) { fail("Gene start position is beyond the end of the genome."); return; }
+      }
+    }
+  });
+  for (const std::string & thread_error : errors) {
+    if (thread_error.size()) { error = thread_error; return false; }
+  }
+  return true;
+}
+
+/// Number of uint64 words in the record of a genome with num_bits bits.
+inline size_t RecordWords(size_t num_genes, size_t num_bits) { return 2 + num_genes + (num_bits + 63) / 64; }
+
+/// Append genome's record (laid out as in binary snapshots) to words.
+inline void PackRecord(const genome_t & genome, size_t num_genes, emp::vector<uint64_t> & words) {
+  const size_t num_bits = genome.bits.GetSize();
+  words.push_back((uint64_t)genome.ancestral_id);
+  words.push_back((uint64_t)num_bits);
+  for (size_t g = 0; g < num_genes; ++g) words.push_back((uint64_t)genome.gene_starts[g]);
+  for (size_t w = 0; w < num_bits / 64; ++w) words.push_back(genome.bits.GetUInt64(w));
+  if (num_bits % 64) {
+    uint64_t last = 0;
+    for (size_t b = num_bits - num_bits % 64; b < num_bits; ++b) last |= (uint64_t)genome.bits.Get(b) << (b % 64);
+    words.push_back(last);
+  }
+}
+
+/// Read the record at data (with available bytes left) into genome (which must have num_genes gene
+/// starts). Returns the size of the record in bytes, or 0 (with error set) if it is truncated or invalid.
+inline size_t ReadRecord(const char * data, size_t available, size_t num_genes, genome_t & genome,
+                         std::string & error)
+{
+  auto read_u64 = [data](size_t word) {
+    uint64_t value;
+    std::memcpy(&value, data + word * sizeof(uint64_t), sizeof(uint64_t));
+    return value;
+  };
+  const size_t available_words = available / sizeof(uint64_t);
+  if (available_words < 2 + num_genes) {
+    error = "Truncated record.";
+    return 0;
+  }
+  // Bound num_bits by the words left before sizing the record (a corrupt count could overflow it).
+  const uint64_t num_bits = read_u64(1);
+  if (num_bits > (uint64_t)(available_words - 2 - num_genes) * 64) {
+    error = "Truncated genome.";
+    return 0;
+  }
+  const size_t record_words = RecordWords(num_genes, (size_t)num_bits);
+  genome.ancestral_id = read_u64(0);
+  for (size_t g = 0; g < num_genes; ++g) {
+    genome.gene_starts[g] = read_u64(2 + g);
+    if (genome.gene_starts[g] >= num_bits) {
+      error = "Gene start position is beyond the end of the genome.";
+      return 0;
+    }
+  }
+  genome.bits.Resize(num_bits);
+  for (size_t w = 0; w < num_bits / 64; ++w) genome.bits.SetUInt64(w, read_u64(2 + num_genes + w));
+  if (num_bits % 64) {
+    const uint64_t last = read_u64(record_words - 1);
+    for (size_t b = num_bits - num_bits % 64; b < num_bits; ++b) genome.bits.Set(b, (last >> (b % 64)) & 1);
+  }
+  return record_words * sizeof(uint64_t);
+}
+
+/// Unpack the record starting at words[pos] (of num_words) onto the end of genomes, advancing pos
+/// past it. Returns false if the record is truncated or invalid.
+inline bool UnpackRecord(const uint64_t * words, size_t num_words, size_t & pos, size_t num_genes,
+                         size_t gene_size, emp::vector<genome_t> & genomes)
+{
+  if (pos > num_words) return false;
+  genome_t genome(0, num_genes, gene_size);
+  std::string error;
+  const size_t record_bytes = ReadRecord((const char *)(words + pos), (num_words - pos) * sizeof(uint64_t),
+                                         num_genes, genome, error);
+  if (!record_bytes) return false;
+  pos += record_bytes / sizeof(uint64_t);
+  genomes.emplace_back(std::move(genome));
+  return true;
+}
+
+/// Load a binary population snapshot. Returns false (with error set) on failure.
+inline bool LoadBinary(const parsing::MappedFile & file, const std::string & path, size_t num_genes,
+                       size_t gene_size, size_t num_threads, emp::vector<genome_t> & genomes,
+                       std::string & error)
+{
+  if (file.GetSize() < sizeof(Header)) {
+    error = path + ": Truncated binary snapshot header.";
+    return false;
+  }
+  Header header;
+  std::memcpy(&header, file.begin(), sizeof(Header));
+  if (header.version != VERSION) {
+    error = path + ": Unsupported binary snapshot version (" + std::to_string(header.version) + ").";
+    return false;
+  }
+  if (header.num_genes != num_genes || header.gene_size != gene_size) {
+    error = path + ": Snapshot has " + std::to_string(header.num_genes) + " genes of size "
+            + std::to_string(header.gene_size) + "; expected " + std::to_string(num_genes)
+            + " genes of size " + std::to_string(gene_size) + ".";
+    return false;
+  }
+  const size_t pop_size = header.pop_size;
+  if (pop_size > (file.GetSize() - sizeof(Header)) / sizeof(uint64_t)) {
+    error = path + ": Truncated binary snapshot offset table.";
+    return false;
+  }
+  genomes.clear();
+  genomes.reserve(pop_size);
+  for (size_t i = 0; i < pop_size; ++i) genomes.emplace_back(0, num_genes, gene_size);
+  num_threads = GetNumThreads(num_threads, pop_size);
+  emp::vector<std::string> errors(num_threads);
+  ParallelFor(pop_size, num_threads, [&](size_t begin, size_t end, size_t thread_id) {
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t offset;
+      std::memcpy(&offset, file.begin() + sizeof(Header) + i * sizeof(uint64_t), sizeof(uint64_t));
+      std::string record_error("Truncated record.");
+      if (offset > file.GetSize()
+          || !ReadRecord(file.begin() + offset, file.GetSize() - offset, num_genes, genomes[i], record_error)) {
+        errors[thread_id] = path + ": Organism " + std::to_string(i) + ": " + record_error;
+        return;
+      }
+    }
+  });
+  for (const std::string & thread_error : errors) {
+    if (thread_error.size()) { error = thread_error; return false; }
+  }
+  return true;
+}
+
+/// Write a binary population snapshot. get_genome(i) should return the genome of organism i.
+template<typename GET_GENOME_FUN>
+bool WriteBinary(const std::string & path, size_t update, size_t evo_phase, size_t pop_size,
+                 size_t num_genes, size_t gene_size, GET_GENOME_FUN get_genome)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) return false;
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.evo_phase = (uint32_t)evo_phase;
+  header.update = update;
+  header.pop_size = pop_size;
+  header.num_genes = num_genes;
+  header.gene_size = gene_size;
+  out.write((const char *)&header, sizeof(Header));
+  // Offset table.
+  uint64_t offset = sizeof(Header) + pop_size * sizeof(uint64_t);
+  for (size_t i = 0; i < pop_size; ++i) {
+    out.write((const char *)&offset, sizeof(uint64_t));
+    offset += RecordWords(num_genes, get_genome(i).bits.GetSize()) * sizeof(uint64_t);
+  }
+  // Records.
+  emp::vector<uint64_t> record;
+  for (size_t i = 0; i < pop_size; ++i) {
+    record.clear();
+    PackRecord(get_genome(i), num_genes, record);
+    out.write((const char *)record.data(), (std::streamsize)(record.size() * sizeof(uint64_t)));
+  }
+  return (bool)out;
+}
+
+}
+
+}
+
+#endif
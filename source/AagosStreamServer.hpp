@@ -0,0 +1,375 @@
+#ifndef AAGOS_STREAM_SERVER_HPP
+#define AAGOS_STREAM_SERVER_HPP
+
+#include "AagosPopFrame.hpp"
+
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace aagos {
+
+/// Minimal WebSocket (RFC 6455) helpers for streaming frames to the web interface.
+namespace stream {
+
+/// SHA-1 digest of msg (only used for the WebSocket handshake).
+inline std::string SHA1(const std::string & msg) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::string data(msg);
+  const uint64_t bit_len = (uint64_t)msg.size() * 8;
+  data += (char)0x80;
+  while (data.size() % 64 != 56) data += (char)0;
+  for (int i = 7; i >= 0; --i) data += (char)((bit_len >> (i * 8)) & 0xFF);
+  auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+  for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+    uint32_t w[80];
+    for (size_t i = 0; i < 16; ++i) {
+      w[i] = ((uint32_t)(unsigned char)data[chunk + 4*i] << 24) | ((uint32_t)(unsigned char)data[chunk + 4*i + 1] << 16)
+           | ((uint32_t)(unsigned char)data[chunk + 4*i + 2] << 8) | (uint32_t)(unsigned char)data[chunk + 4*i + 3];
+    }
+    for (size_t i = 16; i < 80; ++i) w[i] = rotl(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (size_t i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+      const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  std::string digest;
+  for (uint32_t word : h) {
+    for (int i = 3; i >= 0; --i) digest += (char)((word >> (i * 8)) & 0xFF);
+  }
+  return digest;
+}
+
+inline std::string Base64Encode(const std::string & data) {
+  static const char * chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < data.size(); i += 3) {
+    const size_t n = std::min<size_t>(3, data.size() - i);
+    uint32_t block = (uint32_t)(unsigned char)data[i] << 16;
+    if (n > 1) block |= (uint32_t)(unsigned char)data[i + 1] << 8;
+    if (n > 2) block |= (uint32_t)(unsigned char)data[i + 2];
+    out += chars[(block >> 18) & 0x3F];
+    out += chars[(block >> 12) & 0x3F];
+    out += (n > 1) ? chars[(block >> 6) & 0x3F] : '=';
+    out += (n > 2) ? chars[block & 0x3F] : '=';
+  }
+  return out;
+}
+
+/// Value of the Sec-WebSocket-Accept header for a client's Sec-WebSocket-Key.
+inline std::string AcceptKey(const std::string & key) {
+  return Base64Encode(SHA1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+}
+
+}
+
+/// Non-blocking WebSocket server (bound to localhost) that pushes serialized AagosPopFrames to
+/// attached web interfaces. The simulation drives it: call Poll once per generation; it returns
+/// true when a frame is wanted (a client is attached, the stream interval has elapsed, and every
+/// client has taken the previous frame), in which case capture a frame and pass it to SendFrame.
+/// Clients may send a 4-byte little-endian draw mode request (bit 0: full population, bit 1:
+/// population summary); otherwise only the most fit organism is streamed.
+class AagosStreamServer {
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  enum REQUEST_FLAGS : uint32_t { FULL_POP=1, SUMMARY=2 };
+
+protected:
+  static constexpr size_t MAX_HANDSHAKE_SIZE = 8192;
+
+  struct Client {
+    int fd=-1;
+    bool open=false;          ///< Has the handshake completed?
+    bool needs_env=true;      ///< Has this client not been sent the current environment?
+    uint32_t request=0;       ///< Draw mode flags (REQUEST_FLAGS).
+    std::string inbox;        ///< Received bytes not yet processed.
+    std::string outbox;       ///< Bytes not yet sent.
+  };
+
+  int listen_fd=-1;
+  emp::vector<Client> clients;
+  clock_t::duration interval;
+  clock_t::time_point next_poll;
+  emp::vector<emp::BitVector> last_env;   ///< Environment most recently streamed.
+  emp::vector<unsigned char> buffer;
+
+  void Drop(Client & client) {
+    if (client.fd >= 0) close(client.fd);
+    client.fd = -1;
+  }
+
+  /// Send as much of client's outbox as the socket will take.
+  void Flush(Client & client) {
+    while (client.fd >= 0 && client.outbox.size()) {
+      const ssize_t sent = send(client.fd, client.outbox.data(), client.outbox.size(), MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) Drop(client);
+        return;
+      }
+      client.outbox.erase(0, (size_t)sent);
+    }
+  }
+
+  static void AppendMessage(std::string & out, uint8_t opcode, const char * data, size_t size) {
+    out += (char)(0x80 | opcode); // Final fragment
+    if (size < 126) {
+      out += (char)size;
+    } else if (size < 65536) {
+      out += (char)126;
+      out += (char)((size >> 8) & 0xFF);
+      out += (char)(size & 0xFF);
+    } else {
+      out += (char)127;
+      for (int i = 7; i >= 0; --i) out += (char)(((uint64_t)size >> (i * 8)) & 0xFF);
+    }
+    out.append(data, size);
+  }
+
+  /// Complete the handshake once client's full HTTP upgrade request has arrived.
+  void Handshake(Client & client) {
+    const size_t header_end = client.inbox.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+      if (client.inbox.size() > MAX_HANDSHAKE_SIZE) Drop(client);
+      return;
+    }
+    std::string key;
+    size_t line_begin = 0;
+    while (line_begin < header_end) {
+      size_t line_end = client.inbox.find("\r\n", line_begin);
+      const std::string line(client.inbox, line_begin, line_end - line_begin);
+      line_begin = line_end + 2;
+      const size_t colon = line.find(':');
+      if (colon == std::string::npos) continue;
+      std::string name(line, 0, colon);
+      for (char & c : name) c = (char)std::tolower((unsigned char)c);
+      if (name != "sec-websocket-key") continue;
+      const size_t value_begin = line.find_first_not_of(" \t", colon + 1);
+      const size_t value_end = line.find_last_not_of(" \t");
+      if (value_begin != std::string::npos) key = line.substr(value_begin, value_end - value_begin + 1);
+    }
+    if (key.empty()) {
+      const std::string response("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+      send(client.fd, response.data(), response.size(), MSG_NOSIGNAL);
+      Drop(client);
+      return;
+    }
+    client.outbox += "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + stream::AcceptKey(key) + "\r\n\r\n";
+    client.inbox.erase(0, header_end + 4);
+    client.open = true;
+    std::cout << "Web interface attached to stream." << std::endl;
+  }
+
+  /// Process complete messages in client's inbox.
+  void ProcessMessages(Client & client) {
+    while (client.fd >= 0) {
+      const std::string & in = client.inbox;
+      if (in.size() < 2) return;
+      const uint8_t opcode = (uint8_t)in[0] & 0x0F;
+      const bool masked = (uint8_t)in[1] & 0x80;
+      uint64_t size = (uint8_t)in[1] & 0x7F;
+      size_t pos = 2;
+      if (size == 126) {
+        if (in.size() < 4) return;
+        size = ((uint64_t)(uint8_t)in[2] << 8) | (uint8_t)in[3];
+        pos = 4;
+      } else if (size == 127) {
+        if (in.size() < 10) return;
+        size = 0;
+        for (size_t i = 0; i < 8; ++i) size = (size << 8) | (uint8_t)in[2 + i];
+        pos = 10;
+      }
+      // Clients only send small control messages.
+      if (!masked || size > MAX_HANDSHAKE_SIZE) { Drop(client); return; }
+      if (in.size() < pos + 4 + size) return;
+      const char * mask = in.data() + pos;
+      std::string payload(in, pos + 4, (size_t)size);
+      for (size_t i = 0; i < payload.size(); ++i) payload[i] ^= mask[i % 4];
+      client.inbox.erase(0, pos + 4 + (size_t)size);
+      if (opcode == 0x8) {          // Close
+        AppendMessage(client.outbox, 0x8, payload.data(), emp::Min<size_t>(payload.size(), 2));
+        Flush(client);
+        Drop(client);
+        std::cout << "Web interface detached from stream." << std::endl;
+      } else if (opcode == 0x9) {   // Ping
+        AppendMessage(client.outbox, 0xA, payload.data(), payload.size());
+      } else if (opcode == 0x2 && payload.size() == sizeof(uint32_t)) {
+        client.request = (uint32_t)(uint8_t)payload[0] | ((uint32_t)(uint8_t)payload[1] << 8)
+                       | ((uint32_t)(uint8_t)payload[2] << 16) | ((uint32_t)(uint8_t)payload[3] << 24);
+      }
+    }
+  }
+
+  void AcceptClients() {
+    while (true) {
+      const int fd = accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) return;
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+      const int flag = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+      clients.emplace_back();
+      clients.back().fd = fd;
+    }
+  }
+
+  void ReceiveFromClients() {
+    char recv_buffer[4096];
+    for (Client & client : clients) {
+      while (client.fd >= 0) {
+        const ssize_t received = recv(client.fd, recv_buffer, sizeof(recv_buffer), 0);
+        if (received == 0) { Drop(client); break; }
+        if (received < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK) Drop(client);
+          break;
+        }
+        client.inbox.append(recv_buffer, (size_t)received);
+      }
+      if (client.fd < 0) continue;
+      if (!client.open) Handshake(client);
+      if (client.open) ProcessMessages(client);
+      Flush(client);
+    }
+    // Forget dropped clients.
+    size_t kept = 0;
+    for (size_t i = 0; i < clients.size(); ++i) {
+      if (clients[i].fd < 0) continue;
+      if (kept != i) clients[kept] = std::move(clients[i]);
+      ++kept;
+    }
+    clients.resize(kept);
+  }
+
+public:
+  AagosStreamServer(double interval_ms)
+    : interval(std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double, std::milli>(interval_ms))),
+      next_poll(clock_t::now()) { ; }
+
+  AagosStreamServer(const AagosStreamServer &) = delete;
+  AagosStreamServer & operator=(const AagosStreamServer &) = delete;
+
+  ~AagosStreamServer() {
+    for (Client & client : clients) Drop(client);
+    if (listen_fd >= 0) close(listen_fd);
+  }
+
+  /// Listen for web interfaces on localhost:port. Returns false on failure.
+  bool Start(size_t port) {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+      std::cout << "Failed to create stream socket." << std::endl;
+      return false;
+    }
+    const int flag = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 4) != 0) {
+      std::cout << "Failed to listen for stream connections on port " << port << "." << std::endl;
+      close(listen_fd);
+      listen_fd = -1;
+      return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+    std::cout << "Streaming to web interfaces at ws://localhost:" << port << std::endl;
+    return true;
+  }
+
+  /// Service connections (at most once per stream interval). Returns true if a frame should be
+  /// captured and sent now.
+  bool Poll() {
+    if (listen_fd < 0) return false;
+    const clock_t::time_point now = clock_t::now();
+    if (now < next_poll) return false;
+    next_poll = now + interval;
+    AcceptClients();
+    ReceiveFromClients();
+    bool wanted = false;
+    for (const Client & client : clients) {
+      if (!client.open) continue;
+      if (client.outbox.size()) return false; // Wait for slow clients instead of queuing frames.
+      wanted = true;
+    }
+    return wanted;
+  }
+
+  /// Is at least one web interface attached?
+  bool HasClients() const {
+    for (const Client & client : clients) if (client.open) return true;
+    return false;
+  }
+
+  /// Draw mode flags to capture frames with (the union of all clients' requests).
+  uint32_t GetRequest() const {
+    uint32_t request = 0;
+    for (const Client & client : clients) request |= client.request;
+    return request;
+  }
+  bool WantsFullPop() const { return GetRequest() & FULL_POP; }
+  bool WantsSummary() const { return GetRequest() & SUMMARY; }
+
+  /// Send frame to all attached clients. The environment is only sent when it has changed (or to
+  /// clients that haven't been sent it yet).
+  void SendFrame(AagosPopFrame & frame) {
+    bool needs_env = false;
+    for (const Client & client : clients) needs_env = needs_env || (client.open && client.needs_env);
+    if (frame.has_env) {
+      if (!needs_env && frame.gradient_env == last_env) frame.has_env = false;
+      else last_env = frame.gradient_env;
+    }
+    frame.Serialize(buffer);
+    std::string message;
+    AppendMessage(message, 0x2, (const char *)buffer.data(), buffer.size());
+    for (Client & client : clients) {
+      if (!client.open || client.fd < 0) continue;
+      client.outbox += message;
+      if (frame.has_env) client.needs_env = false;
+      Flush(client);
+    }
+  }
+
+  /// Try to finish sending queued output (e.g., the final frame) for up to timeout_ms.
+  void Drain(double timeout_ms) {
+    const clock_t::time_point stop = clock_t::now()
+      + std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double, std::milli>(timeout_ms));
+    while (clock_t::now() < stop) {
+      bool pending = false;
+      for (Client & client : clients) {
+        Flush(client);
+        pending = pending || (client.fd >= 0 && client.outbox.size());
+      }
+      if (!pending) return;
+      usleep(1000);
+    }
+  }
+};
+
+}
+
+#endif
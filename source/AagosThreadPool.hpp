@@ -0,0 +1,126 @@
+#ifndef AAGOS_THREAD_POOL_HPP
+#define AAGOS_THREAD_POOL_HPP
+
+#include "emp/base/vector.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Web builds only have threads with pthreads enabled (make web-threads), and then only as many as
+// were pre-spawned into the pthread pool (blocking the main thread on a thread that has to be
+// spawned later would deadlock).
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define AAGOS_NO_THREADS
+#endif
+#ifndef AAGOS_WEB_THREADS
+#define AAGOS_WEB_THREADS 4
+#endif
+
+namespace aagos {
+
+/// Persistent worker threads for splitting per-generation work (e.g., population evaluation).
+/// Threads are started once and reused, so Run is cheap enough to call every generation.
+class AagosThreadPool {
+protected:
+  emp::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  std::function<void(size_t, size_t, size_t)> task;
+  size_t num_items=0;
+  size_t generation=0;     ///< Incremented for each Run (wakes workers).
+  size_t remaining=0;      ///< Workers still running the current task.
+  bool stopping=false;
+
+  /// Items [begin, end) handled by thread thread_id (of GetNumThreads()).
+  void GetBlock(size_t thread_id, size_t & begin, size_t & end) const {
+    const size_t num_threads = GetNumThreads();
+    const size_t block = (num_items + num_threads - 1) / num_threads;
+    begin = std::min(num_items, thread_id * block);
+    end = std::min(num_items, begin + block);
+  }
+
+  void WorkerLoop(size_t thread_id) {
+    size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        start_cv.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+      size_t begin, end;
+      GetBlock(thread_id, begin, end);
+      if (begin < end) task(begin, end, thread_id);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--remaining == 0) done_cv.notify_one();
+    }
+  }
+
+public:
+  /// Number of threads to use for a request of requested threads (0 => one per hardware thread).
+  static size_t ResolveNumThreads(size_t requested) {
+#ifdef AAGOS_NO_THREADS
+    (void)requested;
+    return 1;
+#else
+    size_t threads = requested ? requested : (size_t)std::thread::hardware_concurrency();
+    threads = std::max<size_t>(1, threads);
+#ifdef EMSCRIPTEN
+    threads = std::min<size_t>(threads, AAGOS_WEB_THREADS);
+#endif
+    return threads;
+#endif
+  }
+
+  /// Start a pool with num_threads threads in total (the calling thread counts as one).
+  AagosThreadPool(size_t num_threads=1) {
+    num_threads = ResolveNumThreads(num_threads);
+    for (size_t t = 1; t < num_threads; ++t) {
+      workers.emplace_back([this, t]() { WorkerLoop(t); });
+    }
+  }
+
+  AagosThreadPool(const AagosThreadPool &) = delete;
+  AagosThreadPool & operator=(const AagosThreadPool &) = delete;
+
+  ~AagosThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto & worker : workers) worker.join();
+  }
+
+  size_t GetNumThreads() const { return workers.size() + 1; }
+
+  /// Run fun(begin, end, thread_id) over [0, items) split into contiguous blocks (one per thread),
+  /// returning once all blocks are done.
+  void Run(size_t items, const std::function<void(size_t, size_t, size_t)> & fun) {
+    if (workers.empty() || items < 2) {
+      fun(0, items, 0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      task = fun;
+      num_items = items;
+      remaining = workers.size();
+      ++generation;
+    }
+    start_cv.notify_all();
+    size_t begin, end;
+    GetBlock(0, begin, end);
+    if (begin < end) fun(begin, end, 0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&]() { return remaining == 0; });
+  }
+};
+
+}
+
+#endif
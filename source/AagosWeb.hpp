@@ -9,7 +9,9 @@
 #include "AagosWorld.hpp"
 #include "AagosConfig.hpp"
 #include "AagosOrg.hpp"
+#include "AagosPopFrame.hpp"
 #include "AagosPopulationVisualization.hpp"
+#include "AagosRunArchive.hpp"
 
 #include "emp/web/web.hpp"
 #include "emp/web/Input.hpp"
@@ -17,8 +19,11 @@
 #include "emp/tools/string_utils.hpp"
 
 #include <unordered_map>
+#include <fstream>
 #include <sstream>
 
+#include <emscripten.h>
+
 
 namespace UI = emp::web;
 
@@ -75,7 +80,10 @@ bool is_numeric(const std::string & str) {
     return !i.fail() && i.eof();
 }
 
-class AagosWebInterface : public UI::Animate, public AagosWorld {
+/// Web interface. By default, the world steps on the main thread between animation frames. If built with
+/// AAGOS_WEB_WORKER (make web-worker, which builds into web/worker/), the world instead steps inside a Web Worker (see
+/// source/web/Aagos-worker.cc), and this interface only renders the frames that the worker posts back.
+class AagosWebInterface : public UI::Animate, public aagos::AagosWorld {
 public:
   // static constexpr double BIT_WIDTH
   static constexpr double BIT_HEIGHT = 20;
@@ -83,14 +91,15 @@ public:
   static constexpr double GENE_TARGET_IDENTIFER_HEIGHT = 5;
   static constexpr double INDIV_VERT_MARGIN = 5;
 
-  using config_t = AagosConfig;
+  using config_t = aagos::AagosConfig;
   using canvas_draw_fun_t = std::function<void(void)>;
   using input_callback_fun_t = std::function<void(std::string)>;
   using input_checker_fun_t = std::function<bool(std::string)>;
 
-  using org_t = AagosOrg;
-  using genome_t = AagosOrg::Genome;
-  using phenotype_t = AagosOrg::Phenotype;
+  using org_t = aagos::AagosOrg;
+  using genome_t = aagos::AagosOrg::Genome;
+  using phenotype_t = aagos::AagosOrg::Phenotype;
+  using frame_t = aagos::AagosPopFrame;
 
 protected:
 
@@ -111,6 +120,8 @@ protected:
   UI::Button config_apply_but;
   UI::Button confirm_config_exp_but;
   UI::Button draw_mode_toggle_but;
+  UI::Button playback_exit_but;
+  UI::Button stream_toggle_but;
 
   std::unordered_map<std::string, UI::Input> config_input_elements;
 
@@ -118,11 +129,64 @@ protected:
   size_t generation_last_drawn=0;
   bool config_mode=false;
 
+  // Time-budgeted stepping: while running, each animation frame runs as many generations as fit in
+  // step_budget_ms before rendering (0 => one generation per frame).
+  double step_budget_ms=12.0;
+  double gens_per_sec=0.0;        ///< Measured over roughly the last second of running.
+  double rate_window_start=0.0;   ///< When (emscripten_get_now) the current measurement window began.
+  size_t rate_window_gens=0;      ///< Generations run in the current measurement window.
+
   AagosPopulationVisualization pop_vis;
 
+  frame_t frame;    ///< Most recent frame (everything drawn comes from here).
+
+  // Playback of recorded runs: recorded files are copied into PLAYBACK_DIR (in the in-browser file
+  // system). This world is set up once per recording, and each recorded update is shown by swapping
+  // in its population and environment.
+  const std::string PLAYBACK_DIR = "/playback/";
+  const std::string PLAYBACK_OUTPUT_DIR = "/playback-output/";
+  aagos::AagosRunArchive playback;
+  bool playback_mode=false;
+  size_t playback_index=0;
+  size_t playback_pop_size=0;   ///< Population size the world is set up for (0 => not set up yet).
+  size_t playback_env_record=aagos::AagosRunArchive::NO_RECORD;  ///< Environment record in the world.
+  std::string saved_config;   ///< Configuration to restore when leaving playback.
+
+  // Attaching to a native run: frames streamed by the run's AagosStreamServer (over a WebSocket)
+  // are shown in place of this world's.
+  const std::string DEFAULT_STREAM_ADDRESS = "ws://localhost:8765";
+  bool stream_mode=false;
+  size_t stream_num_genes=0;                ///< Number of genes pop_vis is set up for.
+  emp::vector<unsigned char> stream_buffer; ///< Most recently received streamed frame.
+
+  #ifdef AAGOS_WEB_WORKER
+  worker_handle worker=0;
+  bool worker_busy=false;             ///< Waiting on a response from the worker?
+  emp::vector<unsigned char> request_buffer;
+
+  void ConfigureWorker();
+  void RequestWorkerStep(size_t max_gens, bool force_full=false);
+  void ReceiveFrame(const char * data, int size);
+  static void OnWorkerResponse(char * data, int size, void * arg) {
+    ((AagosWebInterface *)arg)->ReceiveFrame(data, size);
+  }
+  #endif
+
   void RedrawPopulation(bool update_data=true);
   void RedrawEnvironment();
   void ReconfigureWorld();
+  void StopRun();
+  void RecordGenerations(size_t gens);
+
+  void LoadPlayback(const std::string & paths);
+  void SetupPlaybackWorld(size_t pop_size);
+  void ShowPlaybackFrame(size_t index);
+  void LeavePlayback();
+
+  void AttachStream();
+  void DetachStream();
+  void SendStreamRequest();
+  void ReceiveStreamFrame(size_t size);
 
   void SetupConfigInterface();
   void SetupStatsViewInterface();
@@ -259,7 +323,7 @@ protected:
 
 public:
   AagosWebInterface(config_t & cfg)
-    : AagosWorld(cfg),
+    : aagos::AagosWorld(cfg),
       world_div("emp_world_view"),
       stats_div("emp_world_stats_view"),
       pop_vis_div("emp_pop_vis_view"),
@@ -309,6 +373,17 @@ void AagosWebInterface::SetupInterface() {
     config_exp_but.SetDisabled(active);
   }, "do_reset_world");
 
+  emp::JSWrap([this](std::string paths) { LoadPlayback(paths); }, "aagos_load_playback");
+  emp::JSWrap([this](size_t index) { ShowPlaybackFrame(index); }, "aagos_show_playback_frame");
+
+  emp::JSWrap([this]() { AttachStream(); }, "aagos_stream_opened");
+  emp::JSWrap([this]() { DetachStream(); }, "aagos_stream_closed");
+  emp::JSWrap([this](size_t size) {
+    stream_buffer.resize(size);
+    return reinterpret_cast<size_t>(stream_buffer.data());
+  }, "aagos_stream_buffer");
+  emp::JSWrap([this](size_t size) { ReceiveStreamFrame(size); }, "aagos_receive_stream_frame");
+
   // ---- Setup interface control buttons ----
   // Run button setup.
   // Manually create run/pause button to have full control over button's callback.
@@ -380,17 +455,31 @@ void AagosWebInterface::SetupInterface() {
   confirm_config_exp_but.SetAttr("data-dismiss", "modal");
   confirm_exp_config_div << confirm_config_exp_but;
 
+  // Cycles draw modes: max fit organism => full population => population summary => ...
   draw_mode_toggle_but = UI::Button([this]() {
     if (pop_vis.IsDrawModeFullPop()) {
-      pop_vis.SetDrawModeMaxFit();
-      draw_mode_toggle_but.SetLabel("Draw Full Population");
+      pop_vis.SetDrawModeSummary();
+      draw_mode_toggle_but.SetLabel("Draw Max Fitness Organism");
     } else if (pop_vis.IsDrawModeMaxFit()) {
       pop_vis.SetDrawModeFullPop();
-      draw_mode_toggle_but.SetLabel("Draw Max Fitness Organism");
+      draw_mode_toggle_but.SetLabel("Draw Population Summary");
+    } else if (pop_vis.IsDrawModeSummary()) {
+      pop_vis.SetDrawModeMaxFit();
+      draw_mode_toggle_but.SetLabel("Draw Full Population");
     }
-    if (!config_mode) {
+    if (playback_mode) {
+      ShowPlaybackFrame(playback_index);
+    } else if (stream_mode) {
+      SendStreamRequest(); // Next streamed frame will be in the new mode.
+    } else if (!config_mode) {
+      #ifdef AAGOS_WEB_WORKER
+      if (!worker_busy) RequestWorkerStep(0, true); // Re-draw current generation in new mode.
+      #else
+      // Recapture the current generation in the new mode (evaluated first if drift mode skipped it).
+      frame.Capture(*this, pop_vis.IsDrawModeFullPop(), true, pop_vis.IsDrawModeSummary());
       RedrawPopulation(true); // update data, disable tooltips
       RedrawEnvironment();
+      #endif
     }
   }, "Draw Full Population", "population-draw-mode-toggle-button");
   draw_mode_toggle_but.SetAttr("class", "btn btn-block btn-lg btn-secondary");
@@ -450,6 +539,120 @@ void AagosWebInterface::SetupInterface() {
     << UI::Text().SetAttr("class", "input-group-text")
     << "generations";
 
+  control_div.Div("button-row")
+    << UI::Div("step-budget-col").SetAttr("class", "col-lg-auto p-2")
+    << UI::Div("step-budget-wrapper")
+        .SetAttr("class", "input-group input-group-md")
+        .SetAttr("data-toggle", "tooltip")
+        .SetAttr("data-placement", "top")
+        .SetAttr("title", "While running, how many milliseconds of each animation frame to spend running generations (0 for one generation per frame)")
+    << UI::Div("step-budget-input-prepend").SetAttr("class", "input-group-prepend")
+    << UI::Div("step-budget-input-prepend-text").SetAttr("class", "input-group-text")
+    << "Step for";
+
+  control_div.Div("step-budget-wrapper")
+    << UI::Input([this](std::string in) {
+                  step_budget_ms = emp::from_string<double>(in);
+                 },
+                 "number",
+                 "",
+                 "step-budget")
+        .Checker([this](std::string in) { return CheckInputDouble(in) && emp::from_string<double>(in) >= 0.0; })
+        .Value(step_budget_ms)
+        .Min(0)
+        .Max(1000)
+        .Step(1)
+        .SetAttr("class", "form-control")
+        .SetCSS("min-width", "64px");
+
+  control_div.Div("step-budget-wrapper")
+    << UI::Div("step-budget-input-append").SetAttr("class", "input-group-append")
+    << UI::Text().SetAttr("class", "input-group-text")
+    << "ms per frame";
+
+  // Playback controls: load a recorded run's output files (population snapshots, environment.csv,
+  // run_config.csv), then scrub through its snapshots.
+  playback_exit_but = UI::Button([this]() {
+    ReconfigureWorld(); // Leaves playback.
+    run_reset_but.SetDisabled(false);
+    run_toggle_but.SetDisabled(false);
+    run_step_but.SetDisabled(false);
+    config_exp_but.SetDisabled(false);
+  }, "Exit Playback", "playback-exit-button");
+  playback_exit_but.SetAttr("class", "btn btn-block btn-lg btn-secondary");
+
+  control_div << UI::Div("playback-row").SetAttr("class", "row justify-content-md-center");
+  control_div.Div("playback-row")
+    << UI::Div("playback-load-col").SetAttr("class", "col-lg-auto p-2")
+    << UI::Element("label", "playback-load-label")
+        .SetAttr("class", "btn btn-block btn-lg btn-secondary mb-0")
+        .SetAttr("for", "playback-file-input")
+        .SetAttr("data-toggle", "tooltip")
+        .SetAttr("data-placement", "top")
+        .SetAttr("title", "Select a run's output files (pop_<update>.csv/.bin snapshots, environment.csv, run_config.csv) to play back")
+    << "Load Recorded Run";
+  control_div.Div("playback-load-col")
+    << UI::Element("input", "playback-file-input")
+        .SetAttr("type", "file")
+        .SetAttr("multiple", "multiple")
+        .SetAttr("class", "d-none");
+  // Attach to (or detach from) a native run streaming frames (see WEB_STREAM_PORT).
+  stream_toggle_but = UI::Button([this]() {
+    if (stream_mode) {
+      EM_ASM({
+        const ws = window.aagos_stream;
+        window.aagos_stream = null;
+        if (ws) ws.close();
+      });
+      DetachStream();
+      return;
+    }
+    EM_ASM({
+      const address = prompt("Address of native run (started with WEB_STREAM_PORT set):", UTF8ToString($0));
+      if (!address) return;
+      if (window.aagos_stream) window.aagos_stream.close();
+      const ws = new WebSocket(address);
+      ws.binaryType = "arraybuffer";
+      window.aagos_stream = ws;
+      ws.onopen = function() { emp.aagos_stream_opened(); };
+      ws.onmessage = function(event) {
+        const data = new Uint8Array(event.data);
+        const ptr = emp.aagos_stream_buffer(data.length);
+        HEAPU8.set(data, ptr);
+        emp.aagos_receive_stream_frame(data.length);
+      };
+      ws.onclose = function() {
+        if (window.aagos_stream !== ws) return; // Detached from the interface.
+        window.aagos_stream = null;
+        emp.aagos_stream_closed();
+      };
+      ws.onerror = function() { console.log("Failed to connect to " + address); };
+    }, DEFAULT_STREAM_ADDRESS.c_str());
+  }, "Attach to Native Run", "stream-toggle-button");
+  stream_toggle_but.SetAttr("class", "btn btn-block btn-lg btn-secondary");
+  stream_toggle_but.SetAttr("data-toggle", "tooltip");
+  stream_toggle_but.SetAttr("data-placement", "top");
+  stream_toggle_but.SetAttr("title", "Show a native Aagos run (started with WEB_STREAM_PORT set) as it evolves");
+
+  control_div.Div("playback-row")
+    << UI::Div("stream-toggle-col").SetAttr("class", "col-lg-auto p-2")
+    << stream_toggle_but;
+  control_div.Div("playback-row")
+    << UI::Div("playback-slider-col").SetAttr("class", "col-lg p-2 d-none")
+    << UI::Element("label", "playback-update-label").SetAttr("for", "playback-slider")
+    << "Update";
+  control_div.Div("playback-slider-col")
+    << UI::Element("input", "playback-slider")
+        .SetAttr("type", "range")
+        .SetAttr("class", "custom-range")
+        .SetAttr("min", "0")
+        .SetAttr("max", "0")
+        .SetAttr("step", "1")
+        .SetAttr("value", "0");
+  control_div.Div("playback-row")
+    << UI::Div("playback-exit-col").SetAttr("class", "col-lg-auto p-2 d-none")
+    << playback_exit_but;
+
 
   // ---- Setup config view interface ----
   std::cout << "Setup config interface.."<< std::endl;
@@ -467,7 +670,7 @@ void AagosWebInterface::SetupInterface() {
     << UI::Element("span", "generation-counter-badge").SetAttr("class", "badge badge-secondary")
     << "Generation: ";
   world_div.Div("generation-counter-badge")
-    << UI::Live([this]() { return GetUpdate(); });
+    << UI::Live([this]() { return frame.update; });
 
   world_div.Div("hud-row")
     << UI::Div("phase-counter-col").SetAttr("class", "col-sm-auto p-1")
@@ -475,7 +678,7 @@ void AagosWebInterface::SetupInterface() {
     << UI::Element("span", "phase-counter-badge").SetAttr("class", "badge badge-secondary")
     << "Experiment phase: ";
   world_div.Div("phase-counter-badge")
-    << UI::Live([this]() { return cur_phase; });
+    << UI::Live([this]() { return frame.evo_phase; });
 
   world_div.Div("hud-row")
     << UI::Div("last-rendered-col").SetAttr("class", "col-sm-auto p-1")
@@ -485,20 +688,32 @@ void AagosWebInterface::SetupInterface() {
   world_div.Div("generation-last-rendered-counter-badge")
     << UI::Live([this]() { return generation_last_drawn; });
 
+  world_div.Div("hud-row")
+    << UI::Div("gens-per-sec-col").SetAttr("class", "col-sm-auto p-1")
+    << UI::Element("h4", "")
+    << UI::Element("span", "gens-per-sec-badge").SetAttr("class", "badge badge-secondary")
+    << "Generations/sec: ";
+  world_div.Div("gens-per-sec-badge")
+    << UI::Live([this]() { return (size_t)(gens_per_sec + 0.5); });
+
   world_div << UI::Element("hr").SetAttr("class", "mt-1");
 
   // --- Configure stats ---
   SetupStatsViewInterface();
 
   // Initial world configuration + pop canvas configuration.
+  #ifdef AAGOS_WEB_WORKER
+  worker = emscripten_create_worker("Aagos-worker.js");
+  #else
   Setup(); // Call world setup
+  #endif
 
   // ---- Wire up event handlers ----
   UI::OnDocumentReady([this]() {
     std::cout << "-- OnDocumentReady (open) --"<<std::endl;
 
     // Configure
-    pop_vis.Setup(*this);
+    pop_vis.Setup(config.NUM_GENES());
 
     emp::OnResize([this]() {
       std::cout << "Resize?" << std::endl;
@@ -508,7 +723,46 @@ void AagosWebInterface::SetupInterface() {
 
     // RedrawPopulation(true, false); // Finally, go ahead and draw initial population.
     // RedrawEnvironment();
+    #ifdef AAGOS_WEB_WORKER
+    ConfigureWorker(); // Worker sets up its world and responds with the initial frame.
+    #else
     DoFrame();
+    #endif
+
+    // Playback: copy selected files into the in-browser file system, then index them. Slider
+    // changes are handled at most once per animation frame.
+    EM_ASM({
+      const playback_dir = UTF8ToString($0);
+      const playback_output_dir = UTF8ToString($1);
+      try { FS.mkdir(playback_dir); } catch (e) { ; }
+      try { FS.mkdir(playback_output_dir); } catch (e) { ; }
+      $("#playback-file-input").on("change", function() {
+        const files = Array.from(this.files);
+        this.value = "";
+        if (!files.length) return;
+        FS.readdir(playback_dir).forEach(function(name) {
+          if (name != "." && name != "..") FS.unlink(playback_dir + name);
+        });
+        Promise.all(files.map(function(file) {
+          return file.arrayBuffer().then(function(buffer) {
+            const path = playback_dir + file.name;
+            FS.writeFile(path, new Uint8Array(buffer));
+            return path;
+          });
+        })).then(function(paths) { emp.aagos_load_playback(paths.join("\n")); });
+      });
+      var pending_index = null;
+      $("#playback-slider").on("input", function() {
+        const scheduled = (pending_index !== null);
+        pending_index = parseInt(this.value);
+        if (scheduled) return;
+        requestAnimationFrame(function() {
+          const index = pending_index;
+          pending_index = null;
+          emp.aagos_show_playback_frame(index);
+        });
+      });
+    }, PLAYBACK_DIR.c_str(), PLAYBACK_OUTPUT_DIR.c_str());
 
     // Enable tooltips!
     EM_ASM({
@@ -523,81 +777,166 @@ void AagosWebInterface::SetupInterface() {
 }
 
 void AagosWebInterface::DoFrame() {
-  // std::cout << "Frame!" << std::endl;
-  RunStep(false);
-  if (   (GetUpdate() % draw_frequency == 0)
-      || (GetUpdate() == config.MAX_GENS())
-      || (GetUpdate() == TOTAL_GENS))
-  {
-    RedrawPopulation(true);
-    RedrawEnvironment();
+  if (playback_mode) return; // Nothing to simulate; frames come from the recorded run.
+  const bool budgeted = active && (step_budget_ms > 0);
+  #ifdef AAGOS_WEB_WORKER
+  // World steps in the worker; wait for the previous batch of generations before asking for more.
+  // With a step budget, the worker runs until the budget is spent instead of until the next drawn
+  // generation.
+  if (!worker_busy) {
+    RequestWorkerStep(budgeted ? std::numeric_limits<uint32_t>::max() : (active ? draw_frequency : 1));
   }
+  return;
+  #endif
+  // std::cout << "Frame!" << std::endl;
+  // Run generations until the step budget is spent (just one if there is no budget or we're not
+  // running), ending early at phase boundaries so that they are always drawn. The last generation
+  // run is drawn if any generation run should have been.
+  const double start_time = emscripten_get_now();
+  bool draw_pending = false;
+  size_t gens = 0;
+  bool last = false;
+  while (!last) {
+    RunStep(false);
+    ++gens;
+    const bool phase_end = (GetUpdate() == config.MAX_GENS()) || (GetUpdate() == TOTAL_GENS);
+    draw_pending = draw_pending || (GetUpdate() % draw_frequency == 0) || phase_end;
+    last = !budgeted || phase_end || (emscripten_get_now() - start_time >= step_budget_ms);
+    if (last) {
+      // Only capture the full population when we're going to draw it.
+      frame.Capture(*this, draw_pending && pop_vis.IsDrawModeFullPop(), draw_pending,
+                    draw_pending && pop_vis.IsDrawModeSummary());
+      if (draw_pending) {
+        RedrawPopulation(true);
+        RedrawEnvironment();
+      }
+    }
 
-  // Do all the checks, etc
-  if ((cur_phase==0) && (GetUpdate() >= config.MAX_GENS())) {
-    // Trigger phase 1 || stop!
-    if (config.PHASE_2_ACTIVE()) {
-      ActivateEvoPhaseTwo();
-    } else {
-      // Stop!
-      ToggleActive();
-      run_toggle_but.SetLabel("Run");
-      run_toggle_but.SetDisabled(true);
-      run_step_but.SetDisabled(true);
-      config_exp_but.SetDisabled(false);
-      run_reset_but.SetDisabled(false);
+    // Do all the checks, etc
+    if ((cur_phase==0) && (GetUpdate() >= config.MAX_GENS())) {
+      // Trigger phase 1 || stop!
+      if (config.PHASE_2_ACTIVE()) {
+        ActivateEvoPhaseTwo();
+      } else {
+        StopRun();
+      }
+
+    } else if (cur_phase == 1 && GetUpdate() >= TOTAL_GENS) {
+      StopRun();
     }
 
-  } else if (cur_phase == 1 && GetUpdate() >= TOTAL_GENS) {
-    // Trigger stop!
-    ToggleActive();
-    run_toggle_but.SetLabel("Run");
-    run_toggle_but.SetDisabled(true);
-    run_step_but.SetDisabled(true);
-    config_exp_but.SetDisabled(false);
-    run_reset_but.SetDisabled(false);
+    // Manually do the world update + clear world cache.
+    AdvanceWorld();
   }
+  RecordGenerations(gens);
   world_div.Redraw();
   stats_div.Redraw();
+}
+
+void AagosWebInterface::StopRun() {
+  if (active) ToggleActive();
+  run_toggle_but.SetLabel("Run");
+  run_toggle_but.SetDisabled(true);
+  run_step_but.SetDisabled(true);
+  config_exp_but.SetDisabled(false);
+  run_reset_but.SetDisabled(false);
+}
 
-  // std::cout << "Most fit ID = " << GetMostFitID() << std::endl;
-  // std::cout << " - Fitness = " << GetOrg(GetMostFitID()).GetPhenotype().fitness << std::endl;
-  // std::cout << " - Gene contributions = ";
-  // emp::Print(GetOrg(GetMostFitID()).GetPhenotype().gene_fitness_contributions);
-  // std::cout << std::endl;
-  // std::cout << " - Bits = " << GetOrg(GetMostFitID()).GetGenome().bits << std::endl;
-  // std::cout << " - Gene starts = ";
-  // emp::Print(GetOrg(GetMostFitID()).GetGenome().gene_starts);
-  // std::cout << std::endl;
-
-  // Manually do the world update + clear world cache.
-  AdvanceWorld();
+/// Update the generations/sec measurement with gens generations run since the last call. The rate
+/// is only measured while running.
+void AagosWebInterface::RecordGenerations(size_t gens) {
+  const double now = emscripten_get_now();
+  if (!active && !stream_mode) {
+    gens_per_sec = 0.0;
+    rate_window_start = now;
+    rate_window_gens = 0;
+    return;
+  }
+  if (rate_window_start == 0.0) rate_window_start = now;
+  rate_window_gens += gens;
+  if (now - rate_window_start >= 1000.0) {
+    gens_per_sec = 1000.0 * (double)rate_window_gens / (now - rate_window_start);
+    rate_window_start = now;
+    rate_window_gens = 0;
+  }
 }
 
 void AagosWebInterface::RedrawPopulation(bool update_data/*=true*/) {
   if (update_data) {
-    generation_last_drawn = GetUpdate();
+    generation_last_drawn = frame.update;
   }
-  pop_vis.DrawPop(*this, update_data);
+  pop_vis.DrawPop(frame, update_data);
 }
 
 void AagosWebInterface::RedrawEnvironment() {
-  pop_vis.DrawGradientEnv(*this, true);
+  pop_vis.DrawGradientEnv(frame, true);
+}
+
+#ifdef AAGOS_WEB_WORKER
+void AagosWebInterface::ConfigureWorker() {
+  std::ostringstream stream;
+  config.Write(stream);
+  const std::string cfg_str(stream.str());
+  worker_busy = true;
+  emscripten_call_worker(worker, "aagos_worker_configure", (char *)cfg_str.c_str(), (int)cfg_str.size(),
+                         OnWorkerResponse, (void *)this);
 }
 
+void AagosWebInterface::RequestWorkerStep(size_t max_gens, bool force_full/*=false*/) {
+  // Request: max generations, draw frequency, full population?, force full frame?, step budget (us),
+  //          population summary?
+  const bool budgeted = active && (step_budget_ms > 0) && max_gens;
+  const uint32_t request[6] = {(uint32_t)max_gens, (uint32_t)draw_frequency,
+                               (uint32_t)pop_vis.IsDrawModeFullPop(), (uint32_t)force_full,
+                               budgeted ? (uint32_t)(step_budget_ms * 1000.0) : 0u,
+                               (uint32_t)pop_vis.IsDrawModeSummary()};
+  worker_busy = true;
+  emscripten_call_worker(worker, "aagos_worker_step", (char *)request, (int)sizeof(request),
+                         OnWorkerResponse, (void *)this);
+}
+
+void AagosWebInterface::ReceiveFrame(const char * data, int size) {
+  worker_busy = false;
+  if (!size) return; // Worker has no world to report on (yet).
+  if (playback_mode || stream_mode) return; // Keep showing the recorded/native run's frame.
+  const size_t prev_update = frame.update;
+  if (!frame.Deserialize((const unsigned char *)data, (size_t)size)) {
+    // A delta against a frame we no longer hold (e.g., after playback): ask for the whole frame.
+    if (frame.missing_base) RequestWorkerStep(0, true);
+    else std::cout << "Received malformed frame from worker." << std::endl;
+    return;
+  }
+  RecordGenerations(frame.update > prev_update ? frame.update - prev_update : 0);
+  if (config_mode) return; // Don't draw over the configuration view.
+  if (frame.draw) {
+    RedrawPopulation(true);
+    RedrawEnvironment();
+  }
+  if (frame.finished) StopRun();
+  world_div.Redraw();
+  stats_div.Redraw();
+}
+#endif
+
 void AagosWebInterface::ReconfigureWorld() {
   std::cout << "--- reconfigure world ---" << std::endl;
+  if (playback_mode) LeavePlayback();
 
   // Loop over config inputs, reconfiguring.
   for (auto & cfg : config_input_elements) {
     config.Set(cfg.first, cfg.second.GetValue());
   }
+  pop_vis.Setup(config.NUM_GENES()); // Re-configure pop_vis
+  #ifdef AAGOS_WEB_WORKER
+  // Worker sets up its world and responds with the initial frame.
+  ConfigureWorker();
+  #else
   // Setup the world again...
   Setup();
-  pop_vis.Setup(*this); // Re-configure pop_vis
   GetFitnessDataNode()->Reset();
 
   DoFrame();
+  #endif
   // RedrawPopulation(true, false); // Finally, go ahead and draw initial population.
   // RedrawEnvironment();
   // world_div.Redraw();
@@ -605,6 +944,214 @@ void AagosWebInterface::ReconfigureWorld() {
   std::cout << "--- done reconfiguring world ---" << std::endl;
 }
 
+/// Index the recorded run files at paths (newline-separated), switch to the recorded run's
+/// configuration, and show its first snapshot.
+void AagosWebInterface::LoadPlayback(const std::string & paths) {
+  if (stream_mode) {
+    EM_ASM({
+      const ws = window.aagos_stream;
+      window.aagos_stream = null;
+      if (ws) ws.close();
+    });
+    DetachStream();
+  }
+  if (!playback_mode) {
+    std::ostringstream stream;
+    config.Write(stream);
+    saved_config = stream.str();
+  } else {
+    // Start from the configuration we'll return to, not the previous recording's.
+    std::istringstream stream(saved_config);
+    config.Read(stream);
+  }
+  playback.Clear();
+  std::istringstream path_stream(paths);
+  std::string path;
+  while (std::getline(path_stream, path)) {
+    if (path.size() && !playback.AddFile(path)) std::cout << playback.GetError() << std::endl;
+  }
+  if (!playback.HasSnapshots()) {
+    std::cout << "No population snapshots (pop_<update>.csv or pop_<update>.bin) to play back." << std::endl;
+    EM_ASM({ alert("No population snapshots (pop_<update>.csv or pop_<update>.bin) found in the selected files."); });
+    if (!playback_mode) return;
+    LeavePlayback();
+    return;
+  }
+  if (!playback.HasConfig()) std::cout << "No run_config.csv; playing back with the current configuration." << std::endl;
+  if (playback.HasEnvLog() && !playback.HasEnvironment()) {
+    std::cout << "The run logged its environments with ENV_LOG (environment_log.bin), which playback can't read;"
+              << " playing back with a random environment. Use AagosEnvTool materialize to rebuild the environment at an update." << std::endl;
+  } else if (!playback.HasEnvironment()) {
+    std::cout << "No environment.csv; playing back with a random environment." << std::endl;
+  }
+  if (playback.HasEnvSummaries()) {
+    std::cout << "environment.csv only summarizes some environments (large procedural or shared NK landscapes);"
+              << " those updates are played back with a random environment." << std::endl;
+  }
+  playback.ApplyConfig(config);
+  config.LOAD_ANCESTOR(false);
+  config.LOAD_ENV_FROM_FILE(false);
+  config.DATA_FILEPATH(PLAYBACK_OUTPUT_DIR);
+  playback_pop_size = 0; // Set up when the first frame is shown (with that snapshot's size).
+
+  StopRun();
+  run_reset_but.SetDisabled(true);
+  config_exp_but.SetDisabled(true);
+  playback_mode = true;
+  pop_vis.Setup(config.NUM_GENES());
+  EM_ASM({
+    $("#playback-slider").attr("max", $0 - 1).val(0);
+    $("#playback-slider-col").removeClass("d-none");
+    $("#playback-exit-col").removeClass("d-none");
+  }, playback.GetUpdates().size());
+  ShowPlaybackFrame(0);
+}
+
+/// Set up the world for playback with pop_size organisms. Setup builds a random population and
+/// environment; frames replace both.
+void AagosWebInterface::SetupPlaybackWorld(size_t pop_size) {
+  config.POP_SIZE(pop_size);
+  Setup();
+  playback_pop_size = pop_size;
+  playback_env_record = aagos::AagosRunArchive::NO_RECORD;
+}
+
+/// Show the recorded population at the index-th snapshot. The recorded population and environment
+/// are swapped into the world (which is only set up again if the population size changes), and the
+/// population is re-evaluated (so that per-gene fitness contributions are available for drawing).
+void AagosWebInterface::ShowPlaybackFrame(size_t index) {
+  const auto & updates = playback.GetUpdates();
+  if (!playback_mode || index >= updates.size()) return;
+  playback_index = index;
+  const size_t update = updates[index];
+  emp::vector<genome_t> genomes;
+  if (!playback.LoadGenomes(update, config.NUM_GENES(), config.GENE_SIZE(), genomes)) {
+    std::cout << playback.GetError() << std::endl;
+    return;
+  }
+  if (genomes.size() != playback_pop_size) SetupPlaybackWorld(genomes.size());
+  for (size_t org_id = 0; org_id < genomes.size(); ++org_id) InjectAt(genomes[org_id], org_id);
+
+  // Swap in the recorded environment (unless it's already in place).
+  bool env_shown = false;
+  cur_phase = 0;
+  const size_t env_record = playback.FindEnvRecord(update);
+  if (env_record != aagos::AagosRunArchive::NO_RECORD) {
+    const auto & record = playback.GetEnvRecord(env_record);
+    cur_phase = record.evo_phase;
+    if (env_record == playback_env_record) {
+      env_shown = true;
+    } else if (!record.summary) {
+      const std::string env_path(PLAYBACK_OUTPUT_DIR + "env_state.env");
+      {
+        std::ofstream env_out(env_path);
+        env_out << playback.GetEnvState(env_record) << std::endl;
+      }
+      env_shown = load_environment_from_file(env_path);
+      if (!env_shown) {
+        std::cout << "Failed to load the environment recorded for update " << update << "; using a random environment." << std::endl;
+      }
+    }
+    if (env_shown) playback_env_record = env_record;
+  }
+  if (!env_shown && playback_env_record != aagos::AagosRunArchive::NO_RECORD) {
+    // Don't leave another update's recorded environment in place.
+    randomize_environment();
+    if (fitness_cache != nullptr) fitness_cache->Clear();
+    playback_env_record = aagos::AagosRunArchive::NO_RECORD;
+  }
+
+  // Evaluate the recorded population.
+  most_fit_id = 0;
+  for (size_t org_id = 0; org_id < GetSize(); ++org_id) {
+    evaluate_org(GetOrg(org_id));
+    if (CalcFitnessID(org_id) > CalcFitnessID(most_fit_id)) most_fit_id = org_id;
+  }
+  pop_evaluated = true;
+  frame.Capture(*this, pop_vis.IsDrawModeFullPop(), true, pop_vis.IsDrawModeSummary());
+  frame.update = update;
+
+  RedrawPopulation(true);
+  RedrawEnvironment();
+  world_div.Redraw();
+  stats_div.Redraw();
+  EM_ASM({
+    $("#playback-update-label").html("Update " + $0 + " (snapshot " + ($1 + 1) + " of " + $2 + ")"
+                                     + ($3 ? "" : "; environment not recorded"));
+  }, update, index, updates.size(), env_shown);
+}
+
+/// Restore the configuration from before playback (the world is set up again by the caller).
+void AagosWebInterface::LeavePlayback() {
+  std::istringstream stream(saved_config);
+  config.Read(stream);
+  playback.Clear();
+  playback_mode = false;
+  EM_ASM({
+    $("#playback-slider-col").addClass("d-none");
+    $("#playback-exit-col").addClass("d-none");
+  });
+}
+
+/// Streaming connection opened: stop this world and show the native run's frames instead.
+void AagosWebInterface::AttachStream() {
+  std::cout << "Attached to native run." << std::endl;
+  if (playback_mode) LeavePlayback();
+  StopRun();
+  run_reset_but.SetDisabled(true);
+  config_exp_but.SetDisabled(true);
+  stream_mode = true;
+  stream_num_genes = 0; // Set up pop_vis when the first frame arrives.
+  frame.update = 0;
+  stream_toggle_but.SetLabel("Detach from Native Run");
+  SendStreamRequest();
+}
+
+/// Streaming connection closed: go back to this world (set up again from the configuration).
+void AagosWebInterface::DetachStream() {
+  if (!stream_mode) return;
+  std::cout << "Detached from native run." << std::endl;
+  stream_mode = false;
+  stream_toggle_but.SetLabel("Attach to Native Run");
+  ReconfigureWorld();
+  run_reset_but.SetDisabled(false);
+  run_toggle_but.SetDisabled(false);
+  run_step_but.SetDisabled(false);
+  config_exp_but.SetDisabled(false);
+}
+
+/// Tell the native run which draw mode to capture frames in.
+void AagosWebInterface::SendStreamRequest() {
+  const uint32_t request = (pop_vis.IsDrawModeFullPop() ? 1u : 0u) | (pop_vis.IsDrawModeSummary() ? 2u : 0u);
+  EM_ASM({
+    if (window.aagos_stream && window.aagos_stream.readyState == 1) {
+      window.aagos_stream.send(new Uint32Array([$0]));
+    }
+  }, request);
+}
+
+/// Show the streamed frame in stream_buffer.
+void AagosWebInterface::ReceiveStreamFrame(size_t size) {
+  if (!stream_mode) return;
+  const size_t prev_update = frame.update;
+  if (!frame.Deserialize(stream_buffer.data(), size)) {
+    std::cout << "Received malformed frame from native run." << std::endl;
+    return;
+  }
+  RecordGenerations(frame.update > prev_update ? frame.update - prev_update : 0);
+  if (frame.num_genes != stream_num_genes) {
+    pop_vis.Setup(frame.num_genes);
+    stream_num_genes = frame.num_genes;
+  }
+  if (frame.draw) {
+    RedrawPopulation(true);
+    RedrawEnvironment();
+  }
+  if (frame.finished) std::cout << "Native run finished." << std::endl;
+  world_div.Redraw();
+  stats_div.Redraw();
+}
+
 void AagosWebInterface::SetupConfigInterface() {
   config_general_div.Clear();
 
@@ -1079,43 +1626,22 @@ void AagosWebInterface::SetupStatsViewInterface() {
   stats_div.Table("pop-stats-table").GetCell(0, 0)
     << "Mean fitness";
   stats_div.Table("pop-stats-table").GetCell(0, 1).SetAttr("class", "text-right")
-    << UI::Live([this]() {
-        auto node = GetFitnessDataNode();
-        return node->GetMean();
-      });
+    << UI::Live([this]() { return frame.mean_fitness; });
 
   stats_div.Table("pop-stats-table").GetCell(1, 0)
     << "Mean coding sites";
   stats_div.Table("pop-stats-table").GetCell(1, 1).SetAttr("class", "text-right")
-    << UI::Live([this]() {
-        auto & node = manager.Get("coding_sites");
-        node.PullData();
-        const double mean = node.GetMean();
-        node.Reset();
-        return mean;
-      });
+    << UI::Live([this]() { return frame.mean_coding_sites; });
 
   stats_div.Table("pop-stats-table").GetCell(2, 0)
     << "Mean neutral sites";
   stats_div.Table("pop-stats-table").GetCell(2, 1).SetAttr("class", "text-right")
-    << UI::Live([this]() {
-        auto & node = manager.Get("neutral_sites");
-        node.PullData();
-        const double mean = node.GetMean();
-        node.Reset();
-        return mean;
-      });
+    << UI::Live([this]() { return frame.mean_neutral_sites; });
 
   stats_div.Table("pop-stats-table").GetCell(3, 0)
     << "Mean genome length";
   stats_div.Table("pop-stats-table").GetCell(3, 1).SetAttr("class", "text-right")
-    << UI::Live([this]() {
-        auto & node = manager.Get("genome_length");
-        node.PullData();
-        const double mean = node.GetMean();
-        node.Reset();
-        return mean;
-      });
+    << UI::Live([this]() { return frame.mean_genome_length; });
 
   stats_div << UI::Div("max-fit-stats-header-row").SetAttr("class", "row justify-content-center");
   stats_div.Div("max-fit-stats-header-row")
@@ -1131,31 +1657,28 @@ void AagosWebInterface::SetupStatsViewInterface() {
     << "Fitness";
   stats_div.Table("max-fit-org-stats-table").GetCell(0, 1).SetAttr("class", "text-right")
     << UI::Live([this]() {
-        return CalcFitnessID(most_fit_id);
+        return frame.orgs.size() ? frame.GetMostFitOrg().fitness : 0.0;
       });
 
   stats_div.Table("max-fit-org-stats-table").GetCell(1, 0)
     << "Coding sites";
   stats_div.Table("max-fit-org-stats-table").GetCell(1, 1).SetAttr("class", "text-right")
     << UI::Live([this]() {
-        org_t & org = GetOrg(most_fit_id);
-        return ComputeCodingSites(org);
+        return frame.orgs.size() ? frame.GetMostFitOrg().coding_sites : 0;
       });
 
   stats_div.Table("max-fit-org-stats-table").GetCell(2, 0)
     << "Neutral sites";
   stats_div.Table("max-fit-org-stats-table").GetCell(2, 1).SetAttr("class", "text-right")
     << UI::Live([this]() {
-        org_t & org = GetOrg(most_fit_id);
-        return ComputeNeutralSites(org);
+        return frame.orgs.size() ? frame.GetMostFitOrg().neutral_sites : 0;
       });
 
   stats_div.Table("max-fit-org-stats-table").GetCell(3, 0)
     << "Genome length";
   stats_div.Table("max-fit-org-stats-table").GetCell(3, 1).SetAttr("class", "text-right")
     << UI::Live([this]() {
-        const org_t & org = GetOrg(most_fit_id);
-        return org.GetNumBits();
+        return frame.orgs.size() ? frame.GetMostFitOrg().bits.GetSize() : 0;
       });
 
 
@@ -1,5 +1,3 @@
-/// @todo Need to add cyclic environments!
-
 #ifndef AAGOS_WORLD_H
 #define AAGOS_WORLD_H
 
@@ -10,6 +8,15 @@
 #include "AagosMutLandscapeInfo.hpp"
 #include "GradientFitnessModel.hpp"
 #include "NKFitnessModel.hpp"
+#include "AagosPhaseTimer.hpp"
+#include "AagosParsing.hpp"
+#include "AagosSnapshot.hpp"
+#include "AagosKernels.hpp"
+#include "AagosEvaluators.hpp"
+#include "AagosEnvBank.hpp"
+#include "AagosEnvLog.hpp"
+#include "AagosThreadPool.hpp"
+#include "AagosGrid.hpp"
 
 #include "emp/Evolve/World.hpp"
 #include "emp/math/Distribution.hpp"
@@ -48,6 +55,9 @@ public:
   using taxon_t = typename systematics_t::taxon_t;
 
 protected:
+  /// Procedural NK landscapes larger than this are summarized (not enumerated) in environment.csv.
+  static constexpr size_t MAX_PRINTED_PROCEDURAL_STATES = 1 << 16;
+
   size_t TOTAL_GENS;
   size_t CUR_CHANGE_MAGNITUDE;
   size_t CUR_CHANGE_FREQUENCY;
@@ -69,9 +79,29 @@ protected:
   std::function<void()> randomize_environment;
   std::function<bool(const std::string&)> load_environment_from_file;
 
+  // Environment bank (ENV_BANK_*): while active, the bank owns the fitness models, and the model
+  // pointers above point at its current environment.
+  emp::Ptr<AagosEnvBank<NKFitnessModel>> env_bank_nk;
+  emp::Ptr<AagosEnvBank<GradientFitnessModel>> env_bank_gradient;
+  emp::Ptr<AagosFitnessCache> fitness_cache;  ///< Current bank environment's fitness cache (nullptr if none).
+
   emp::Signal<void(size_t)> after_eval_sig; ///< Triggered after organism (ID given by size_t argument) evaluation.
+  emp::Signal<void(size_t)> step_end_sig;   ///< Triggered at the end of RunStep (before the world advances) with the current update.
 
   emp::Ptr<AagosMutator> mutator;
+  emp::Ptr<AagosThreadPool> eval_pool;  ///< Threads for population evaluation (EVAL_THREADS).
+
+  emp::Ptr<AagosGrid> grid;             ///< Spatial structure (GRID_WIDTH > 0); nullptr if well-mixed.
+  uint64_t grid_seed=0;                 ///< Keys the grid's tournament draws.
+  emp::vector<double> grid_fitness;     ///< Fitness by organism id (read by tournaments on any thread).
+  emp::vector<size_t> grid_parents;     ///< Parent chosen for each cell.
+
+  // Environment generation/changes draw from env_random_ptr: the world's random number generator,
+  // unless SetEnvironmentSeed gave the environment its own stream.
+  emp::Ptr<emp::Random> env_random_ptr;
+  emp::Ptr<emp::Random> own_env_random;   ///< Owned separate environment stream (if any).
+  bool separate_env_random=false;
+  int env_seed=0;
 
   emp::Ptr<systematics_t> sys_ptr; ///< Shortcut pointer to the correctly-typed systematics manager.
                                    ///< NOTE: The base world class will be responsible for memory management.
@@ -83,18 +113,33 @@ protected:
     emp::data::Stats,
     emp::data::Pull
   > manager;
+  emp::Ptr<emp::DataFile> fitness_file;       ///< Owned by the world's file list; updated by RunStep.
   emp::Ptr<emp::DataFile> gene_stats_file;
   emp::Ptr<emp::DataFile> representative_org_file;
-  emp::Ptr<emp::DataFile> env_file;
+  emp::Ptr<emp::DataFile> env_file;          ///< Full environment states (nullptr with ENV_LOG).
+  env_log::Writer env_change_log;            ///< Compact environment change log (ENV_LOG).
+  emp::vector<size_t> env_log_bank_keyframes; ///< Keyframe logged for each bank environment (if any yet).
+
+  #ifdef AAGOS_TIMING
+  AagosPhaseTimer phase_timer;             ///< Accumulates time spent in each phase of a generation.
+  emp::Ptr<emp::DataFile> timing_file;
+  #endif
 
   size_t gene_mask;
   size_t most_fit_id;
+  bool pop_evaluated=false;  ///< Has the current population been evaluated (see EvaluatePopulation)?
+  bool drift_skip_eval=false; ///< Skip evaluation in generations without selection? (see DRIFT_MODE)
 
   void InitFitnessEval();
   void InitEnvironment();
+  template<typename MODEL>
+  void InitEnvironmentBank(emp::Ptr<AagosEnvBank<MODEL>> & bank, emp::Ptr<MODEL> & model,
+                           const std::function<emp::Ptr<MODEL>()> & make_model);
   void InitPop();
   void InitPopRandom();
   void InitPopLoad();
+  void LoadAncestorList(const parsing::MappedFile & ancestor_file, emp::vector<genome_t> & ancestor_genomes);
+  void LoadSnapshotGenomes(const parsing::MappedFile & snapshot_file, emp::vector<genome_t> & genomes);
   void InitDataTracking();
 
   void InitLocalConfigs();     ///< Localize paramters that may change for phase two.
@@ -103,7 +148,10 @@ protected:
   void SetupStatsFile();
   void SetupRepresentativeFile();
   void SetupEnvironmentFile();
+  void SetupEnvironmentLog();
+  void LogEnvironmentKeyframe(size_t effective_update);
   void SetupSystematics();
+  void SetupTimingFile();
   void DoPopulationSnapshot();
   void DoConfigSnapshot();
   // TODO - setup environment tracking file?
@@ -118,35 +166,92 @@ protected:
     return count;
   }
 
+  /// Does anything report on the population at update u? (console, summary, or snapshot output)
+  bool IsReportUpdate(size_t u) const {
+    auto due = [this, u](size_t interval) {
+      return interval && (!(u % interval) || (u == config.MAX_GENS()) || (u == TOTAL_GENS));
+    };
+    return due(config.PRINT_INTERVAL()) || due(config.SUMMARY_INTERVAL()) || due(config.SNAPSHOT_INTERVAL());
+  }
+
   /// Short cut for computing organism's neutral sites.
   size_t ComputeNeutralSites(org_t & org) {
     return org.GetGeneOccupancyHistogram().GetHistCount(0);
   }
 
+  /// Callback that records environment edits of the given type in the environment log (empty if
+  /// not logging). Edits made in AdvanceWorld take effect from the next update.
+  std::function<void(size_t, size_t, double)> GetEnvChangeLogger(env_log::RECORD type) {
+    if (!env_change_log.IsOpen()) return nullptr;
+    const size_t effective_update = GetUpdate() + 1;
+    return [this, type, effective_update](size_t gene, size_t index, double value) {
+      env_change_log.LogChange(effective_update, type, gene, index, value);
+    };
+  }
+
 public:
   AagosWorld(config_t& cfg) : config(cfg) { }
 
   ~AagosWorld() {
-    if (config.GRADIENT_MODEL()) fitness_model_gradient.Delete();
+    if (env_bank_nk != nullptr) env_bank_nk.Delete();
+    else if (env_bank_gradient != nullptr) env_bank_gradient.Delete();
+    else if (config.GRADIENT_MODEL()) fitness_model_gradient.Delete();
     else fitness_model_nk.Delete();
     mutator.Delete();
+    if (eval_pool != nullptr) eval_pool.Delete();
+    if (grid != nullptr) grid.Delete();
+    if (own_env_random != nullptr) own_env_random.Delete();
     representative_org_file.Delete();
     gene_stats_file.Delete();
-    env_file.Delete();
+    if (env_file != nullptr) env_file.Delete();
+    #ifdef AAGOS_TIMING
+    timing_file.Delete();
+    #endif
   }
 
   /// Advance world by a single time step (generation).
   void RunStep(bool auto_advance=true);
 
+  /// Evaluate the current population (if it hasn't been already): phenotypes, most fit organism,
+  /// and systematics. With DRIFT_MODE, RunStep skips this in tournament-size-1 generations except at
+  /// output updates, so anything else that reads phenotypes mid-run should call it first.
+  void EvaluatePopulation();
+
   ///
   void AdvanceWorld();
 
   /// Run world for configured number of generations.
   void Run();
 
+  /// Run phase one only (the first part of Run).
+  void RunPhaseOne();
+
+  /// Transition to phase two and run it (the rest of Run).
+  void RunPhaseTwo();
+
+  /// Replace the population with copies of source's (organism i => position i) and continue from
+  /// source's update. Must be set up, with the same population size.
+  void CopyPopulationFrom(AagosWorld & source);
+
+  /// Continue source's run, e.g., to branch it: copy its population and update (as
+  /// CopyPopulationFrom), random number generator state, and environment (including the environment
+  /// bank's position). Must be set up with source's configuration (apart from PHASE_2_* settings).
+  /// Only the phylogeny (which starts over) and output files differ from continuing source itself.
+  void ContinueFrom(AagosWorld & source);
+
   void Setup();
 
+  /// Draw the environment (initial environment and changes) from its own random number stream
+  /// seeded with seed, instead of the world's. Worlds given the same environment seed (and
+  /// configuration) experience identical environments regardless of their population's seed.
+  /// Takes effect at the next Setup.
+  void SetEnvironmentSeed(int seed) { separate_env_random = true; env_seed = seed; }
+
+  /// Call fun at the end of each RunStep, while the population's phenotypes are still current.
+  emp::SignalKey OnStepEnd(const std::function<void(size_t)> & fun) { return step_end_sig.AddAction(fun); }
+
   size_t GetMostFitID() const { return most_fit_id; }
+  size_t GetPhase() const { return cur_phase; }
   bool IsSetup() const { return setup; }
   const config_t& GetConfig() const { return config; }
 
@@ -167,77 +272,139 @@ void AagosWorld::RunStep(bool auto_advance/*=true*/) {
   emp_assert(setup);
   // (1) evaluate population, (2) select parents, (3) update the world
   // == Do evaluation ==
-  most_fit_id = 0;
-  for (size_t org_id = 0; org_id < this->GetSize(); ++org_id) {
-    emp_assert(IsOccupied(org_id));
-    // std::cout << "-- Evaluating org_id " << org_id << " --" << std::endl;
-    evaluate_org(GetOrg(org_id));
-    if (CalcFitnessID(org_id) > CalcFitnessID(most_fit_id)) {
-      most_fit_id = org_id;
-    }
-    after_eval_sig.Trigger(org_id); // Record phenotype information for this organism's taxon.
-    // NOTE - if we wanted to add phenotype tracking to systematics, here's where we could intercept
-    //        the necessary information.
-  }
+  // In drift mode (DRIFT_MODE with tournament size 1), fitness never affects selection, so the
+  // population is only evaluated at updates that report on it (and when a frame captures it; see
+  // EvaluatePopulation).
+  const size_t u = GetUpdate();
+  if (!drift_skip_eval || CUR_TOURNAMENT_SIZE != 1 || IsReportUpdate(u)) EvaluatePopulation();
 
   // == Do selection ==
   // if (config.ELITE_COUNT()) emp::EliteSelect(*this, config.ELITE_COUNT(), 1);
   // Run a tournament for the rest...
   // emp::TournamentSelect(*this, config.TOURNAMENT_SIZE(), config.POP_SIZE() - config.ELITE_COUNT());
-  emp::TournamentSelect(*this, CUR_TOURNAMENT_SIZE, config.POP_SIZE());
+  {
+    AAGOS_TIME_PHASE(phase_timer, BIRTH);
+    if (grid != nullptr) {
+      grid_fitness.resize(this->GetSize());
+      for (size_t org_id = 0; org_id < this->GetSize(); ++org_id) grid_fitness[org_id] = CalcFitnessID(org_id);
+      grid->SelectParents(CUR_TOURNAMENT_SIZE, grid_seed, GetUpdate(),
+                          [this](size_t org_id) { return grid_fitness[org_id]; }, *eval_pool, grid_parents);
+      // Births in cell order: the (synchronous) population places offspring i at position i.
+      for (size_t parent_id : grid_parents) DoBirth(GetOrg(parent_id).GetGenome(), parent_id, 1);
+    } else {
+      emp::TournamentSelect(*this, CUR_TOURNAMENT_SIZE, config.POP_SIZE());
+    }
+  }
 
   // == Do update ==
   // If it's a generation to print to console, do so
-  const size_t u = GetUpdate();
   if (u % config.PRINT_INTERVAL() == 0) {
+    AAGOS_TIME_PHASE(phase_timer, OUTPUT);
     std::cout << u
               << ": max fitness=" << CalcFitnessID(most_fit_id)
               << "; size=" << GetOrg(most_fit_id).GetNumBits();
               // << "; genome=";
     // GetOrg(most_fit_id).Print();
     std::cout << std::endl;
+    #ifdef AAGOS_TIMING
+    std::cout << "  ";
+    phase_timer.Print(std::cout);
+    std::cout << std::endl;
+    timing_file->Update();
+    #endif
   }
 
   // Handle managed output files.
   if (config.SUMMARY_INTERVAL()) {
     if ( !(u % config.SUMMARY_INTERVAL()) || (u == config.MAX_GENS()) || (u == TOTAL_GENS) ) {
+      AAGOS_TIME_PHASE(phase_timer, STATS);
+      if (!(u % config.SUMMARY_INTERVAL())) fitness_file->Update();
       gene_stats_file->Update();
       representative_org_file->Update();
     }
   }
   if (config.SNAPSHOT_INTERVAL()) {
     if ( !(u % config.SNAPSHOT_INTERVAL()) || (u == config.MAX_GENS()) ||  (u == TOTAL_GENS) ) {
+      AAGOS_TIME_PHASE(phase_timer, OUTPUT);
       DoPopulationSnapshot();
       if (u && config.PHYLOGENY_TRACKING()) {
+        AAGOS_TIME_PHASE(phase_timer, SYSTEMATICS);
         sys_ptr->Snapshot(output_path + "phylo_" + emp::to_string(u) + ".csv"); // Don't snapshot phylo at update 0
       }
-      env_file->Update();
+      if (env_file != nullptr) env_file->Update();
+      env_change_log.Flush();
     }
   }
 
+  step_end_sig.Trigger(u);
+
   if (auto_advance) {
     AdvanceWorld();   // Web interface needs to manage when world update gets called...
   }
 
 }
 
+void AagosWorld::EvaluatePopulation() {
+  if (pop_evaluated) return;
+  most_fit_id = 0;
+  {
+    AAGOS_TIME_PHASE(phase_timer, EVALUATION);
+    // Organisms are evaluated independently (in parallel with EVAL_THREADS > 1); everything that
+    // touches shared state (fitness cache, systematics) happens in order afterwards.
+    eval_pool->Run(this->GetSize(), [this](size_t begin, size_t end, size_t thread_id) {
+      for (size_t org_id = begin; org_id < end; ++org_id) {
+        emp_assert(IsOccupied(org_id));
+        org_t & org = GetOrg(org_id);
+        // Genomes already evaluated in the current bank environment are looked up instead.
+        if (fitness_cache != nullptr && fitness_cache->Fetch(thread_id, org.GetGenome(), org.GetPhenotype())) continue;
+        evaluate_org(org);
+        if (fitness_cache != nullptr) fitness_cache->Store(thread_id, org.GetPhenotype());
+      }
+    });
+    if (fitness_cache != nullptr) fitness_cache->Commit();
+    for (size_t org_id = 0; org_id < this->GetSize(); ++org_id) {
+      if (CalcFitnessID(org_id) > CalcFitnessID(most_fit_id)) {
+        most_fit_id = org_id;
+      }
+      after_eval_sig.Trigger(org_id); // Record phenotype information for this organism's taxon.
+      // NOTE - if we wanted to add phenotype tracking to systematics, here's where we could intercept
+      //        the necessary information.
+    }
+  }
+  pop_evaluated = true;
+}
+
 void AagosWorld::AdvanceWorld() {
   // Should the environment change?
   const bool change_env = (CUR_CHANGE_FREQUENCY > 0) && !(GetUpdate() % CUR_CHANGE_FREQUENCY);
   if (change_env) {
+    AAGOS_TIME_PHASE(phase_timer, ENV_CHANGE);
     change_environment();
   }
+  // NOTE - Update swaps in the next generation (which includes Empirical's internal systematics
+  //        bookkeeping for the outgoing generation); we charge that turnover to birth.
+  AAGOS_TIME_PHASE(phase_timer, BIRTH);
   Update();
   ClearCache();
+  pop_evaluated = false;
 }
 
 void AagosWorld::Run() {
+  RunPhaseOne();
+  // Transition?
+  if (!config.PHASE_2_ACTIVE()) return;
+  RunPhaseTwo();
+}
+
+void AagosWorld::RunPhaseOne() {
   emp_assert(setup);
   for (size_t gen = 0; gen <= config.MAX_GENS(); ++gen) {
     RunStep();
   }
-  // Transition?
-  if (!config.PHASE_2_ACTIVE()) return;
+}
+
+void AagosWorld::RunPhaseTwo() {
+  emp_assert(setup);
   // Transition run into phase 2 of evolution
   ActivateEvoPhaseTwo();
   // Run phase of evolution
@@ -246,6 +413,51 @@ void AagosWorld::Run() {
   }
 }
 
+void AagosWorld::CopyPopulationFrom(AagosWorld & source) {
+  emp_assert(setup);
+  emp_assert(source.GetSize() == GetSize(), source.GetSize(), GetSize());
+  for (size_t org_id = 0; org_id < source.GetSize(); ++org_id) {
+    InjectAt(source.GetOrg(org_id).GetGenome(), emp::WorldPosition(org_id));
+  }
+  update = source.GetUpdate();
+  pop_evaluated = false;
+}
+
+void AagosWorld::ContinueFrom(AagosWorld & source) {
+  emp_assert(config.GRADIENT_MODEL() == source.config.GRADIENT_MODEL());
+  CopyPopulationFrom(source);
+  *random_ptr = *source.random_ptr;
+  grid_seed = source.grid_seed;
+  if (own_env_random != nullptr) own_env_random.Delete();
+  own_env_random = nullptr;
+  separate_env_random = source.separate_env_random;
+  env_seed = source.env_seed;
+  if (source.own_env_random != nullptr) {
+    own_env_random = emp::NewPtr<emp::Random>(*source.own_env_random);
+    env_random_ptr = own_env_random;
+  } else {
+    env_random_ptr = random_ptr;
+  }
+  // Environment: bank position and environments, or the current model's state.
+  if (env_bank_nk != nullptr) {
+    env_bank_nk->CopyStateFrom(*source.env_bank_nk);
+    fitness_model_nk = env_bank_nk->GetCurrent();
+    fitness_cache = env_bank_nk->GetCurrentCache();
+  } else if (env_bank_gradient != nullptr) {
+    env_bank_gradient->CopyStateFrom(*source.env_bank_gradient);
+    fitness_model_gradient = env_bank_gradient->GetCurrent();
+    fitness_cache = env_bank_gradient->GetCurrentCache();
+  } else if (config.GRADIENT_MODEL()) {
+    fitness_model_gradient.Delete();
+    fitness_model_gradient = emp::NewPtr<GradientFitnessModel>(*source.fitness_model_gradient);
+  } else {
+    fitness_model_nk.Delete();
+    fitness_model_nk = emp::NewPtr<NKFitnessModel>(*source.fitness_model_nk);
+  }
+  cur_phase = source.cur_phase;
+  LogEnvironmentKeyframe(GetUpdate());
+}
+
 // todo - make callable multiple times?
 void AagosWorld::Setup() {
   std::cout << "-- Setting up AagosWorld -- " << std::endl;
@@ -254,6 +466,13 @@ void AagosWorld::Setup() {
 
   // Reset world's random number seed.
   random_ptr->ResetSeed(config.SEED());
+  if (own_env_random != nullptr) own_env_random.Delete();
+  if (separate_env_random) {
+    own_env_random = emp::NewPtr<emp::Random>(env_seed);
+    env_random_ptr = own_env_random;
+  } else {
+    env_random_ptr = random_ptr;
+  }
 
   // Asserts
   emp_assert(config.NUM_GENES() > 0);
@@ -261,14 +480,46 @@ void AagosWorld::Setup() {
   // Localize phase-one-specific configs
   InitLocalConfigs();
 
+  // Drift mode: phylogenies record each taxon's fitness when it's evaluated, so skipping evaluation
+  // would leave taxa born and lost between outputs without any.
+  drift_skip_eval = config.DRIFT_MODE() && !config.PHYLOGENY_TRACKING();
+  if (config.DRIFT_MODE()) {
+    if (!drift_skip_eval) {
+      std::cout << "Drift mode ignored: PHYLOGENY_TRACKING needs every generation evaluated." << std::endl;
+    } else if (config.TOURNAMENT_SIZE() != 1 && (!config.PHASE_2_ACTIVE() || config.PHASE_2_TOURNAMENT_SIZE() != 1)) {
+      std::cout << "Drift mode has no effect: no phase has a tournament size of 1." << std::endl;
+    } else {
+      std::cout << "Drift mode: evaluation skipped in tournament-size-1 generations that don't output the population." << std::endl;
+    }
+  }
+
   // Basic setup
   gene_mask = emp::MaskLow<size_t>(config.GENE_SIZE());
   most_fit_id = 0;
+  pop_evaluated = false;
   output_path = config.DATA_FILEPATH();
   SetPopStruct_Mixed(true);
 
+  // Spatial structure is layered over the synchronous population (see RunStep).
+  if (grid != nullptr) grid.Delete();
+  if (config.GRID_WIDTH()) {
+    if (config.POP_SIZE() % config.GRID_WIDTH()) {
+      std::cout << "POP_SIZE (" << config.POP_SIZE() << ") must be a multiple of GRID_WIDTH (" << config.GRID_WIDTH() << "). Exiting..." << std::endl;
+      exit(-1);
+    }
+    grid = emp::NewPtr<AagosGrid>(config.GRID_WIDTH(), config.POP_SIZE() / config.GRID_WIDTH(),
+                                  config.GRID_NEIGHBORHOOD_RADIUS(), config.GRID_TILE_SIZE());
+    grid_seed = random_ptr->GetUInt64();
+    std::cout << "Population on a " << grid->GetWidth() << "x" << grid->GetHeight() << " grid (" << grid->GetNumTiles() << " tiles)." << std::endl;
+  }
+
   // Initialize fitness evaluation.
   std::cout << "Setting up fitness evaluation." << std::endl;
+  if (eval_pool == nullptr || eval_pool->GetNumThreads() != AagosThreadPool::ResolveNumThreads(config.EVAL_THREADS())) {
+    if (eval_pool != nullptr) eval_pool.Delete();
+    eval_pool = emp::NewPtr<AagosThreadPool>(config.EVAL_THREADS());
+    std::cout << "Evaluating population with " << eval_pool->GetNumThreads() << " thread(s)." << std::endl;
+  }
   InitFitnessEval();
   InitEnvironment();
 
@@ -288,6 +539,7 @@ void AagosWorld::Setup() {
 
   if (config.APPLY_BIT_MUTS_PER_GENE()) {
     SetMutFun([this](org_t& org, emp::Random& rnd) {
+      AAGOS_TIME_PHASE(phase_timer, MUTATION);
       // NOTE - here's where we would intercept mutation-type distributions (with some extra infrastructure
       //        built into the mutator)!
       org.ResetMutations();
@@ -303,6 +555,7 @@ void AagosWorld::Setup() {
     });
   } else {
     SetMutFun([this](org_t& org, emp::Random& rnd) {
+      AAGOS_TIME_PHASE(phase_timer, MUTATION);
       // NOTE - here's where we would intercept mutation-type distributions (with some extra infrastructure
       //        built into the mutator)!
       org.ResetMutations();
@@ -330,6 +583,8 @@ void AagosWorld::Setup() {
   // SetAutoMutate(config.ELITE_COUNT());
   SetAutoMutate();
 
+  if (config.ENV_LOG()) SetupEnvironmentLog();
+
   DoConfigSnapshot(); // Snapshot run settings
 
   setup = true;
@@ -377,7 +632,10 @@ void AagosWorld::ActivateEvoPhaseTwo() {
   );
   std::cout << "    ...done constructing mutator." << std::endl;
 
-  if (config.PHASE_2_LOAD_ENV_FROM_FILE()) {
+  if (env_bank_nk != nullptr || env_bank_gradient != nullptr) {
+    // The bank keeps switching environments (every PHASE_2_CHANGE_FREQUENCY generations).
+    std::cout << "  Environment bank active; phase two environment settings are ignored." << std::endl;
+  } else if (config.PHASE_2_LOAD_ENV_FROM_FILE()) {
     // Load the environment from a file.
     const bool success = load_environment_from_file(config.PHASE_2_ENV_FILE());
     if (!success) {
@@ -388,6 +646,7 @@ void AagosWorld::ActivateEvoPhaseTwo() {
     // Randomize the environment.
     randomize_environment();
   }
+  LogEnvironmentKeyframe(GetUpdate());
   ++cur_phase;
 }
 
@@ -410,56 +669,19 @@ void AagosWorld::InitPopRandom() {
 }
 
 void AagosWorld::InitPopLoad() {
-  // Load genome from file.
+  // Load genomes from file. File may be a population snapshot (see AagosSnapshot.hpp) or an
+  // ancestor list.
   emp::vector<genome_t> ancestor_genomes;
-
-
-  std::ifstream ancestor_fstream(config.LOAD_ANCESTOR_FILE());
-  if (!ancestor_fstream.is_open()) {
-    std::cout << "Failed to open ancestor file (" << config.LOAD_ANCESTOR_FILE() << "). Exiting..." << std::endl;
+  const std::string & path = config.LOAD_ANCESTOR_FILE();
+  parsing::MappedFile ancestor_file(path);
+  if (!ancestor_file.IsOpen()) {
+    std::cout << ancestor_file.GetError() << " Exiting..." << std::endl;
     exit(-1);
   }
-  std::string cur_line;
-  emp::vector<std::string> line_components;
-  // bool success = false;
-  while (!ancestor_fstream.eof()) {
-    std::getline(ancestor_fstream, cur_line);
-    emp::left_justify(cur_line); // Remove any leading whitespace.
-    if (cur_line == emp::empty_string()) continue;
-    else if (cur_line[0] == '#') continue;
-    else {
-      // Attempt to read genome
-      line_components.clear();
-      emp::slice(cur_line, line_components, ',');
-      if (line_components.size() != (config.NUM_GENES() + 1)) {
-        std::cout << "Unexpected list size ("<<line_components.size()<<")." << std::endl;
-        break;
-      }
-      // Create new gene starts & bits
-      emp::vector<size_t> gene_starts(config.NUM_GENES(), 0);
-      emp::BitVector bits;
-      // First NUM_GENES components should be gene start positions.
-      for (size_t g = 0; g < config.NUM_GENES(); ++g) {
-        std::string & value_str = line_components[g];
-        gene_starts[g] = emp::from_string<size_t>(value_str);
-      }
-      // Next, attempt to load bits.
-      std::string & bits_str = line_components[config.NUM_GENES()];
-      bits.Resize(bits_str.size());
-      for (size_t bit = 0; bit < bits_str.size(); ++bit) {
-        emp_assert(bit < bits.GetSize());
-        bits.Set(bits.GetSize() - bit - 1, bits_str[bit] == '1');
-      }
-
-      emp_assert(bits.GetSize() >= config.MIN_SIZE());
-      emp_assert(bits.GetSize() <= config.MAX_SIZE());
-
-      genome_t genome(bits.GetSize(), config.NUM_GENES(), config.GENE_SIZE());
-      genome.bits = bits;
-      genome.gene_starts = gene_starts;
-      genome.ancestral_id = ancestor_genomes.size();
-      ancestor_genomes.emplace_back(genome);
-    }
+  if (snapshot::IsCSVSnapshot(ancestor_file) || snapshot::IsBinarySnapshot(ancestor_file)) {
+    LoadSnapshotGenomes(ancestor_file, ancestor_genomes);
+  } else {
+    LoadAncestorList(ancestor_file, ancestor_genomes);
   }
 
   if (!ancestor_genomes.size()) {
@@ -483,14 +705,83 @@ void AagosWorld::InitPopLoad() {
   }
 }
 
+void AagosWorld::LoadAncestorList(const parsing::MappedFile & ancestor_file, emp::vector<genome_t> & ancestor_genomes) {
+  // Each non-comment line gives NUM_GENES gene start positions followed by the genome bitstring:
+  //   start,start,...,start,bits
+  const std::string & path = config.LOAD_ANCESTOR_FILE();
+  parsing::Cursor cursor(ancestor_file);
+  auto fail = [&cursor, &path](const std::string & msg) {
+    std::cout << "Failed to load ancestors: " << parsing::FormatError(path, cursor.GetLine(), msg) << " Exiting..." << std::endl;
+    exit(-1);
+  };
+  while (cursor.NextContentLine()) {
+    genome_t genome(0, config.NUM_GENES(), config.GENE_SIZE());
+    // First NUM_GENES components should be gene start positions.
+    for (size_t g = 0; g < config.NUM_GENES(); ++g) {
+      cursor.SkipSpaces();
+      if (!cursor.ParseSize(genome.gene_starts[g])) {
+        fail("Expected " + emp::to_string(config.NUM_GENES()) + " gene start positions; found " + emp::to_string(g) + ".");
+      }
+      cursor.SkipSpaces();
+      if (!cursor.Consume(',')) fail("Expected ',' after gene start position " + emp::to_string(g) + ".");
+    }
+    // Next, attempt to load bits.
+    cursor.SkipSpaces();
+    if (!cursor.ParseBits(genome.bits)) fail("Expected genome bitstring.");
+    cursor.SkipSpaces();
+    if (!cursor.AtLineEnd()) fail("Unexpected trailing characters after genome bitstring.");
+    const size_t genome_size = genome.bits.GetSize();
+    if (genome_size < config.MIN_SIZE() || genome_size > config.MAX_SIZE()) {
+      fail("Genome size (" + emp::to_string(genome_size) + ") outside of [MIN_SIZE, MAX_SIZE].");
+    }
+    for (size_t g = 0; g < config.NUM_GENES(); ++g) {
+      if (genome.gene_starts[g] >= genome_size) {
+        fail("Gene start position (" + emp::to_string(genome.gene_starts[g]) + ") is beyond the end of the genome.");
+      }
+    }
+    genome.ancestral_id = ancestor_genomes.size();
+    ancestor_genomes.emplace_back(std::move(genome));
+  }
+}
+
+void AagosWorld::LoadSnapshotGenomes(const parsing::MappedFile & snapshot_file, emp::vector<genome_t> & genomes) {
+  // Snapshot genomes keep their ancestral ids.
+  const std::string & path = config.LOAD_ANCESTOR_FILE();
+  std::string error;
+  const bool binary = snapshot::IsBinarySnapshot(snapshot_file);
+  std::cout << "Loading population from " << (binary ? "binary" : "csv") << " snapshot..." << std::endl;
+  const bool success = binary
+    ? snapshot::LoadBinary(snapshot_file, path, config.NUM_GENES(), config.GENE_SIZE(), config.LOAD_ANCESTOR_THREADS(), genomes, error)
+    : snapshot::LoadCSV(snapshot_file, path, config.NUM_GENES(), config.GENE_SIZE(), config.LOAD_ANCESTOR_THREADS(), genomes, error);
+  if (!success) {
+    std::cout << "Failed to load population snapshot: " << error << " Exiting..." << std::endl;
+    exit(-1);
+  }
+  for (const genome_t & genome : genomes) {
+    if (genome.GetNumBits() < config.MIN_SIZE() || genome.GetNumBits() > config.MAX_SIZE()) {
+      std::cout << "Failed to load population snapshot: genome size (" << genome.GetNumBits()
+                << ") outside of [MIN_SIZE, MAX_SIZE]. Exiting..." << std::endl;
+      exit(-1);
+    }
+  }
+  if (genomes.size() != config.POP_SIZE()) {
+    std::cout << "Warning: snapshot population size (" << genomes.size() << ") does not match POP_SIZE ("
+              << config.POP_SIZE() << "). Snapshot genomes will be cycled to fill the population." << std::endl;
+  }
+}
+
 void AagosWorld::InitFitnessEval() {
+  // Models in a previous environment bank go with it.
+  if (env_bank_nk != nullptr) { env_bank_nk.Delete(); fitness_model_nk = nullptr; }
+  if (env_bank_gradient != nullptr) { env_bank_gradient.Delete(); fitness_model_gradient = nullptr; }
+  fitness_cache = nullptr;
   // Fitness evaluation depends on configured fitness model.
   // Current model options: gradient, no gradient
   if (config.GRADIENT_MODEL()) {
     std::cout << "Initializing gradient model of fitness." << std::endl;
     if (fitness_model_gradient != nullptr) fitness_model_gradient.Delete();
     fitness_model_gradient = emp::NewPtr<GradientFitnessModel>(
-      *random_ptr,
+      *env_random_ptr,
       config.NUM_GENES(),
       config.GENE_SIZE()
     );
@@ -502,37 +793,13 @@ void AagosWorld::InitFitnessEval() {
       targets[i].Print();
       std::cout << std::endl;
     }
-    // Configure the organism evaluation function.
+    // Configure the organism evaluation function (see AagosEvaluators.hpp).
     evaluate_org = [this](org_t & org) {
-      const size_t num_genes = config.NUM_GENES();
-      // const size_t num_bits = config.NUM_BITS();
-      const size_t gene_size = config.GENE_SIZE();
-
       // Grab reference to and reset organism's phenotype.
       auto& phen = org.GetPhenotype();
       phen.Reset();
-      // Calculate fitness contribution of each gene independently.
-      double fitness = 0.0;
-      const auto& gene_starts = org.GetGeneStarts();
-      for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
-        emp_assert(gene_id < gene_starts.size());
-        const size_t gene_start = gene_starts[gene_id];
-
-        // NOTE - Following could be optimized. Currently roughed in to patch Aagos
-        //        after breaking change in Empirical.
-        // Isolate gene by rotating to front and resizing
-        emp::BitVector gene(org.GetBits().ROTATE(gene_start));
-        gene.resize(gene_size);
-
-        // Compute fitness contribution of this gene
-        // - Remember, we assume the first index of gene_starts maps to the first index of the target bitstring.
-        emp_assert(gene_starts.size() == fitness_model_gradient->targets.size());
-        const emp::BitVector& target = fitness_model_gradient->GetTarget(gene_id);
-        const double fitness_contribution = (double)target.EQU(gene).count() / (double)gene_size;
-        phen.gene_fitness_contributions[gene_id] = fitness_contribution;
-        fitness += fitness_contribution;
-      }
-      phen.fitness = fitness;
+      phen.fitness = eval::EvaluateGradient(*fitness_model_gradient, org.GetGenome(), config.NUM_GENES(),
+                                            config.GENE_SIZE(), phen.gene_fitness_contributions.data());
       phen.evaluated = true;
       // phen.coding_sites = ComputeCodingSites(org);
       // phen.neutral_sites = ComputeNeutralSites(org);
@@ -540,34 +807,15 @@ void AagosWorld::InitFitnessEval() {
   } else {
     std::cout << "Initializing NK model of fitness." << std::endl;
     if (fitness_model_nk != nullptr) fitness_model_nk.Delete();
-    fitness_model_nk = emp::NewPtr<NKFitnessModel>(*random_ptr, config.NUM_GENES(), config.GENE_SIZE());
-    // Configure the organism evaluation function.
+    fitness_model_nk = emp::NewPtr<NKFitnessModel>(*env_random_ptr, config.NUM_GENES(), config.GENE_SIZE(),
+                                                   config.NK_PROCEDURAL_LANDSCAPE());
+    // Configure the organism evaluation function (see AagosEvaluators.hpp).
     evaluate_org = [this](org_t & org) {
-      const size_t num_genes = config.NUM_GENES();
-      // const size_t num_bits = config.NUM_BITS();
-      const size_t gene_size = config.GENE_SIZE();
-
       // Grab reference to and reset organism's phenotype.
       auto & phen = org.GetPhenotype();
       phen.Reset();
-
-      // Calculate fitness contribution of each gene independently.
-      double fitness = 0.0;
-      const auto & gene_starts = org.GetGeneStarts();
-      for (size_t gene_id = 0; gene_id < num_genes; ++gene_id) {
-        emp_assert(gene_id < gene_starts.size());
-        const size_t gene_start = gene_starts[gene_id];
-        emp_assert(gene_start < org.GetBits().GetSize(), gene_start, org.GetBits().GetSize());
-        // Isolate gene by rotating to front and resizing
-        emp::BitVector gene(org.GetBits().ROTATE(gene_start));
-        gene.resize(gene_size);
-        const uint32_t gene_val = gene.GetUInt(0);
-        // Compute fitness contribution of this gene using nk landscape
-        const double fitness_contribution = fitness_model_nk->GetLandscape().GetFitness(gene_id, gene_val);
-        phen.gene_fitness_contributions[gene_id] = fitness_contribution;
-        fitness += fitness_contribution;
-      }
-      phen.fitness = fitness;
+      phen.fitness = eval::EvaluateNK(*fitness_model_nk, org.GetGenome(), config.NUM_GENES(),
+                                      config.GENE_SIZE(), phen.gene_fitness_contributions.data());
       phen.evaluated = true;
       // phen.coding_sites = ComputeCodingSites(org);
       // phen.neutral_sites = ComputeNeutralSites(org);
@@ -583,34 +831,107 @@ void AagosWorld::InitEnvironment() {
   if (config.GRADIENT_MODEL()) {
     // Configure environment change for gradient fitness model.
     change_environment = [this]() {
-      fitness_model_gradient->RandomizeTargetBits(*random_ptr, CUR_CHANGE_MAGNITUDE);
+      fitness_model_gradient->RandomizeTargetBits(*env_random_ptr, CUR_CHANGE_MAGNITUDE,
+                                                  GetEnvChangeLogger(env_log::RECORD::TARGET_BIT));
     };
     randomize_environment = [this]() {
-       fitness_model_gradient->RandomizeTargets(*random_ptr, config.NUM_GENES());
+       fitness_model_gradient->RandomizeTargets(*env_random_ptr, config.NUM_GENES());
     };
     load_environment_from_file = [this](const std::string & path) {
-      return fitness_model_gradient->LoadTargets(path);
+      const bool success = fitness_model_gradient->LoadTargets(path);
+      if (!success) std::cout << fitness_model_gradient->GetLoadError() << std::endl;
+      if (fitness_cache != nullptr) fitness_cache->Clear();
+      return success;
     };
   } else {
     // Configure environment change for nk landscape fitness model.
     change_environment = [this]() {
-      fitness_model_nk->RandomizeLandscapeBits(*random_ptr, CUR_CHANGE_MAGNITUDE);
+      fitness_model_nk->RandomizeLandscapeBits(*env_random_ptr, CUR_CHANGE_MAGNITUDE,
+                                               GetEnvChangeLogger(env_log::RECORD::NK_STATE));
     };
     randomize_environment = [this]() {
-      fitness_model_nk->GetLandscape().Reset(*random_ptr);
+      fitness_model_nk->GetLandscape().Reset(*env_random_ptr);
     };
     load_environment_from_file = [this](const std::string & path) {
-      return fitness_model_nk->LoadLandscape(path);
+      const bool success = config.SHARE_ENV() ? fitness_model_nk->ShareLandscape(path, config.SHARED_ENV_DIR())
+                                              : fitness_model_nk->LoadLandscape(path);
+      if (!success) std::cout << fitness_model_nk->GetLoadError() << std::endl;
+      if (fitness_cache != nullptr) fitness_cache->Clear();
+      return success;
     };
   }
 
   // Should we load the environment from file?
   if (config.LOAD_ENV_FROM_FILE()) {
     std::cout << "Loading environment from file..." << std::endl;
-    load_environment_from_file(config.LOAD_ENV_FILE());
+    const bool success = load_environment_from_file(config.LOAD_ENV_FILE());
+    if (!success) {
+      std::cout << "Failed to load environment from file (" << config.LOAD_ENV_FILE() << "). Exiting..." << std::endl;
+      exit(-1);
+    }
+  }
+
+  if (config.GRADIENT_MODEL()) {
+    InitEnvironmentBank<GradientFitnessModel>(env_bank_gradient, fitness_model_gradient, [this]() {
+      return emp::NewPtr<GradientFitnessModel>(*env_random_ptr, config.NUM_GENES(), config.GENE_SIZE());
+    });
+  } else {
+    InitEnvironmentBank<NKFitnessModel>(env_bank_nk, fitness_model_nk, [this]() {
+      return emp::NewPtr<NKFitnessModel>(*env_random_ptr, config.NUM_GENES(), config.GENE_SIZE(),
+                                         config.NK_PROCEDURAL_LANDSCAPE());
+    });
   }
 }
 
+/// Set up the environment bank (if configured): environments from ENV_BANK_FILES, or the initial
+/// environment plus ENV_BANK_SIZE - 1 generated by make_model. Environment changes then switch
+/// model (and fitness_cache) to the next scheduled environment instead of mutating it.
+template<typename MODEL>
+void AagosWorld::InitEnvironmentBank(emp::Ptr<AagosEnvBank<MODEL>> & bank, emp::Ptr<MODEL> & model,
+                                     const std::function<emp::Ptr<MODEL>()> & make_model)
+{
+  emp::vector<std::string> files;
+  std::istringstream files_stream(config.ENV_BANK_FILES());
+  std::string file;
+  while (std::getline(files_stream, file, ',')) {
+    file.erase(0, file.find_first_not_of(" \t"));
+    file.erase(file.find_last_not_of(" \t") + 1);
+    if (file.size()) files.emplace_back(file);
+  }
+  if (files.empty() && config.ENV_BANK_SIZE() == 0) return;
+  const size_t bank_size = files.size() ? files.size() : config.ENV_BANK_SIZE();
+  std::cout << "Setting up environment bank (" << bank_size << " environments)." << std::endl;
+  bank = emp::NewPtr<AagosEnvBank<MODEL>>(config.ENV_BANK_CACHE_SIZE(), eval_pool->GetNumThreads());
+  if (files.empty()) bank->Add(model);
+  else model.Delete();
+  for (size_t env_id = bank->GetSize(); env_id < bank_size; ++env_id) {
+    model = make_model();
+    if (files.size()) {
+      // Loaded through load_environment_from_file (which works on model), so SHARE_ENV applies.
+      if (!load_environment_from_file(files[env_id])) {
+        std::cout << "Failed to load environment bank file (" << files[env_id] << "). Exiting..." << std::endl;
+        model.Delete();
+        exit(-1);
+      }
+    }
+    bank->Add(model);
+  }
+  std::string error;
+  if (!bank->SetSchedule(config.ENV_BANK_SCHEDULE(), error)) {
+    std::cout << error << " Exiting..." << std::endl;
+    exit(-1);
+  }
+  bank->Start();
+  model = bank->GetCurrent();
+  fitness_cache = bank->GetCurrentCache();
+  change_environment = [this, &bank, &model]() {
+    bank->Next(*env_random_ptr);
+    model = bank->GetCurrent();
+    fitness_cache = bank->GetCurrentCache();
+    LogEnvironmentKeyframe(GetUpdate() + 1);  // Switches take effect from the next update.
+  };
+}
+
 void AagosWorld::InitDataTracking() {
   // Create output directory
   #ifndef EMSCRIPTEN
@@ -621,13 +942,19 @@ void AagosWorld::InitDataTracking() {
       output_path += '/';
   }
 
-  SetupFitnessFile(output_path + "fitness.csv").SetTimingRepeat(config.SUMMARY_INTERVAL());
+  // The world would update its fitness file from inside Update(); RunStep updates it with the other
+  // summary files instead, so its cost shows up under STATS rather than BIRTH.
+  fitness_file = &SetupFitnessFile(output_path + "fitness.csv");
+  fitness_file->SetTiming([](size_t) { return false; });
   SetupStatsFile();
   SetupRepresentativeFile();
   SetupEnvironmentFile();
   if (config.PHYLOGENY_TRACKING()) {
     SetupSystematics();
   }
+  #ifdef AAGOS_TIMING
+  SetupTimingFile();
+  #endif
 }
 
 /// Setup data tracking nodes for general statistics about the population.
@@ -849,6 +1176,8 @@ void AagosWorld::SetupRepresentativeFile() {
 }
 
 void AagosWorld::SetupEnvironmentFile() {
+  // With ENV_LOG, environments are logged compactly instead (see SetupEnvironmentLog).
+  if (config.ENV_LOG()) return;
   // environment file should get updated at every snapshot/summary interval
   env_file = emp::NewPtr<emp::DataFile>(output_path + "environment.csv");
   env_file->AddVar(update, "update", "Current generation");
@@ -867,7 +1196,14 @@ void AagosWorld::SetupEnvironmentFile() {
     get_env_state = [this]() {
       std::ostringstream stream;
       stream << "\"";
-      fitness_model_nk->PrintLandscape(stream);
+      const auto & landscape = fitness_model_nk->GetLandscape();
+      // Don't enumerate large procedural (or shared) landscapes at every snapshot.
+      if (!landscape.HasTable() && landscape.GetTotalCount() > MAX_PRINTED_PROCEDURAL_STATES) {
+        stream << (landscape.IsShared() ? "shared" : "procedural") << " NK landscape (N=" << landscape.GetN() << ", K=" << landscape.GetK()
+               << ", overrides=" << landscape.GetNumOverrides() << ")";
+      } else {
+        fitness_model_nk->PrintLandscape(stream);
+      }
       stream << "\"";
       return stream.str();
     };
@@ -876,10 +1212,61 @@ void AagosWorld::SetupEnvironmentFile() {
   env_file->PrintHeaderKeys();
 }
 
+/// Start the environment change log (ENV_LOG) with the current environment as its first keyframe.
+void AagosWorld::SetupEnvironmentLog() {
+  std::string log_dir = config.DATA_FILEPATH();
+  if (log_dir.back() != '/') log_dir += '/';
+  const auto model = config.GRADIENT_MODEL() ? env_file::MODEL::GRADIENT : env_file::MODEL::NK;
+  if (!env_change_log.Open(log_dir, model, config.NUM_GENES(), config.GENE_SIZE())) {
+    std::cout << "Unable to create environment log (" << env_log::GetLogPath(log_dir) << "). Exiting..." << std::endl;
+    exit(-1);
+  }
+  env_log_bank_keyframes.clear();
+  LogEnvironmentKeyframe(GetUpdate());
+}
+
+/// Log the current environment in full, in effect from effective_update. Bank environments are
+/// stored once and referred back to on later switches.
+void AagosWorld::LogEnvironmentKeyframe(size_t effective_update) {
+  if (!env_change_log.IsOpen()) return;
+  constexpr size_t NO_KEYFRAME = (size_t)-1;
+  size_t bank_env = NO_KEYFRAME;
+  if (env_bank_nk != nullptr) bank_env = env_bank_nk->GetCurrentID();
+  if (env_bank_gradient != nullptr) bank_env = env_bank_gradient->GetCurrentID();
+  if (bank_env != NO_KEYFRAME && bank_env < env_log_bank_keyframes.size() && env_log_bank_keyframes[bank_env] != NO_KEYFRAME) {
+    env_change_log.LogKeyframe(effective_update, env_log_bank_keyframes[bank_env]);
+    return;
+  }
+  // Procedural and shared NK landscapes are stored as their base (hash key or source file) plus
+  // the values set since, rather than as a full table.
+  const bool nk_compact = !config.GRADIENT_MODEL() && !fitness_model_nk->landscape.HasTable();
+  size_t keyframe_id = 0;
+  const bool saved = env_change_log.AddKeyframe([this, nk_compact](const std::string & path) {
+    if (config.GRADIENT_MODEL()) return fitness_model_gradient->SaveTargetsBinary(path);
+    if (!nk_compact) return fitness_model_nk->SaveLandscapeBinary(path);
+    const NKLandscape & landscape = fitness_model_nk->landscape;
+    const bool shared = landscape.IsShared();
+    return env_log::WriteNKKeyframe(path, shared ? env_log::NK_BASE::FILE : env_log::NK_BASE::PROCEDURAL,
+                                    config.NUM_GENES(), config.GENE_SIZE(), landscape.GetKey(),
+                                    shared ? fitness_model_nk->GetSharedSource() : std::string(),
+                                    landscape.GetOverrides());
+  }, keyframe_id, nk_compact);
+  if (!saved) {
+    std::cout << "Unable to write environment keyframe (" << keyframe_id << "). Exiting..." << std::endl;
+    exit(-1);
+  }
+  env_change_log.LogKeyframe(effective_update, keyframe_id);
+  if (bank_env != NO_KEYFRAME) {
+    if (bank_env >= env_log_bank_keyframes.size()) env_log_bank_keyframes.resize(bank_env + 1, NO_KEYFRAME);
+    env_log_bank_keyframes[bank_env] = keyframe_id;
+  }
+}
+
 void AagosWorld::SetupSystematics() {
   sys_ptr = emp::NewPtr<systematics_t>([](const org_t & o) { return o.GetGenome(); });
   // We want to record phenotype information immediately after an organism is evaluated.
   after_eval_sig.AddAction([this](size_t pop_id) {
+    AAGOS_TIME_PHASE(phase_timer, SYSTEMATICS);
     emp::Ptr<taxon_t> taxon = sys_ptr->GetTaxonAt(pop_id);
     taxon->GetData().RecordFitness(this->CalcFitnessID(pop_id));
     taxon->GetData().RecordPhenotype(this->GetOrg(pop_id).GetPhenotype());
@@ -887,7 +1274,8 @@ void AagosWorld::SetupSystematics() {
   // We want to record mutations when an organism is added to the population
   // - because mutations are applied automatically by this->DoBirth => this->AddOrgAt => sys->OnNew
   std::function<void(emp::Ptr<taxon_t>, org_t&)> record_taxon_mut_data =
-    [](emp::Ptr<taxon_t> taxon, org_t & org) {
+    [this](emp::Ptr<taxon_t> taxon, org_t & org) {
+      AAGOS_TIME_PHASE(phase_timer, SYSTEMATICS);
       taxon->GetData().RecordMutation(org.GetMutations()); // TODO - add mutation tracking to organism!
     };
   sys_ptr->OnNew(record_taxon_mut_data); // Mutations safely happen right before this is triggered
@@ -959,6 +1347,27 @@ void AagosWorld::SetupSystematics() {
   SetupSystematicsFile(0, output_path + "systematics.csv").SetTimingRepeat(config.SUMMARY_INTERVAL());
 }
 
+/// Setup per-phase timing output (only available when compiled with AAGOS_TIMING).
+/// Each row gives cumulative seconds spent in each phase as of the given update.
+void AagosWorld::SetupTimingFile() {
+  #ifdef AAGOS_TIMING
+  phase_timer.Reset();
+  timing_file = emp::NewPtr<emp::DataFile>(output_path + "timing.csv");
+  timing_file->AddVar(update, "update", "Current generation");
+  timing_file->AddVar(cur_phase, "evo_phase", "Current phase of evolution");
+  for (size_t i = 0; i < AagosPhaseTimer::NUM_PHASES; ++i) {
+    const auto phase = (AagosPhaseTimer::PHASE)i;
+    std::function<double()> phase_time_fun = [this, phase]() {
+      return phase_timer.GetSeconds(phase);
+    };
+    timing_file->AddFun(phase_time_fun, std::string(AagosPhaseTimer::GetName(phase)) + "_sec", "Cumulative seconds spent in this phase");
+  }
+  std::function<double()> total_time_fun = [this]() { return phase_timer.GetTotalSeconds(); };
+  timing_file->AddFun(total_time_fun, "total_sec", "Cumulative seconds spent across all phases");
+  timing_file->PrintHeaderKeys();
+  #endif
+}
+
 /// Setup population snapshotting
 void AagosWorld::DoPopulationSnapshot() {
   emp::DataFile snapshot_file(output_path + "pop_" + emp::to_string((int)GetUpdate()) + ".csv");
@@ -1083,6 +1492,14 @@ void AagosWorld::DoPopulationSnapshot() {
     emp_assert(IsOccupied(cur_org_id));
     snapshot_file.Update();
   }
+
+  // Binary snapshot (can be loaded as LOAD_ANCESTOR_FILE).
+  if (config.SNAPSHOT_BINARY()) {
+    const std::string bin_path(output_path + "pop_" + emp::to_string((int)GetUpdate()) + ".bin");
+    const bool success = snapshot::WriteBinary(bin_path, GetUpdate(), cur_phase, GetSize(), num_genes, config.GENE_SIZE(),
+      [this](size_t org_id) -> const genome_t & { return GetOrg(org_id).GetGenome(); });
+    if (!success) std::cout << "Failed to write binary snapshot (" << bin_path << ")." << std::endl;
+  }
 }
 
 /// Take a snapshot of the configuration settings
@@ -1,14 +1,19 @@
 #ifndef GRADIENT_FITNESS_MODEL_HPP
 #define GRADIENT_FITNESS_MODEL_HPP
 
+#include "AagosParsing.hpp"
+#include "AagosEnvFile.hpp"
+
 #include "emp/base/vector.hpp"
 #include "emp/bits/Bits.hpp"
 #include "emp/math/random_utils.hpp"
 #include "emp/tools/string_utils.hpp"
 
+#include <cstdint>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <functional>
 #include <string>
 
 namespace aagos {
@@ -18,6 +23,8 @@ struct GradientFitnessModel {
   size_t num_genes;
   size_t gene_size;
   emp::vector<emp::BitVector> targets;
+  emp::vector<uint64_t> target_words;   ///< targets packed for evaluation (GetWordsPerTarget() words each).
+  std::string load_error;
 
   GradientFitnessModel(emp::Random & rand, size_t n_genes, size_t g_size)
     : num_genes(n_genes), gene_size(g_size)
@@ -27,18 +34,35 @@ struct GradientFitnessModel {
       emp_assert(targets.back().GetSize() == gene_size);
     }
     emp_assert(targets.size() == num_genes);
+    PackTargets();
   }
 
   const emp::BitVector & GetTarget(size_t id) const { return targets[id]; }
 
-  /// Mutate a number of target bits equal to bit cnt.
-  void RandomizeTargetBits(emp::Random & rand, size_t bit_cnt) {
+  /// Packed words of target id (see AagosKernels.hpp).
+  const uint64_t * GetTargetWords(size_t id) const { return target_words.data() + id * GetWordsPerTarget(); }
+
+  /// Re-pack target_words from targets (needed after modifying targets directly).
+  void PackTargets() {
+    const size_t words_per_target = GetWordsPerTarget();
+    target_words.resize(targets.size() * words_per_target);
+    for (size_t i = 0; i < targets.size(); ++i) {
+      for (size_t w = 0; w < words_per_target; ++w) target_words[i * words_per_target + w] = targets[i].GetUInt64(w);
+    }
+  }
+
+  /// Mutate a number of target bits equal to bit cnt (changed, if given, is called with each
+  /// (target, bit, new value)).
+  void RandomizeTargetBits(emp::Random & rand, size_t bit_cnt,
+                           const std::function<void(size_t, size_t, double)> & changed=nullptr) {
     for (size_t i = 0; i < bit_cnt; ++i) {
       // Select a random target sequence.
       const size_t target_id = rand.GetUInt(targets.size());
       emp::BitVector & target = targets[target_id];
       const size_t target_pos = rand.GetUInt(target.GetSize());
       target.Set(target_pos, !target.Get(target_pos));
+      target_words[target_id * GetWordsPerTarget() + target_pos / 64] ^= UINT64_C(1) << (target_pos % 64);
+      if (changed) changed(target_id, target_pos, target.Get(target_pos) ? 1.0 : 0.0);
     }
   }
 
@@ -56,6 +80,7 @@ struct GradientFitnessModel {
       emp::BitVector & target = targets[target_id];
       emp::RandomizeBitVector(target, rand);
     }
+    PackTargets();
   }
 
   void PrintTargets(std::ostream & out=std::cout) {
@@ -64,51 +89,93 @@ struct GradientFitnessModel {
   }
 
   /// Load targets from file (specified by given path)
-  /// First non-commented line of file should give what emp::to_string would output.
+  /// Binary environment files (see AagosEnvFile.hpp) are detected automatically. Otherwise,
+  /// first line starting with '[' should give what emp::to_string would output (other lines are skipped).
   ///  - [ bits bits bits bits ]
   ///  - Loaded environment must be consistent with num_genes and gene_size
+  /// On failure, returns false (see GetLoadError for a description of what went wrong).
   bool LoadTargets(const std::string & path) {
-    std::ifstream environment_fstream(path);
-    if (!environment_fstream.is_open()) {
-      std::cout << "Failed to open environment file (" << path << "). Exiting..." << std::endl;
-      exit(-1);
+    load_error.clear();
+    parsing::MappedFile file(path);
+    if (!file.IsOpen()) {
+      load_error = file.GetError();
+      return false;
     }
-    std::string cur_line;
-    emp::vector<std::string> line_components;
-    bool success = false;
-    while (!environment_fstream.eof()) {
-      std::getline(environment_fstream, cur_line);
-      emp::left_justify(cur_line); // Remove leading whitespace
-      if (cur_line == emp::empty_string()) continue; // Skip empty line.
-      else if (cur_line[0] == '#') continue; // Treat '#' as a commented line
-      else if (cur_line[0] == '[') {
-        // Attempt to read environments state.
-        emp::remove_chars(cur_line, "[]"); // Remove brackets
-        emp::left_justify(cur_line);       // Remove leading whitespace
-        emp::right_justify(cur_line);      // Remove trailing whitespace
-        line_components.clear();
-        emp::slice(cur_line, line_components, ' ');
-        // Each slice should be a gene target, check to make sure number of targets is correct.
-        if (line_components.size() != num_genes) return false;
-
-        for (size_t i = 0; i < line_components.size(); ++i) {
-          emp_assert(i < targets.size());
-          auto & target_str = line_components[i];
-          // Target string should be correct size.
-          if (target_str.size() != gene_size) return false;
-          for (size_t bit = 0; bit < target_str.size(); ++bit) {
-            emp_assert(bit < targets[i].GetSize());
-            // if (component == '1')
-            targets[i].Set(targets[i].GetSize() - bit - 1, target_str[bit] == '1');
-          }
-        }
-        success = true;
-        break;
+    if (env_file::IsBinary(file)) return LoadTargetsBinary(file, path);
+    parsing::Cursor cursor(file);
+    auto fail = [&](const std::string & msg) {
+      load_error = parsing::FormatError(path, cursor.GetLine(), msg);
+      return false;
+    };
+    if (!cursor.NextLineStartingWith('[') || !cursor.Consume('[')) return fail("Expected targets ('[ bits bits ... ]').");
+    // Parse into scratch targets so a malformed file leaves the current targets untouched.
+    emp::vector<emp::BitVector> loaded(num_genes);
+    for (size_t i = 0; i < num_genes; ++i) {
+      cursor.SkipSpaces();
+      const size_t len = cursor.ParseBits(loaded[i]);
+      if (len == 0) return fail("Expected " + std::to_string(num_genes) + " targets; found " + std::to_string(i) + ".");
+      if (len != gene_size) {
+        return fail("Target " + std::to_string(i) + " has " + std::to_string(len)
+                    + " bits; expected " + std::to_string(gene_size) + ".");
       }
     }
-    return success;
+    cursor.SkipSpaces();
+    if (!cursor.Consume(']')) return fail("More than " + std::to_string(num_genes) + " targets.");
+    targets = std::move(loaded);
+    PackTargets();
+    return true;
   }
 
+  /// Number of uint64 words used to store each target in a binary environment file.
+  size_t GetWordsPerTarget() const { return (gene_size + 63) / 64; }
+
+  /// Load targets from an already-opened binary environment file.
+  bool LoadTargetsBinary(const parsing::MappedFile & file, const std::string & path) {
+    env_file::Header header;
+    const char * payload = nullptr;
+    if (!env_file::ReadHeader(file, path, header, payload, load_error)) return false;
+    if (!env_file::CheckHeader(header, path, env_file::MODEL::GRADIENT, num_genes, gene_size, load_error)) return false;
+    const size_t words_per_target = GetWordsPerTarget();
+    if (header.payload_bytes != num_genes * words_per_target * sizeof(uint64_t)) {
+      load_error = path + ": Binary gradient targets have unexpected payload size.";
+      return false;
+    }
+    const char * words = payload;
+    for (size_t i = 0; i < num_genes; ++i) {
+      emp::BitVector & target = targets[i];
+      target.Resize(gene_size);
+      for (size_t w = 0; w < words_per_target; ++w) {
+        uint64_t word;
+        std::memcpy(&word, words, sizeof(uint64_t));
+        words += sizeof(uint64_t);
+        const size_t word_bits = emp::Min<size_t>(64, gene_size - w * 64);
+        for (size_t b = 0; b < word_bits; ++b) target.Set(w * 64 + b, (word >> b) & 1);
+      }
+    }
+    PackTargets();
+    return true;
+  }
+
+  /// Save targets as a binary environment file (see AagosEnvFile.hpp).
+  bool SaveTargetsBinary(const std::string & path) const {
+    const size_t words_per_target = GetWordsPerTarget();
+    const auto header = env_file::MakeHeader(env_file::MODEL::GRADIENT, num_genes, gene_size, 0,
+                                             num_genes * words_per_target * sizeof(uint64_t));
+    return env_file::Write(path, header, [this, words_per_target](std::ostream & out) {
+      for (const emp::BitVector & target : targets) {
+        for (size_t w = 0; w < words_per_target; ++w) {
+          uint64_t word = 0;
+          const size_t word_bits = emp::Min<size_t>(64, gene_size - w * 64);
+          for (size_t b = 0; b < word_bits; ++b) word |= (uint64_t)target.Get(w * 64 + b) << b;
+          out.write((const char *)&word, sizeof(uint64_t));
+        }
+      }
+    });
+  }
+
+  /// Description of why the last call to LoadTargets failed.
+  const std::string & GetLoadError() const { return load_error; }
+
 };
 
 }
@@ -2,6 +2,8 @@
 #define NK_FITNESS_MODEL_HPP
 
 #include "NKLandscape.hpp"
+#include "AagosParsing.hpp"
+#include "AagosEnvFile.hpp"
 
 #include "emp/base/vector.hpp"
 #include "emp/bits/Bits.hpp"
@@ -11,7 +13,14 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace aagos {
 
@@ -20,69 +29,219 @@ struct NKFitnessModel {
   size_t num_genes;
   size_t gene_size;
   aagos::NKLandscape landscape;
+  std::string load_error;
+  std::string shared_source;  ///< Absolute path of the file a shared landscape was loaded from.
 
-  NKFitnessModel(emp::Random& rand, size_t n_genes, size_t g_size)
+  /// If procedural, landscape values are generated on demand (see NKLandscape).
+  NKFitnessModel(emp::Random& rand, size_t n_genes, size_t g_size, bool procedural=false)
     : num_genes(n_genes), gene_size(g_size)
   {
-    landscape.Config(num_genes, gene_size - 1, rand);
+    landscape.Config(num_genes, gene_size - 1, rand, procedural);
   }
 
   aagos::NKLandscape& GetLandscape() { return landscape; }
 
-  void RandomizeLandscapeBits(emp::Random& rand, size_t cnt) {
-    landscape.RandomizeStates(rand, cnt);
+  /// Randomize cnt landscape values (changed, if given, is called with each (gene, state, value) set).
+  void RandomizeLandscapeBits(emp::Random& rand, size_t cnt,
+                              const std::function<void(size_t, size_t, double)> & changed=nullptr) {
+    landscape.RandomizeStates(rand, cnt, changed);
   }
 
+  /// Print landscape in the same format as emp::to_string (i.e., loadable by LoadLandscape).
+  /// Procedural and shared landscapes are printed site-by-site, so this is only practical for small gene sizes.
   void PrintLandscape(std::ostream& out=std::cout) {
-    out << emp::to_string(landscape.GetLandscape());
+    if (landscape.HasTable()) {
+      out << emp::to_string(landscape.GetLandscape());
+      return;
+    }
+    out << "[ ";
+    for (size_t n = 0; n < landscape.GetN(); ++n) {
+      out << "[ ";
+      for (size_t state = 0; state < landscape.GetStateCount(); ++state) {
+        out << landscape.GetFitness(n, state) << " ";
+      }
+      out << "] ";
+    }
+    out << "]";
   }
 
-  /// Load NK landscape from file (specified by given path)
-  /// First non-commented line of file should give what emp::to_string would output.
+  /// Load NK landscape from file (specified by given path) into the landscape's own table.
+  /// Binary environment files (see AagosEnvFile.hpp) are detected automatically and copied in (to use
+  /// one in place instead, see AttachBinary and ShareLandscape). Otherwise,
+  /// first line starting with '[' should give what emp::to_string would output (other lines are skipped).
   ///  - [ [ fitness fitness fitness ... ] [ fitness fitness fitness ... ] ... ]
   ///  - Loaded landscape must be consistent with num_genes and gene_size
+  /// On failure, returns false (see GetLoadError for a description of what went wrong) and the
+  /// landscape is left untouched.
   bool LoadLandscape(const std::string & path) {
-    std::ifstream environment_fstream(path);
-    if (!environment_fstream.is_open()) {
-      std::cout << "Failed to open environment file (" << path << "). Exiting..." << std::endl;
-      exit(-1);
+    load_error.clear();
+    parsing::MappedFile file(path);
+    if (!file.IsOpen()) {
+      load_error = file.GetError();
+      return false;
     }
-    std::string cur_line;
-    emp::vector<std::string> line_components;
-    bool success = false;
-    while (!environment_fstream.eof()) {
-      std::getline(environment_fstream, cur_line);
-      emp::left_justify(cur_line); // Remove leading whitespace
-      if (cur_line == emp::empty_string()) continue; // Skip empty lines
-      else if (cur_line[0] == '#') continue; // Treat '#' as a commented line
-      else if (cur_line[0] == '[') {
-        // Attempt to read landscape state.
-        emp::remove_chars(cur_line, "["); // Remove opening brackets. Using closing brackets to delimit gene-associated states.
-        emp::left_justify(cur_line);
-        emp::right_justify(cur_line);
-        line_components.clear();
-        emp::slice(cur_line, line_components, ']');
-        // Last line component is blank space.
-        line_components.pop_back();
-        if (landscape.GetN() != line_components.size()) return false;
-        for (size_t n = 0; n < line_components.size(); ++n) {
-          std::string & values_str = line_components[n];
-          emp::vector<std::string> values;
-          emp::left_justify(values_str);
-          emp::right_justify(values_str);
-          emp::slice(values_str, values, ' ');
-          if (landscape.GetStateCount() != values.size()) return false;
-          for (size_t state = 0; state < values.size(); ++state) {
-            double value = emp::from_string<double>(values[state]);
-            landscape.SetState(n, state, value);
-          }
+    if (env_file::IsBinary(file)) return CopyBinaryTable(file, path);
+    parsing::Cursor cursor(file);
+    auto fail = [&](const std::string & msg) {
+      load_error = parsing::FormatError(path, cursor.GetLine(), msg);
+      return false;
+    };
+    if (!cursor.NextLineStartingWith('[') || !cursor.Consume('[')) return fail("Expected landscape ('[ [ ... ] ... ]').");
+    // Parse into a scratch table so a malformed file leaves the current landscape untouched.
+    const size_t state_count = landscape.GetStateCount();
+    emp::vector<emp::vector<double>> table(landscape.GetN(), emp::vector<double>(state_count));
+    for (size_t n = 0; n < landscape.GetN(); ++n) {
+      cursor.SkipSpaces();
+      if (!cursor.Consume('[')) return fail("Expected " + std::to_string(landscape.GetN()) + " gene tables; found " + std::to_string(n) + ".");
+      for (size_t state = 0; state < state_count; ++state) {
+        cursor.SkipSpaces();
+        if (!cursor.ParseDouble(table[n][state])) {
+          return fail("Gene " + std::to_string(n) + ": expected " + std::to_string(state_count)
+                      + " fitness values; found " + std::to_string(state) + ".");
         }
-        success = true;
-        break;
       }
+      cursor.SkipSpaces();
+      if (!cursor.Consume(']')) {
+        return fail("Gene " + std::to_string(n) + ": more than " + std::to_string(state_count) + " fitness values.");
+      }
+    }
+    cursor.SkipSpaces();
+    if (!cursor.Consume(']')) return fail("More than " + std::to_string(landscape.GetN()) + " gene tables.");
+    landscape.SetTable(std::move(table));
+    return true;
+  }
+
+  /// Find the landscape table in an already-opened binary environment file.
+  bool GetBinaryTable(const parsing::MappedFile & file, const std::string & path, const char *& table) {
+    env_file::Header header;
+    if (!env_file::ReadHeader(file, path, header, table, load_error)) return false;
+    if (!env_file::CheckHeader(header, path, env_file::MODEL::NK, num_genes, gene_size, load_error)) return false;
+    if (header.k != landscape.GetK() || header.payload_bytes != num_genes * landscape.GetStateCount() * sizeof(double)) {
+      load_error = path + ": Binary NK landscape has unexpected K or table size.";
+      return false;
+    }
+    return true;
+  }
+
+  /// Copy the table in an already-opened binary environment file into the landscape (see SetTable).
+  bool CopyBinaryTable(const parsing::MappedFile & file, const std::string & path) {
+    const char * payload = nullptr;
+    if (!GetBinaryTable(file, path, payload)) return false;
+    const size_t state_count = landscape.GetStateCount();
+    emp::vector<emp::vector<double>> table(landscape.GetN(), emp::vector<double>(state_count));
+    for (size_t n = 0; n < table.size(); ++n) {
+      std::memcpy(table[n].data(), payload + n * state_count * sizeof(double), state_count * sizeof(double));
+    }
+    landscape.SetTable(std::move(table));
+    return true;
+  }
+
+  /// Use the table in an already-opened binary environment file in place (see NKLandscape::AttachShared);
+  /// the landscape keeps the file mapped.
+  bool AttachMapped(const std::shared_ptr<parsing::MappedFile> & file, const std::string & path) {
+    const char * table = nullptr;
+    if (!GetBinaryTable(*file, path, table)) return false;
+    landscape.AttachShared((const double *)table, file); // Payload follows the 48-byte header (8-byte aligned).
+    SetSharedSource(path);
+    return true;
+  }
+
+  /// Remember where the shared table came from (see GetSharedSource).
+  void SetSharedSource(const std::string & path) {
+    char * abs_path = realpath(path.c_str(), nullptr);
+    shared_source = (abs_path != nullptr) ? abs_path : path;
+    std::free(abs_path);
+  }
+
+  /// Absolute path of the environment file the current shared table was loaded from (text or binary;
+  /// only meaningful while the landscape IsShared).
+  const std::string & GetSharedSource() const { return shared_source; }
+
+  /// Use the table in the binary environment file at path in place (see NKLandscape::AttachShared).
+  /// Returns false if the file can't be mapped or isn't a matching binary NK environment.
+  bool AttachBinary(const std::string & path) {
+    auto file = std::make_shared<parsing::MappedFile>(path);
+    if (!file->IsOpen()) {
+      load_error = file->GetError();
+      return false;
+    }
+    if (!env_file::IsBinary(*file)) {
+      load_error = path + ": Not a binary environment file.";
+      return false;
+    }
+    return AttachMapped(file, path);
+  }
+
+  /// Load the landscape at path as a read-only table shared by every process on the machine that
+  /// loads the same environment (memory-mapped, so the operating system keeps a single copy).
+  /// Binary environment files are mapped directly. Other files are parsed by the first process to
+  /// load them and published as a binary environment file in shared_dir (e.g., /dev/shm) for the
+  /// rest to map. Changes are kept privately by each run (copy-on-write; see NKLandscape).
+  bool ShareLandscape(const std::string & path, const std::string & shared_dir) {
+    load_error.clear();
+    {
+      parsing::MappedFile file(path);
+      if (!file.IsOpen()) {
+        load_error = file.GetError();
+        return false;
+      }
+      if (env_file::IsBinary(file)) return AttachBinary(path);
+    }
+    // Published copies are named after the source file (path, size, modification time) and the
+    // landscape's dimensions, so edited environments get a fresh copy.
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+      load_error = "Failed to stat file (" + path + ").";
+      return false;
     }
-    return success;
+    std::ostringstream id_stream;
+    id_stream << path << '|' << info.st_size << '|' << info.st_mtime << '|' << num_genes << '|' << gene_size;
+    uint64_t id = UINT64_C(0xcbf29ce484222325); // FNV-1a
+    for (char c : id_stream.str()) id = (id ^ (uint8_t)c) * UINT64_C(0x100000001b3);
+    std::ostringstream shared_stream;
+    shared_stream << shared_dir << (shared_dir.size() && shared_dir.back() != '/' ? "/" : "")
+                  << "aagos-nk-" << std::hex << id << ".env";
+    const std::string shared_path = shared_stream.str();
+    if (AttachBinary(shared_path)) {
+      SetSharedSource(path); // Published copies may be cleaned up; refer to the original.
+      return true;
+    }
+    // Not published yet (or unusable): parse, then publish (write a private copy and rename it into
+    // place, so other processes never map a partial file).
+    if (!LoadLandscape(path)) return false;
+    const std::string tmp_path = shared_path + ".tmp." + std::to_string(getpid());
+    if (!SaveLandscapeBinary(tmp_path) || std::rename(tmp_path.c_str(), shared_path.c_str()) != 0
+        || !AttachBinary(shared_path)) {
+      std::remove(tmp_path.c_str());
+      std::cout << "Unable to share landscape through " << shared_path << "; using a private copy." << std::endl;
+      load_error.clear();
+      return true;
+    }
+    SetSharedSource(path);
+    return true;
+  }
+
+  /// Save landscape as a binary environment file (see AagosEnvFile.hpp).
+  bool SaveLandscapeBinary(const std::string & path) const {
+    const size_t state_count = landscape.GetStateCount();
+    const auto header = env_file::MakeHeader(env_file::MODEL::NK, num_genes, gene_size, landscape.GetK(),
+                                             num_genes * state_count * sizeof(double));
+    return env_file::Write(path, header, [this, state_count](std::ostream & out) {
+      for (size_t n = 0; n < num_genes; ++n) {
+        if (landscape.HasTable()) {
+          out.write((const char *)landscape.GetLandscape()[n].data(), (std::streamsize)(state_count * sizeof(double)));
+          continue;
+        }
+        for (size_t state = 0; state < state_count; ++state) {
+          const double value = landscape.GetFitness(n, state);
+          out.write((const char *)&value, sizeof(double));
+        }
+      }
+    });
   }
+
+  /// Description of why the last call to LoadLandscape failed.
+  const std::string & GetLoadError() const { return load_error; }
 };
 
 }
@@ -8,6 +8,12 @@
 // #include "emp/bits/BitVector.hpp"
 #include "emp/bits/Bits.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
 /*
   NOTE: This class is adapted from the NKLandscape class in the Empirical library
     - https://github.com/devosoft/Empirical/blob/master/include/emp/Evolve/NK.hpp
@@ -32,6 +38,16 @@ namespace aagos {
 /// Note: Overly large Ns and Ks currently trigger a seg-fault, caused by trying to build a table
 /// that is larger than will fit in memory. If you are using small values for N and K,
 /// you can get better performance by using an NKLandscapeConst instead.
+///
+/// Procedural mode avoids materializing the table: each (n, state) value is derived on demand from a
+/// keyed hash, and only entries that have been explicitly set (e.g., by RandomizeStates) are stored.
+/// Memory use is then proportional to the number of changes rather than N * 2^(K+1).
+///
+/// Shared mode reads values from a read-only table owned elsewhere (e.g., a memory-mapped environment
+/// file shared by every process on a machine; see AttachShared). Explicitly set values are stored
+/// privately, as in procedural mode, so the shared table is never written. Shared mode is independent
+/// of procedural mode: once the shared table is dropped (DetachShared or Reset), a procedural
+/// landscape goes back to generating its values.
 
 class NKLandscape {
   private:
@@ -40,6 +56,38 @@ class NKLandscape {
     size_t state_count;   ///< The total number of states associated with each bit table.
     size_t total_count;   ///< The total number of states in the entire landscape space.
     emp::vector< emp::vector<double> > landscape;  ///< The actual values in the landscape.
+    bool procedural=false;      ///< Derive values from a keyed hash instead of storing a table?
+    uint64_t key=0;             ///< Hash key for procedural mode (re-drawn on Reset).
+    std::unordered_map<size_t, double> overrides; ///< Procedural/shared mode: explicitly set values (by n*state_count+state).
+    const double * shared_table=nullptr;          ///< Shared mode: read-only table (N * state_count values).
+    std::shared_ptr<const void> shared_owner;     ///< Shared mode: keeps shared_table alive.
+
+    /// SplitMix64 finalizer; maps (key, index) to a well-mixed 64-bit value.
+    static uint64_t Hash(uint64_t key, uint64_t index) {
+      uint64_t z = key + (index + 1) * 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    /// Procedurally generated value in [0, 1) for the given position in the landscape.
+    double GetProceduralFitness(size_t n, size_t state) const {
+      const size_t id = n * state_count + state;
+      if (overrides.size()) {
+        auto it = overrides.find(id);
+        if (it != overrides.end()) return it->second;
+      }
+      return (double)(Hash(key, id) >> 11) * 0x1.0p-53; // Top 53 bits => uniform double in [0, 1).
+    }
+
+    double GetSharedFitness(size_t n, size_t state) const {
+      const size_t id = n * state_count + state;
+      if (overrides.size()) {
+        auto it = overrides.find(id);
+        if (it != overrides.end()) return it->second;
+      }
+      return shared_table[id];
+    }
 
   public:
     NKLandscape() : N(0), K(0), state_count(0), total_count(0), landscape() { ; }
@@ -49,11 +97,12 @@ class NKLandscape {
     /// N is the length of bitstrings in your population, K is the number of neighboring sites
     /// the affect the fitness contribution of each site (i.e. epistasis or ruggedness), random
     /// is the random number generator to use to generate this landscape.
-    NKLandscape(size_t _N, size_t _K, emp::Random& random)
+    NKLandscape(size_t _N, size_t _K, emp::Random& random, bool _procedural=false)
       : N(_N), K(_K)
       , state_count(emp::IntPow<size_t>(2,K+1))
       , total_count(N * state_count)
-      , landscape(N)
+      , landscape(_procedural ? 0 : N)
+      , procedural(_procedural)
     {
       Reset(random);
     }
@@ -66,7 +115,16 @@ class NKLandscape {
       emp_assert(K < 32, K);
       emp_assert(K < N, K, N);
 
+      DetachShared(); // A new landscape replaces any shared table.
+
+      if (procedural) {
+        key = ((uint64_t)random.GetUInt() << 32) | (uint64_t)random.GetUInt();
+        overrides.clear();
+        return;
+      }
+
       // Build new landscape.
+      landscape.resize(N);
       for ( auto & ltable : landscape) {
         ltable.resize(state_count);
         for (double & pos : ltable) {
@@ -76,15 +134,29 @@ class NKLandscape {
     }
 
     /// Configure for new values of N and K.
-    void Config(size_t _N, size_t _K, emp::Random & random) {
+    /// If _procedural, values are generated on demand rather than stored in a table.
+    void Config(size_t _N, size_t _K, emp::Random & random, bool _procedural=false) {
       // Save new values.
       N = _N;  K = _K;
+      procedural = _procedural;
       state_count = emp::IntPow<size_t>(2,K+1);
       total_count = N * state_count;
-      landscape.resize(N);
+      if (procedural) landscape.clear();
+      else landscape.resize(N);
       Reset(random);
     }
 
+    /// Read values from table (N * state_count values, gene 0's table first) instead of storing
+    /// them. The table is never written (later changes are stored privately) and must stay valid as
+    /// long as owner does; the landscape holds on to owner until it is reset.
+    void AttachShared(const double * table, std::shared_ptr<const void> owner) {
+      emp_assert(table != nullptr);
+      landscape.clear();
+      overrides.clear();
+      shared_table = table;
+      shared_owner = std::move(owner);
+    }
+
     /// Returns N
     size_t GetN() const { return N; }
     /// Returns K
@@ -94,20 +166,59 @@ class NKLandscape {
     /// Get the total number of states possible in the landscape
     /// (i.e. the number of different fitness contributions in the table)
     size_t GetTotalCount() const { return total_count; }
+    /// Are landscape values generated on demand?
+    bool IsProcedural() const { return procedural && shared_table == nullptr; }
+    /// Stop using a shared table (see AttachShared). Procedural landscapes go back to generating
+    /// their values; others to storing a table of zeros.
+    void DetachShared() {
+      if (shared_table == nullptr) return;
+      shared_table = nullptr;
+      shared_owner.reset();
+      overrides.clear();
+      if (procedural) return;
+      landscape.resize(N);
+      for (auto & ltable : landscape) ltable.assign(state_count, 0.0);
+    }
+
+    /// Hash key of a procedural landscape.
+    uint64_t GetKey() const { return key; }
+    /// Explicitly set values of a procedural or shared landscape (by n * state_count + state).
+    const std::unordered_map<size_t, double> & GetOverrides() const { return overrides; }
+
+    /// Switch to procedural mode with the given hash key (e.g., to rebuild a logged landscape),
+    /// dropping any table and explicitly set values.
+    void SetProcedural(uint64_t _key) {
+      shared_table = nullptr;
+      shared_owner.reset();
+      landscape.clear();
+      overrides.clear();
+      procedural = true;
+      key = _key;
+    }
+
+    /// Are landscape values read from a shared table?
+    bool IsShared() const { return shared_table != nullptr; }
+    /// Is the full landscape stored in (this landscape's own) table?
+    bool HasTable() const { return !procedural && shared_table == nullptr; }
+    /// Number of explicitly set values stored by a procedural or shared landscape.
+    size_t GetNumOverrides() const { return overrides.size(); }
 
+    /// Full landscape table. Empty in procedural and shared modes (use GetFitness(n, state) instead).
     const emp::vector<emp::vector<double>>& GetLandscape() const { return landscape; }
 
     /// Get the fitness contribution of position [n] when it (and its K neighbors) have the value
     /// [state]
     double GetFitness(size_t n, size_t state) const {
       emp_assert(state < state_count, state, state_count);
+      if (shared_table != nullptr) return GetSharedFitness(n, state);
+      if (procedural) return GetProceduralFitness(n, state);
       return landscape[n][state];
     }
 
     /// Get the fitness of a whole  bitstring
     double GetFitness(const std::vector<size_t>& states) const {
       emp_assert(states.size() == N);
-      double total = landscape[0][states[0]];
+      double total = GetFitness(0, states[0]);
       for (size_t i = 1; i < N; i++) total += GetFitness(i,states[i]);
       return total;
     }
@@ -160,11 +271,41 @@ class NKLandscape {
       return fits;
     }
 
-    void SetState(size_t n, size_t state, double in_fit) { landscape[n][state] = in_fit; }
+    /// Replace every value with those in table (N tables of state_count values), leaving shared
+    /// mode. Procedural landscapes store them as explicitly set values.
+    void SetTable(emp::vector<emp::vector<double>> && table) {
+      emp_assert(table.size() == N, table.size(), N);
+      shared_table = nullptr;
+      shared_owner.reset();
+      overrides.clear();
+      if (!procedural) {
+        landscape = std::move(table);
+        return;
+      }
+      for (size_t n = 0; n < N; ++n) {
+        emp_assert(table[n].size() == state_count, table[n].size(), state_count);
+        for (size_t state = 0; state < state_count; ++state) overrides[n * state_count + state] = table[n][state];
+      }
+    }
+
+    void SetState(size_t n, size_t state, double in_fit) {
+      emp_assert(n < N && state < state_count, n, N, state, state_count);
+      if (procedural || shared_table != nullptr) overrides[n * state_count + state] = in_fit;
+      else landscape[n][state] = in_fit;
+    }
 
-    void RandomizeStates(emp::Random & random, size_t num_states=1) {
+    /// Set num_states random values to new random values. If changed is given, it's called with
+    /// each (n, state, value) set.
+    void RandomizeStates(emp::Random & random, size_t num_states=1,
+                         const std::function<void(size_t, size_t, double)> & changed=nullptr) {
       for (size_t i = 0; i < num_states; i++) {
-        SetState(random.GetUInt(N), random.GetUInt(state_count), random.GetDouble());
+        // Drawn in the order g++ evaluated the former SetState(n, state, value) call's arguments,
+        // so native runs keep their environments for a given seed.
+        const double value = random.GetDouble();
+        const size_t state = random.GetUInt(state_count);
+        const size_t n = random.GetUInt(N);
+        SetState(n, state, value);
+        if (changed) changed(n, state, value);
       }
     }
 
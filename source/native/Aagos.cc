@@ -6,6 +6,12 @@
 
 #include "../AagosConfig.hpp"
 #include "../AagosWorld.hpp"
+#include "../AagosPopFrame.hpp"
+#include "../AagosStreamServer.hpp"
+#include "../AagosIslands.hpp"
+#include "AagosMacroBench.hpp"
+#include "AagosSweep.hpp"
+#include "AagosBranches.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -14,6 +20,27 @@ int main(int argc, char* argv[])
   // Deal with loading config values via native interface (config file and command line args)
   config.Read(config_fname);
   auto args = emp::cl::ArgManager(argc, argv);
+
+  // Macro-benchmark mode: run canonical configurations end-to-end and report throughput.
+  std::string bench_name;
+  if (args.UseArg("--bench", bench_name, "Run macro benchmark (all, web, nk-16, gradient-16)") > 0) {
+    size_t bench_gens = 1000;
+    std::string bench_out = "macro_bench.csv";
+    args.UseArg("--bench-gens", bench_gens, "Generations per macro benchmark configuration");
+    args.UseArg("--bench-out", bench_out, "Macro benchmark results file");
+    const bool success = aagos::macro_bench::Run(bench_name, bench_gens, bench_out);
+    exit(success ? 0 : -1);
+  }
+
+  // Sweep mode: create or work through a directory-based job queue (see AagosSweep.hpp). Other
+  // configuration options apply to every job.
+  std::string sweep_dir;
+  std::string sweep_spec;
+  size_t sweep_workers = 1;
+  args.UseArg("--sweep", sweep_dir, "Run the jobs queued in a sweep directory");
+  args.UseArg("--sweep-init", sweep_spec, "Create the sweep directory's jobs from a sweep specification file");
+  args.UseArg("--sweep-workers", sweep_workers, "Number of sweep worker processes (0 = one per hardware thread)");
+
   if (args.ProcessConfigOptions(config, std::cout, "Aagos.cfg", "Aagos-macros.h") == false) exit(0);
   if (args.TestUnknown() == false) exit(0);  // If there are leftover args, throw an error.
 
@@ -24,7 +51,52 @@ int main(int argc, char* argv[])
   config.Write(std::cout);
   std::cout << "==============================\n" << std::endl;
 
+  if (sweep_dir.size()) {
+    aagos::AagosSweep sweep(sweep_dir);
+    if (sweep_spec.size()) exit(sweep.CreateJobs(sweep_spec, config) ? 0 : -1);
+    exit(sweep.Run(config, sweep_workers) ? 0 : -1);
+  }
+  if (sweep_spec.size()) {
+    std::cout << "--sweep-init needs a sweep directory (--sweep)." << std::endl;
+    exit(-1);
+  }
+
+  // Island model: the population is split into islands stepped in parallel (see AagosIslands.hpp).
+  if (config.NUM_ISLANDS() > 1) {
+    if (config.WEB_STREAM_PORT()) std::cout << "Note: web streaming is not supported with islands (NUM_ISLANDS > 1)." << std::endl;
+    if (config.PHASE_2_BRANCHES_FILE().size()) std::cout << "Note: phase two branches are not supported with islands (NUM_ISLANDS > 1)." << std::endl;
+    aagos::AagosIslandModel islands(config);
+    islands.Setup();
+    islands.Run();
+    return 0;
+  }
+
   aagos::AagosWorld world(config);
+
+  // Stream frames to attached web interfaces (see AagosStreamServer.hpp).
+  emp::Ptr<aagos::AagosStreamServer> stream_server = nullptr;
+  aagos::AagosPopFrame stream_frame;
+  if (config.WEB_STREAM_PORT()) {
+    stream_server = emp::NewPtr<aagos::AagosStreamServer>(config.WEB_STREAM_INTERVAL());
+    if (!stream_server->Start(config.WEB_STREAM_PORT())) exit(-1);
+    // Last update run by AagosWorld::Run (phase two runs PHASE_2_MAX_GENS + 1 more generations).
+    const size_t final_update = config.PHASE_2_ACTIVE() ? config.MAX_GENS() + config.PHASE_2_MAX_GENS() + 1
+                                                        : config.MAX_GENS();
+    world.OnStepEnd([&world, &stream_frame, stream_server, final_update](size_t update) {
+      const bool finished = (update == final_update);
+      if (!stream_server->Poll() && !(finished && stream_server->HasClients())) return;
+      stream_frame.Capture(world, stream_server->WantsFullPop(), true, stream_server->WantsSummary());
+      stream_frame.finished = finished;
+      stream_server->SendFrame(stream_frame);
+    });
+  }
+
   world.Setup();
-  world.Run();
+  const bool success = aagos::RunWorld(world, config);
+
+  if (stream_server != nullptr) {
+    stream_server->Drain(1000.0); // Give attached web interfaces a chance to receive the final frame.
+    stream_server.Delete();
+  }
+  return success ? 0 : -1;
 }
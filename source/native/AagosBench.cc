@@ -0,0 +1,274 @@
+// Microbenchmarks for core Aagos kernels.
+//
+// Usage: ./AagosBench [output.json] [min_seconds_per_benchmark]
+//
+// Each kernel is run across a grid of genome sizes, gene counts, and mutation rates (where relevant).
+// Results are written as JSON so they can be compared between versions.
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+#include "emp/math/Range.hpp"
+#include "emp/Evolve/World.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosOrg.hpp"
+#include "../AagosMutator.hpp"
+#include "../AagosWorld.hpp"
+
+namespace {
+
+/// Exposes AagosWorld internals that the benchmarks need to drive directly.
+class BenchWorld : public aagos::AagosWorld {
+public:
+  using aagos::AagosWorld::AagosWorld;
+
+  void EvaluateOrg(org_t & org) { evaluate_org(org); }
+  void Snapshot() { DoPopulationSnapshot(); }
+
+  void EvaluatePop() {
+    for (size_t org_id = 0; org_id < GetSize(); ++org_id) {
+      evaluate_org(GetOrg(org_id));
+    }
+  }
+};
+
+/// Exposes AagosOrg's genome analysis computations.
+class BenchOrg : public aagos::AagosOrg {
+public:
+  BenchOrg(const Genome & g) : aagos::AagosOrg(g) { ; }
+
+  void DoHistogramCalc() { ResetHistogram(); HistogramCalc(); }
+  void DoNeighborCalc() { NeighborCalc(); }
+};
+
+struct BenchParams {
+  size_t genome_size=0;
+  size_t num_genes=0;
+  size_t gene_size=8;
+  double mut_rate=0.0;
+  size_t pop_size=0;
+};
+
+struct BenchResult {
+  std::string name;
+  BenchParams params;
+  size_t iterations=0;    ///< Number of timed operations.
+  double total_sec=0.0;   ///< Total time spent across all timed operations.
+};
+
+emp::vector<BenchResult> results;
+double min_seconds = 0.25;
+
+/// Run batch repeatedly until at least min_seconds have elapsed. Each call to batch performs
+/// ops_per_batch operations. If given, reset runs (untimed) before every batch, so that each batch
+/// does the same work.
+void RunBenchmark(const std::string & name, const BenchParams & params, size_t ops_per_batch,
+                  const std::function<void()> & batch, const std::function<void()> & reset={})
+{
+  using clock_t = std::chrono::steady_clock;
+  if (reset) reset();
+  batch(); // Warm up.
+  size_t batches = 0;
+  double elapsed = 0.0;
+  do {
+    if (reset) reset();
+    const auto start = clock_t::now();
+    batch();
+    elapsed += std::chrono::duration<double>(clock_t::now() - start).count();
+    ++batches;
+  } while (elapsed < min_seconds);
+  BenchResult result;
+  result.name = name;
+  result.params = params;
+  result.iterations = batches * ops_per_batch;
+  result.total_sec = elapsed;
+  std::cout << "  " << name
+            << " (genome_size=" << params.genome_size
+            << ", num_genes=" << params.num_genes
+            << ", mut_rate=" << params.mut_rate
+            << "): " << (1e9 * elapsed / (double)result.iterations) << " ns/op" << std::endl;
+  results.emplace_back(result);
+}
+
+/// Configure a world for benchmarking. Outputs go to a scratch directory and are kept to a minimum.
+void ConfigureWorld(aagos::AagosConfig & config, const BenchParams & params, bool gradient) {
+  config.SEED(1);
+  config.POP_SIZE(params.pop_size);
+  config.GRADIENT_MODEL(gradient);
+  config.NUM_BITS(params.genome_size);
+  config.NUM_GENES(params.num_genes);
+  config.GENE_SIZE(params.gene_size);
+  config.MIN_SIZE(params.gene_size);
+  config.MAX_SIZE(params.genome_size * 2);
+  config.TOURNAMENT_SIZE(8);
+  config.GENE_MOVE_PROB(params.mut_rate);
+  config.BIT_FLIP_PROB(params.mut_rate);
+  config.BIT_INS_PROB(params.mut_rate);
+  config.BIT_DEL_PROB(params.mut_rate);
+  config.PHASE_2_ACTIVE(false);
+  config.PHYLOGENY_TRACKING(false);
+  config.PRINT_INTERVAL(1000000);
+  config.SUMMARY_INTERVAL(1000000);
+  config.SNAPSHOT_INTERVAL(1000000);
+  config.DATA_FILEPATH("./bench_output/");
+}
+
+emp::vector<aagos::AagosOrg::Genome> MakeGenomes(const BenchParams & params, size_t count, emp::Random & random) {
+  emp::vector<aagos::AagosOrg::Genome> genomes;
+  for (size_t i = 0; i < count; ++i) {
+    genomes.emplace_back(params.genome_size, params.num_genes, params.gene_size);
+    genomes.back().Randomize(random);
+  }
+  return genomes;
+}
+
+void BenchEvaluate(const BenchParams & params, bool gradient) {
+  aagos::AagosConfig config;
+  ConfigureWorld(config, params, gradient);
+  BenchWorld world(config);
+  world.Setup();
+  RunBenchmark(gradient ? "evaluate_org_gradient" : "evaluate_org_nk", params, world.GetSize(),
+               [&world]() { world.EvaluatePop(); });
+}
+
+void BenchMutation(const BenchParams & params, bool per_gene) {
+  emp::Random random(1);
+  aagos::AagosMutator mutator(params.num_genes,
+                              emp::Range<size_t>(params.gene_size, params.genome_size * 2),
+                              params.mut_rate, params.mut_rate, params.mut_rate, params.mut_rate);
+  // Mutations change genome lengths, so every batch starts again from the same genomes.
+  const emp::vector<aagos::AagosOrg::Genome> genomes = MakeGenomes(params, params.pop_size, random);
+  emp::vector<aagos::AagosOrg> orgs;
+  for (const auto & genome : genomes) orgs.emplace_back(genome);
+  auto reset = [&]() {
+    for (size_t i = 0; i < orgs.size(); ++i) {
+      orgs[i].GetGenome().bits = genomes[i].bits;
+      orgs[i].GetGenome().gene_starts = genomes[i].gene_starts;
+    }
+  };
+  if (per_gene) {
+    RunBenchmark("ApplyMutationsPerGenePerSite", params, orgs.size(), [&]() {
+      for (auto & org : orgs) mutator.ApplyMutationsPerGenePerSite(org, random);
+    }, reset);
+  } else {
+    RunBenchmark("ApplyMutations", params, orgs.size(), [&]() {
+      for (auto & org : orgs) mutator.ApplyMutations(org, random);
+    }, reset);
+  }
+}
+
+void BenchGenomeAnalysis(const BenchParams & params) {
+  emp::Random random(1);
+  emp::vector<BenchOrg> orgs;
+  for (auto & genome : MakeGenomes(params, params.pop_size, random)) orgs.emplace_back(genome);
+  RunBenchmark("HistogramCalc", params, orgs.size(), [&orgs]() {
+    for (auto & org : orgs) org.DoHistogramCalc();
+  });
+  RunBenchmark("NeighborCalc", params, orgs.size(), [&orgs]() {
+    for (auto & org : orgs) org.DoNeighborCalc();
+  });
+}
+
+void BenchTournamentSelect(const BenchParams & params) {
+  aagos::AagosConfig config;
+  ConfigureWorld(config, params, true);
+  BenchWorld world(config);
+  world.Setup();
+  world.EvaluatePop();
+  using clock_t = std::chrono::steady_clock;
+  // Selection fills the next generation, so we need to advance the world between timed calls.
+  size_t rounds = 0;
+  double elapsed = 0.0;
+  do {
+    const auto start = clock_t::now();
+    emp::TournamentSelect(world, config.TOURNAMENT_SIZE(), config.POP_SIZE());
+    elapsed += std::chrono::duration<double>(clock_t::now() - start).count();
+    world.Update();
+    world.ClearCache();
+    world.EvaluatePop();
+    ++rounds;
+  } while (elapsed < min_seconds);
+  BenchResult result;
+  result.name = "TournamentSelect";
+  result.params = params;
+  result.iterations = rounds * config.POP_SIZE();
+  result.total_sec = elapsed;
+  std::cout << "  TournamentSelect (genome_size=" << params.genome_size
+            << ", num_genes=" << params.num_genes << "): "
+            << (1e9 * elapsed / (double)result.iterations) << " ns/op" << std::endl;
+  results.emplace_back(result);
+}
+
+void BenchPopulationSnapshot(const BenchParams & params) {
+  aagos::AagosConfig config;
+  ConfigureWorld(config, params, true);
+  BenchWorld world(config);
+  world.Setup();
+  world.EvaluatePop();
+  RunBenchmark("DoPopulationSnapshot", params, world.GetSize(), [&world]() { world.Snapshot(); });
+}
+
+void WriteJSON(std::ostream & out) {
+  out << "{\n";
+  out << "  \"suite\": \"AagosBench\",\n";
+  out << "  \"min_seconds\": " << min_seconds << ",\n";
+  out << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto & r = results[i];
+    out << "    {"
+        << "\"name\": \"" << r.name << "\", "
+        << "\"genome_size\": " << r.params.genome_size << ", "
+        << "\"num_genes\": " << r.params.num_genes << ", "
+        << "\"gene_size\": " << r.params.gene_size << ", "
+        << "\"mut_rate\": " << r.params.mut_rate << ", "
+        << "\"pop_size\": " << r.params.pop_size << ", "
+        << "\"iterations\": " << r.iterations << ", "
+        << "\"total_sec\": " << r.total_sec << ", "
+        << "\"ns_per_op\": " << (1e9 * r.total_sec / (double)r.iterations)
+        << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  const std::string output_path = (argc > 1) ? argv[1] : "bench_results.json";
+  if (argc > 2) min_seconds = std::stod(argv[2]);
+
+  const emp::vector<size_t> genome_sizes = {64, 256, 1024};
+  const emp::vector<size_t> gene_counts = {8, 16, 32};
+  const emp::vector<double> mut_rates = {0.001, 0.01};
+  const size_t pop_size = 1000;
+
+  for (size_t genome_size : genome_sizes) {
+    for (size_t num_genes : gene_counts) {
+      BenchParams params;
+      params.genome_size = genome_size;
+      params.num_genes = num_genes;
+      params.pop_size = pop_size;
+      std::cout << "== genome_size=" << genome_size << ", num_genes=" << num_genes << " ==" << std::endl;
+      BenchEvaluate(params, false);
+      BenchEvaluate(params, true);
+      BenchGenomeAnalysis(params);
+      BenchTournamentSelect(params);
+      BenchPopulationSnapshot(params);
+      for (double mut_rate : mut_rates) {
+        params.mut_rate = mut_rate;
+        BenchMutation(params, false);
+        BenchMutation(params, true);
+      }
+    }
+  }
+
+  std::ofstream out(output_path);
+  WriteJSON(out);
+  std::cout << "Wrote " << results.size() << " benchmark results to " << output_path << std::endl;
+}
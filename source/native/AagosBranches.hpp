@@ -0,0 +1,176 @@
+#ifndef AAGOS_BRANCHES_HPP
+#define AAGOS_BRANCHES_HPP
+
+#include "emp/base/vector.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosWorld.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace aagos {
+
+/// Phase-two fan-out: at the end of phase one, the run forks once per branch listed in
+/// PHASE_2_BRANCHES_FILE. Each child starts from the parent's in-memory phase-one population (fork
+/// copies it without serializing anything), applies its own PHASE_2_* settings, and runs phase two
+/// into DATA_FILEPATH/phase2_<branch>/ (output files and console log.txt).
+///
+/// Branches file: one branch per line, a name followed by PHASE_2_* settings and their values, e.g.
+///   static      PHASE_2_CHANGE_MAGNITUDE 0
+///   fast_change PHASE_2_CHANGE_MAGNITUDE 4 PHASE_2_CHANGE_FREQUENCY 1
+/// Blank lines and lines starting with # are ignored.
+///
+/// Each branch is a new world that continues the phase-one world (see AagosWorld::ContinueFrom): same
+/// population, update, random number generator state, and environment, so a branch whose settings
+/// match the run's own PHASE_2_* settings evolves exactly as the unbranched run would. Only its
+/// phylogeny (if tracked) starts over, at the branch point.
+class AagosPhaseTwoBranches {
+public:
+  struct Branch {
+    std::string name;
+    emp::vector<std::pair<std::string, std::string>> settings;
+  };
+
+protected:
+  AagosConfig & config;
+  emp::vector<Branch> branches;
+
+  /// Run branch in the (forked) child process; never returns.
+  [[noreturn]] void RunBranch(AagosWorld & world, const Branch & branch, const std::string & out_path) {
+    const int log_fd = open((out_path + "log.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd >= 0) {
+      dup2(log_fd, STDOUT_FILENO);
+      dup2(log_fd, STDERR_FILENO);
+      close(log_fd);
+    }
+    {
+      AagosConfig branch_config;
+      std::stringstream config_stream;
+      config.Write(config_stream);
+      branch_config.Read(config_stream);
+      for (const auto & setting : branch.settings) branch_config.Set(setting.first, setting.second);
+      branch_config.DATA_FILEPATH(out_path);
+      branch_config.LOAD_ANCESTOR(false); // The population comes from phase one.
+      std::cout << "==> Phase two branch " << branch.name << " (from update " << world.GetUpdate() << ") <==" << std::endl;
+      branch_config.Write(std::cout);
+      AagosWorld branch_world(branch_config);
+      branch_world.Setup();
+      branch_world.ContinueFrom(world);
+      branch_world.RunPhaseTwo();
+    }
+    std::cout.flush();
+    _exit(0);
+  }
+
+public:
+  AagosPhaseTwoBranches(AagosConfig & cfg) : config(cfg) { ; }
+
+  const emp::vector<Branch> & GetBranches() const { return branches; }
+
+  /// Load branches from path. Returns false (with a message) if the file is unusable.
+  bool Load(const std::string & path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      std::cout << "Unable to open phase two branches file (" << path << ")." << std::endl;
+      return false;
+    }
+    branches.clear();
+    std::string line;
+    size_t line_num = 0;
+    while (std::getline(file, line)) {
+      ++line_num;
+      std::istringstream line_stream(line);
+      Branch branch;
+      if (!(line_stream >> branch.name) || branch.name[0] == '#') continue;
+      std::string name, value;
+      while (line_stream >> name) {
+        if (name.rfind("PHASE_2_", 0) != 0 || !config.Has(name) || !(line_stream >> value)) {
+          std::cout << path << ":" << line_num << ": Expected PHASE_2_* settings and their values." << std::endl;
+          return false;
+        }
+        branch.settings.emplace_back(name, value);
+      }
+      const bool duplicate = std::any_of(branches.begin(), branches.end(), [&](const Branch & b) { return b.name == branch.name; });
+      if (duplicate || branch.name.find('/') != std::string::npos) {
+        std::cout << path << ":" << line_num << ": Branch names must be unique and can't contain '/'." << std::endl;
+        return false;
+      }
+      branches.emplace_back(std::move(branch));
+    }
+    if (branches.empty()) {
+      std::cout << path << ": No phase two branches." << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /// Fork a phase two for every branch from world (which should have just finished phase one), with
+  /// up to max_processes branches running at once (0 => one per hardware thread). Returns false if
+  /// any branch failed.
+  bool Run(AagosWorld & world, size_t max_processes) {
+    std::string output_path = config.DATA_FILEPATH();
+    if (output_path.back() != '/') output_path += '/';
+    if (!max_processes) max_processes = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::cout << "==> Branching into " << branches.size() << " phase two runs <==" << std::endl;
+    emp::vector<std::pair<pid_t, size_t>> running;  // (pid, branch id)
+    size_t failed = 0;
+    auto wait_one = [&]() {
+      int status = 0;
+      const pid_t pid = wait(&status);
+      auto it = std::find_if(running.begin(), running.end(), [pid](const auto & r) { return r.first == pid; });
+      if (it == running.end()) return;
+      const Branch & branch = branches[it->second];
+      if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        std::cout << "  Branch " << branch.name << " finished." << std::endl;
+      } else {
+        std::cout << "  Branch " << branch.name << " failed (see " << output_path << "phase2_" << branch.name << "/log.txt)." << std::endl;
+        ++failed;
+      }
+      running.erase(it);
+    };
+    for (size_t branch_id = 0; branch_id < branches.size(); ++branch_id) {
+      while (running.size() >= max_processes) wait_one();
+      const std::string out_path = output_path + "phase2_" + branches[branch_id].name + "/";
+      mkdir(out_path.c_str(), ACCESSPERMS);
+      std::cout.flush();
+      const pid_t pid = fork();
+      if (pid < 0) {
+        std::cout << "  Unable to start branch " << branches[branch_id].name << "." << std::endl;
+        ++failed;
+        continue;
+      }
+      if (pid == 0) RunBranch(world, branches[branch_id], out_path);
+      std::cout << "  Branch " << branches[branch_id].name << " started." << std::endl;
+      running.emplace_back(pid, branch_id);
+    }
+    while (running.size()) wait_one();
+    return failed == 0;
+  }
+};
+
+/// Run world (already set up) as configured: phase one, then phase two in place or, with
+/// PHASE_2_BRANCHES_FILE, fanned out into branches. Returns false if a branch failed.
+inline bool RunWorld(AagosWorld & world, AagosConfig & config) {
+  if (!config.PHASE_2_ACTIVE() || config.PHASE_2_BRANCHES_FILE().empty()) {
+    world.Run();
+    return true;
+  }
+  AagosPhaseTwoBranches branches(config);
+  if (!branches.Load(config.PHASE_2_BRANCHES_FILE())) return false;
+  world.RunPhaseOne();
+  return branches.Run(world, config.PHASE_2_BRANCH_PROCESSES());
+}
+
+}
+
+#endif
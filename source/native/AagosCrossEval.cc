@@ -0,0 +1,198 @@
+// Cross-evaluate populations and environments: the fitness of every organism in a set of population
+// snapshots under every environment in a set of environment files, using the same evaluators as
+// AagosWorld (see AagosEvaluators.hpp).
+//
+// Usage:
+//   ./AagosCrossEval <nk|gradient> <num_genes> <gene_size> <output prefix>
+//                    --pops <snapshot> [<snapshot> ...] --envs <environment> [<environment> ...] [--threads <n>]
+//
+// Snapshots may be csv or binary population snapshots; environments may be text or binary
+// environment files (binary NK landscapes are memory-mapped rather than copied). Writes:
+//   - <prefix>.csv: one row per organism (pop, org_id, then its fitness under env_0, env_1, ...)
+//   - <prefix>.bin: the same matrix as float64, row-major (header: 8-byte magic "AAGOSXEV", then
+//     uint64 num_orgs and num_envs)
+//   - <prefix>_index.csv: which file each pop and env id refers to (and each pop's rows)
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../AagosEnvFile.hpp"
+#include "../AagosEvaluators.hpp"
+#include "../AagosParsing.hpp"
+#include "../AagosSnapshot.hpp"
+#include "../AagosThreadPool.hpp"
+#include "../GradientFitnessModel.hpp"
+#include "../NKFitnessModel.hpp"
+
+namespace {
+
+using genome_t = aagos::AagosOrg::Genome;
+
+constexpr char MAGIC[8] = {'A','A','G','O','S','X','E','V'};
+
+void PrintUsage() {
+  std::cout << "Usage:" << std::endl;
+  std::cout << "  AagosCrossEval <nk|gradient> <num_genes> <gene_size> <output prefix>" << std::endl;
+  std::cout << "                 --pops <snapshot> [...] --envs <environment> [...] [--threads <n>]" << std::endl;
+}
+
+bool LoadPopulation(const std::string & path, size_t num_genes, size_t gene_size, size_t num_threads,
+                    emp::vector<genome_t> & genomes)
+{
+  aagos::parsing::MappedFile file(path);
+  std::string error;
+  if (!file.IsOpen()) error = file.GetError();
+  else if (aagos::snapshot::IsBinarySnapshot(file)) {
+    aagos::snapshot::LoadBinary(file, path, num_genes, gene_size, num_threads, genomes, error);
+  } else if (aagos::snapshot::IsCSVSnapshot(file)) {
+    aagos::snapshot::LoadCSV(file, path, num_genes, gene_size, num_threads, genomes, error);
+  } else {
+    error = path + ": Not a population snapshot.";
+  }
+  if (error.size()) {
+    std::cout << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 5) {
+    PrintUsage();
+    return 1;
+  }
+  const std::string model_name(argv[1]);
+  if (model_name != "nk" && model_name != "gradient") {
+    std::cout << "Unknown model (" << model_name << "). Expected nk or gradient." << std::endl;
+    return 1;
+  }
+  const bool gradient = (model_name == "gradient");
+  size_t num_genes = 0;
+  size_t gene_size = 0;
+  if (!aagos::parsing::ParseSize(argv[2], num_genes) || !aagos::parsing::ParseSize(argv[3], gene_size)
+      || num_genes == 0 || gene_size == 0) {
+    std::cout << "Expected positive integers for num_genes and gene_size (" << argv[2] << ", " << argv[3] << ")." << std::endl;
+    PrintUsage();
+    return 1;
+  }
+  const std::string prefix(argv[4]);
+  emp::vector<std::string> pop_paths;
+  emp::vector<std::string> env_paths;
+  size_t num_threads = 0;
+  emp::vector<std::string> * list = nullptr;
+  for (int i = 5; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--pops") list = &pop_paths;
+    else if (arg == "--envs") list = &env_paths;
+    else if (arg == "--threads") {
+      if (i + 1 >= argc || !aagos::parsing::ParseSize(argv[++i], num_threads)) {
+        std::cout << "Expected a number of threads after --threads." << std::endl;
+        PrintUsage();
+        return 1;
+      }
+      list = nullptr;
+    }
+    else if (list != nullptr) list->emplace_back(arg);
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (pop_paths.empty() || env_paths.empty()) {
+    PrintUsage();
+    return 1;
+  }
+  aagos::AagosThreadPool pool(num_threads);
+
+  // Load populations (every organism gets a row).
+  emp::vector<genome_t> genomes;
+  emp::vector<size_t> pop_starts;
+  for (const std::string & path : pop_paths) {
+    emp::vector<genome_t> pop;
+    if (!LoadPopulation(path, num_genes, gene_size, pool.GetNumThreads(), pop)) return 1;
+    pop_starts.emplace_back(genomes.size());
+    for (genome_t & genome : pop) genomes.emplace_back(std::move(genome));
+    std::cout << "Loaded " << pop.size() << " organisms from " << path << "." << std::endl;
+  }
+  pop_starts.emplace_back(genomes.size());
+  const size_t num_orgs = genomes.size();
+  const size_t num_envs = env_paths.size();
+
+  // Evaluate every organism under each environment in turn (one environment in memory at a time).
+  emp::vector<double> matrix(num_orgs * num_envs, 0.0);
+  emp::Random random(1);
+  for (size_t env_id = 0; env_id < num_envs; ++env_id) {
+    const std::string & path = env_paths[env_id];
+    std::function<double(const genome_t &)> evaluate;
+    emp::Ptr<aagos::NKFitnessModel> nk = nullptr;
+    emp::Ptr<aagos::GradientFitnessModel> targets = nullptr;
+    bool loaded = false;
+    if (gradient) {
+      targets = emp::NewPtr<aagos::GradientFitnessModel>(random, num_genes, gene_size);
+      loaded = targets->LoadTargets(path);
+      if (!loaded) std::cout << targets->GetLoadError() << std::endl;
+      evaluate = [&](const genome_t & genome) { return aagos::eval::EvaluateGradient(*targets, genome, num_genes, gene_size); };
+    } else {
+      // Binary landscapes are used in place (the model is procedural, so no table is generated
+      // just to be dropped); text landscapes are parsed into the model's table.
+      bool binary = false;
+      {
+        aagos::parsing::MappedFile file(path);
+        binary = file.IsOpen() && aagos::env_file::IsBinary(file);
+      }
+      nk = emp::NewPtr<aagos::NKFitnessModel>(random, num_genes, gene_size, binary);
+      loaded = binary ? nk->AttachBinary(path) : nk->LoadLandscape(path);
+      if (!loaded) std::cout << nk->GetLoadError() << std::endl;
+      evaluate = [&](const genome_t & genome) { return aagos::eval::EvaluateNK(*nk, genome, num_genes, gene_size); };
+    }
+    if (loaded) {
+      pool.Run(num_orgs, [&](size_t begin, size_t end, size_t) {
+        for (size_t org_id = begin; org_id < end; ++org_id) matrix[org_id * num_envs + env_id] = evaluate(genomes[org_id]);
+      });
+      std::cout << "Evaluated " << num_orgs << " organisms under " << path << "." << std::endl;
+    }
+    if (nk != nullptr) nk.Delete();
+    if (targets != nullptr) targets.Delete();
+    if (!loaded) return 1;
+  }
+
+  // Write results.
+  std::ofstream csv(prefix + ".csv");
+  csv << "pop,org_id";
+  for (size_t env_id = 0; env_id < num_envs; ++env_id) csv << ",env_" << env_id;
+  csv << "\n";
+  for (size_t pop_id = 0; pop_id < pop_paths.size(); ++pop_id) {
+    for (size_t row = pop_starts[pop_id]; row < pop_starts[pop_id + 1]; ++row) {
+      csv << pop_id << "," << (row - pop_starts[pop_id]);
+      for (size_t env_id = 0; env_id < num_envs; ++env_id) csv << "," << matrix[row * num_envs + env_id];
+      csv << "\n";
+    }
+  }
+  std::ofstream bin(prefix + ".bin", std::ios::binary | std::ios::trunc);
+  const uint64_t dims[2] = {(uint64_t)num_orgs, (uint64_t)num_envs};
+  bin.write(MAGIC, sizeof(MAGIC));
+  bin.write((const char *)dims, sizeof(dims));
+  bin.write((const char *)matrix.data(), (std::streamsize)(matrix.size() * sizeof(double)));
+  std::ofstream index(prefix + "_index.csv");
+  index << "kind,id,path,first_row,num_rows\n";
+  for (size_t pop_id = 0; pop_id < pop_paths.size(); ++pop_id) {
+    index << "pop," << pop_id << ",\"" << pop_paths[pop_id] << "\"," << pop_starts[pop_id] << ","
+          << (pop_starts[pop_id + 1] - pop_starts[pop_id]) << "\n";
+  }
+  for (size_t env_id = 0; env_id < num_envs; ++env_id) index << "env," << env_id << ",\"" << env_paths[env_id] << "\",,\n";
+  if (!csv || !bin || !index) {
+    std::cout << "Failed to write results (" << prefix << ")." << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << num_orgs << " x " << num_envs << " fitness matrix to " << prefix << ".csv/.bin." << std::endl;
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Convert Aagos environment files between the text (emp::to_string) and binary formats.
+//
+// Usage:
+//   ./AagosEnvTool to-binary <nk|gradient> <num_genes> <gene_size> <input.env> <output.envb>
+//   ./AagosEnvTool to-text <input.envb> <output.env>
+//   ./AagosEnvTool materialize <run directory> <update> <output.envb>
+//
+// to-binary and to-text accept either input format; the input format is detected automatically.
+// materialize rebuilds the environment in effect at an update of a run with ENV_LOG (from the run's
+// environment_log.bin and keyframes; see AagosEnvLog.hpp).
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "emp/math/Random.hpp"
+
+#include "../AagosEnvFile.hpp"
+#include "../AagosEnvLog.hpp"
+#include "../AagosParsing.hpp"
+#include "../GradientFitnessModel.hpp"
+#include "../NKFitnessModel.hpp"
+
+namespace {
+
+void PrintUsage() {
+  std::cout << "Usage:" << std::endl;
+  std::cout << "  AagosEnvTool to-binary <nk|gradient> <num_genes> <gene_size> <input> <output>" << std::endl;
+  std::cout << "  AagosEnvTool to-text <input.envb> <output>" << std::endl;
+  std::cout << "  AagosEnvTool materialize <run directory> <update> <output.envb>" << std::endl;
+}
+
+/// Load the environment at in_path into a model of the given type/dimensions and write it to
+/// out_path (in binary if binary, text otherwise).
+bool Convert(aagos::env_file::MODEL model, size_t num_genes, size_t gene_size,
+             const std::string & in_path, const std::string & out_path, bool binary)
+{
+  emp::Random random(1);
+  if (model == aagos::env_file::MODEL::NK) {
+    aagos::NKFitnessModel nk(random, num_genes, gene_size);
+    if (!nk.LoadLandscape(in_path)) {
+      std::cout << nk.GetLoadError() << std::endl;
+      return false;
+    }
+    if (binary) return nk.SaveLandscapeBinary(out_path);
+    std::ofstream out(out_path);
+    nk.PrintLandscape(out);
+    out << std::endl;
+    return (bool)out;
+  }
+  if (model != aagos::env_file::MODEL::GRADIENT) {
+    std::cout << in_path << ": Unknown environment model (" << (uint32_t)model << ")." << std::endl;
+    return false;
+  }
+  aagos::GradientFitnessModel gradient(random, num_genes, gene_size);
+  if (!gradient.LoadTargets(in_path)) {
+    std::cout << gradient.GetLoadError() << std::endl;
+    return false;
+  }
+  if (binary) return gradient.SaveTargetsBinary(out_path);
+  std::ofstream out(out_path);
+  gradient.PrintTargets(out);
+  out << std::endl;
+  return (bool)out;
+}
+
+/// Rebuild the environment in effect at update from the environment log in run_dir (the last
+/// keyframe in effect, plus the changes since) and write it to out_path as a binary environment file.
+bool Materialize(const std::string & run_dir, size_t update, const std::string & out_path) {
+  aagos::env_log::Reader log(run_dir);
+  if (!log.IsOpen()) {
+    std::cout << log.GetError() << std::endl;
+    return false;
+  }
+  aagos::env_log::Reader::RebuildInfo info;
+  emp::Random random(1);
+  bool saved = false;
+  if (log.GetModel() == aagos::env_file::MODEL::NK) {
+    // Procedural, so no table is generated just to be replaced.
+    aagos::NKFitnessModel nk(random, log.GetNumGenes(), log.GetGeneSize(), true);
+    if (!log.Rebuild(update, nk, info)) {
+      std::cout << log.GetError() << std::endl;
+      return false;
+    }
+    saved = nk.SaveLandscapeBinary(out_path);
+  } else {
+    aagos::GradientFitnessModel gradient(random, log.GetNumGenes(), log.GetGeneSize());
+    if (!log.Rebuild(update, gradient, info)) {
+      std::cout << log.GetError() << std::endl;
+      return false;
+    }
+    saved = gradient.SaveTargetsBinary(out_path);
+  }
+  if (!saved) return false;
+  std::cout << "Update " << update << ": keyframe " << info.keyframe_id << " (from update "
+            << info.keyframe_update << ") plus " << info.num_changes << " changes." << std::endl;
+  return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    PrintUsage();
+    return 1;
+  }
+  const std::string command(argv[1]);
+  bool success = false;
+  if (command == "to-binary" && argc == 7) {
+    const std::string model_name(argv[2]);
+    if (model_name != "nk" && model_name != "gradient") {
+      std::cout << "Unknown model (" << model_name << "). Expected nk or gradient." << std::endl;
+      return 1;
+    }
+    size_t num_genes = 0;
+    size_t gene_size = 0;
+    if (!aagos::parsing::ParseSize(argv[3], num_genes) || !aagos::parsing::ParseSize(argv[4], gene_size)
+        || num_genes == 0 || gene_size == 0) {
+      std::cout << "Expected positive integers for num_genes and gene_size (" << argv[3] << ", " << argv[4] << ")." << std::endl;
+      PrintUsage();
+      return 1;
+    }
+    const auto model = (model_name == "nk") ? aagos::env_file::MODEL::NK : aagos::env_file::MODEL::GRADIENT;
+    success = Convert(model, num_genes, gene_size, argv[5], argv[6], true);
+  } else if (command == "to-text" && argc == 4) {
+    // Model and dimensions come from the binary header.
+    const std::string in_path(argv[2]);
+    aagos::parsing::MappedFile file(in_path);
+    aagos::env_file::Header header;
+    const char * payload = nullptr;
+    std::string error;
+    if (!file.IsOpen()) error = file.GetError();
+    else aagos::env_file::ReadHeader(file, in_path, header, payload, error);
+    if (error.empty() && !aagos::env_file::IsKnownModel(header.model)) {
+      error = in_path + ": Unknown environment model (" + std::to_string(header.model) + ").";
+    }
+    if (error.size()) {
+      std::cout << error << std::endl;
+      return 1;
+    }
+    success = Convert((aagos::env_file::MODEL)header.model, header.num_genes, header.gene_size,
+                      in_path, argv[3], false);
+  } else if (command == "materialize" && argc == 5) {
+    size_t update = 0;
+    if (!aagos::parsing::ParseSize(argv[3], update)) {
+      std::cout << "Expected an update number (" << argv[3] << ")." << std::endl;
+      PrintUsage();
+      return 1;
+    }
+    success = Materialize(argv[2], update, argv[4]);
+  } else {
+    PrintUsage();
+    return 1;
+  }
+  if (!success) {
+    std::cout << (command == "materialize" ? "Materialization failed." : "Conversion failed.") << std::endl;
+    return 1;
+  }
+  return 0;
+}
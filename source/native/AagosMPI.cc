@@ -0,0 +1,338 @@
+// Island model across processes: one island per MPI rank (see AagosIslands.hpp for the threaded,
+// single-process island model, whose topology and per-island configuration this shares).
+// Build with make mpi; run with, e.g.: mpirun -np 4 ./AagosMPI -POP_SIZE 4000 -MIGRATION_TOPOLOGY ring
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/config/ArgManager.hpp"
+#include "emp/config/command_line.hpp"
+#include "emp/data/DataFile.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosIslands.hpp"
+#include "../AagosSnapshot.hpp"
+
+namespace aagos {
+
+/// This rank's island, plus its side of the migrant exchange with the other ranks.
+///
+/// Migrants are sent as packed genome records (the binary snapshot record layout; see
+/// AagosSnapshot.hpp) with non-blocking sends, and the matching receives are posted at the same
+/// time. Messages are only waited on after the next generation's evaluation, so communication
+/// overlaps with evaluation; immigrants therefore replace residents one generation after they left
+/// their home island (the threaded island model delivers them in the same generation).
+///
+/// Every rank knows who sends to whom: ring and full topologies are fixed (full topology sends a
+/// message, possibly empty, to every other rank), and random topology destinations are drawn by
+/// every rank from identically seeded streams.
+class AagosMPIIsland {
+public:
+  using genome_t = AagosWorld::genome_t;
+  using TOPOLOGY = AagosIslandModel::TOPOLOGY;
+
+  static constexpr int MIGRANT_TAG = 1;
+
+  /// Per-island statistics gathered on rank 0.
+  enum STAT { MEAN_FITNESS=0, MAX_FITNESS, TOTAL_FITNESS, TOTAL_LENGTH, SIZE, IMMIGRANTS, NUM_STATS };
+
+protected:
+  AagosConfig & config;
+  int rank;
+  int num_ranks;
+  TOPOLOGY topology=TOPOLOGY::RING;
+  std::string output_path;
+
+  AagosConfig island_config;
+  emp::Ptr<AagosIsland> island;
+  emp::Ptr<emp::Random> migration_random;   ///< Random topology destinations (same stream on every rank).
+  emp::Ptr<emp::DataFile> stats_file;       ///< Rank 0 only.
+
+  emp::vector<size_t> destinations;         ///< Random topology: each rank's current destination.
+  emp::vector<emp::vector<uint64_t>> send_buffers;  ///< Packed migrants, by destination rank.
+  emp::vector<emp::vector<uint64_t>> recv_buffers;  ///< Packed migrants, by source rank.
+  emp::vector<MPI_Request> send_requests;
+  emp::vector<MPI_Request> recv_requests;
+  emp::vector<int> recv_sources;
+  emp::vector<genome_t> arrivals;           ///< Unpacked immigrants waiting to be injected.
+  size_t immigrants=0;                      ///< Organisms received (running total).
+
+  emp::vector<double> local_stats;
+  emp::vector<double> gathered_stats;       ///< Rank 0: NUM_STATS values per rank.
+
+  size_t GetIslandSize(int island_rank) const {
+    return AagosIslandModel::GetIslandSize(config, (size_t)num_ranks, (size_t)island_rank);
+  }
+
+  /// Does src send migrants to dst this migration?
+  bool Sends(int src, int dst) const {
+    if (src == dst) return false;
+    switch (topology) {
+      case TOPOLOGY::RING: return dst == (src + 1) % num_ranks;
+      case TOPOLOGY::FULL: return true;
+      case TOPOLOGY::RANDOM: return destinations[(size_t)src] == (size_t)dst;
+    }
+    return false;
+  }
+
+  /// Largest message src can send (its emigrants are capped at MAX_SIZE bits each).
+  size_t GetMaxMessageWords(int src) const {
+    const size_t count = AagosIslandModel::GetEmigrantCount(config, GetIslandSize(src));
+    return count * snapshot::RecordWords(config.NUM_GENES(), config.MAX_SIZE());
+  }
+
+  /// Pack random organisms into per-destination messages and start sending them; post receives for
+  /// the messages coming in.
+  void StartMigration() {
+    const size_t num_islands = (size_t)num_ranks;
+    if (topology == TOPOLOGY::RANDOM) AagosIslandModel::DrawRandomDestinations(*migration_random, destinations);
+    // Outgoing.
+    emp::Random & random = island->GetRandom();
+    const size_t island_size = island->GetSize();
+    const size_t count = AagosIslandModel::GetEmigrantCount(config, island_size);
+    const size_t offset = random.GetUInt(num_islands - 1);
+    for (auto & buffer : send_buffers) buffer.clear();
+    for (size_t k = 0; k < count; ++k) {
+      const size_t dst = AagosIslandModel::GetDestination(topology, num_islands, (size_t)rank, k, offset,
+                                                          destinations[(size_t)rank]);
+      const genome_t & genome = island->GetOrg(random.GetUInt(island_size)).GetGenome();
+      if (genome.GetNumBits() > config.MAX_SIZE()) continue; // Wouldn't fit the receiver's buffer.
+      snapshot::PackRecord(genome, config.NUM_GENES(), send_buffers[dst]);
+    }
+    for (int dst = 0; dst < num_ranks; ++dst) {
+      if (!Sends(rank, dst)) continue;
+      auto & buffer = send_buffers[(size_t)dst];
+      send_requests.emplace_back();
+      MPI_Isend(buffer.data(), (int)buffer.size(), MPI_UINT64_T, dst, MIGRANT_TAG, MPI_COMM_WORLD, &send_requests.back());
+    }
+    // Incoming.
+    for (int src = 0; src < num_ranks; ++src) {
+      if (!Sends(src, rank)) continue;
+      auto & buffer = recv_buffers[(size_t)src];
+      buffer.resize(std::max<size_t>(1, GetMaxMessageWords(src)));
+      recv_sources.emplace_back(src);
+      recv_requests.emplace_back();
+      MPI_Irecv(buffer.data(), (int)buffer.size(), MPI_UINT64_T, src, MIGRANT_TAG, MPI_COMM_WORLD, &recv_requests.back());
+    }
+  }
+
+  /// Wait for the outstanding migration's messages and unpack the migrants into arrivals.
+  void FinishMigration() {
+    if (recv_requests.size()) {
+      emp::vector<MPI_Status> statuses(recv_requests.size());
+      MPI_Waitall((int)recv_requests.size(), recv_requests.data(), statuses.data());
+      for (size_t i = 0; i < recv_sources.size(); ++i) {
+        int num_words = 0;
+        MPI_Get_count(&statuses[i], MPI_UINT64_T, &num_words);
+        const auto & buffer = recv_buffers[(size_t)recv_sources[i]];
+        size_t pos = 0;
+        while (pos < (size_t)num_words) {
+          if (!snapshot::UnpackRecord(buffer.data(), (size_t)num_words, pos, config.NUM_GENES(), config.GENE_SIZE(), arrivals)) {
+            std::cout << "Rank " << rank << ": Malformed migrants from rank " << recv_sources[i] << "; dropping the rest." << std::endl;
+            break;
+          }
+        }
+      }
+      recv_requests.clear();
+      recv_sources.clear();
+    }
+    // Send buffers are reused by the next migration.
+    if (send_requests.size()) {
+      MPI_Waitall((int)send_requests.size(), send_requests.data(), MPI_STATUSES_IGNORE);
+      send_requests.clear();
+    }
+  }
+
+  /// Replace random residents with waiting immigrants.
+  void Immigrate() {
+    emp::Random & random = island->GetRandom();
+    for (const genome_t & genome : arrivals) island->InjectAt(genome, emp::WorldPosition(random.GetUInt(island->GetSize())));
+    immigrants += arrivals.size();
+    arrivals.clear();
+  }
+
+  /// Gather every island's statistics on rank 0 and write a row of island_stats.csv.
+  void UpdateStats() {
+    double total_fitness = 0.0;
+    double max_fitness = 0.0;
+    double total_length = 0.0;
+    for (size_t org_id = 0; org_id < island->GetSize(); ++org_id) {
+      const double fitness = island->GetOrg(org_id).GetPhenotype().fitness;
+      total_fitness += fitness;
+      max_fitness = std::max(max_fitness, fitness);
+      total_length += (double)island->GetOrg(org_id).GetNumBits();
+    }
+    const double size = (double)island->GetSize();
+    local_stats[MEAN_FITNESS] = size ? total_fitness / size : 0.0;
+    local_stats[MAX_FITNESS] = max_fitness;
+    local_stats[TOTAL_FITNESS] = total_fitness;
+    local_stats[TOTAL_LENGTH] = total_length;
+    local_stats[SIZE] = size;
+    local_stats[IMMIGRANTS] = (double)immigrants;
+    MPI_Gather(local_stats.data(), NUM_STATS, MPI_DOUBLE, gathered_stats.data(), NUM_STATS, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) stats_file->Update();
+  }
+
+  double GetGathered(size_t island_rank, STAT stat) const { return gathered_stats[island_rank * NUM_STATS + stat]; }
+
+  double SumGathered(STAT stat) const {
+    double total = 0.0;
+    for (size_t r = 0; r < (size_t)num_ranks; ++r) total += GetGathered(r, stat);
+    return total;
+  }
+
+  /// Same columns as the threaded island model's island_stats.csv.
+  void SetupStatsFile() {
+    stats_file = emp::NewPtr<emp::DataFile>(output_path + "island_stats.csv");
+    stats_file->AddFun<size_t>([this]() { return island->GetUpdate(); }, "update", "current generation");
+    stats_file->AddFun<size_t>([this]() { return island->GetPhase(); }, "evo_phase", "Current phase of evolution");
+    stats_file->AddFun<double>([this]() {
+      const double size = SumGathered(SIZE);
+      return size ? SumGathered(TOTAL_FITNESS) / size : 0.0;
+    }, "mean_fitness", "Mean fitness over all islands");
+    stats_file->AddFun<double>([this]() {
+      double max_fitness = 0.0;
+      for (size_t r = 0; r < (size_t)num_ranks; ++r) max_fitness = std::max(max_fitness, GetGathered(r, MAX_FITNESS));
+      return max_fitness;
+    }, "max_fitness", "Max fitness over all islands");
+    stats_file->AddFun<double>([this]() {
+      const double size = SumGathered(SIZE);
+      return size ? SumGathered(TOTAL_LENGTH) / size : 0.0;
+    }, "mean_genome_length", "Mean genome length over all islands");
+    for (size_t r = 0; r < (size_t)num_ranks; ++r) {
+      const std::string prefix = "island_" + emp::to_string(r) + "_";
+      stats_file->AddFun<double>([this, r]() { return GetGathered(r, MEAN_FITNESS); },
+                                 prefix + "mean_fitness", "Mean fitness on island");
+      stats_file->AddFun<double>([this, r]() { return GetGathered(r, MAX_FITNESS); },
+                                 prefix + "max_fitness", "Max fitness on island");
+      stats_file->AddFun<size_t>([this, r]() { return (size_t)GetGathered(r, IMMIGRANTS); },
+                                 prefix + "immigrants", "Total organisms received from other islands");
+    }
+    stats_file->PrintHeaderKeys();
+  }
+
+  /// Run a single generation, overlapping the previous migration's messages with evaluation.
+  void Step() {
+    island->RunStep(false);
+    FinishMigration();
+    const size_t u = island->GetUpdate();
+    const size_t summary_interval = config.SUMMARY_INTERVAL();
+    if (summary_interval && !(u % summary_interval)) UpdateStats();
+
+    const bool migrate = config.MIGRATION_INTERVAL() && u && !(u % config.MIGRATION_INTERVAL());
+    island->AdvanceWorld();
+    Immigrate();
+    if (migrate) StartMigration();
+  }
+
+public:
+  AagosMPIIsland(AagosConfig & cfg, int _rank, int _num_ranks)
+    : config(cfg), rank(_rank), num_ranks(_num_ranks) { ; }
+
+  AagosMPIIsland(const AagosMPIIsland &) = delete;
+  AagosMPIIsland & operator=(const AagosMPIIsland &) = delete;
+
+  ~AagosMPIIsland() {
+    if (island != nullptr) island.Delete();
+    if (migration_random != nullptr) migration_random.Delete();
+    if (stats_file != nullptr) stats_file.Delete();
+  }
+
+  /// Set up this rank's island. Returns false (on every rank) if the configuration is unusable.
+  bool Setup() {
+    if (num_ranks < 2) {
+      if (rank == 0) std::cout << "The MPI island model requires at least 2 ranks (e.g., mpirun -np 4 ./AagosMPI)." << std::endl;
+      return false;
+    }
+    if (config.POP_SIZE() < (size_t)num_ranks) {
+      if (rank == 0) std::cout << "POP_SIZE (" << config.POP_SIZE() << ") must be at least the number of ranks (" << num_ranks << ")." << std::endl;
+      return false;
+    }
+    if (!AagosIslandModel::ParseTopology(config.MIGRATION_TOPOLOGY(), topology)) {
+      if (rank == 0) std::cout << "Unknown MIGRATION_TOPOLOGY (" << config.MIGRATION_TOPOLOGY() << "); expected ring, full, or random." << std::endl;
+      return false;
+    }
+    if (rank == 0 && config.NUM_ISLANDS() != 1 && config.NUM_ISLANDS() != (size_t)num_ranks) {
+      std::cout << "Note: NUM_ISLANDS is ignored; running one island per rank (" << num_ranks << ")." << std::endl;
+    }
+    output_path = config.DATA_FILEPATH();
+    if (output_path.back() != '/') output_path += '/';
+    mkdir(output_path.c_str(), ACCESSPERMS);
+
+    // Every island shares the base seed's environment (so every rank needs the same base seed).
+    int base_seed = (rank == 0) ? AagosIslandModel::ResolveBaseSeed(config) : 0;
+    MPI_Bcast(&base_seed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    AagosIslandModel::ConfigureIsland(config, island_config, (size_t)num_ranks, (size_t)rank, base_seed, output_path);
+    island = emp::NewPtr<AagosIsland>(island_config);
+    island->SetEnvironmentSeed(base_seed);
+    island->Setup();
+
+    migration_random = emp::NewPtr<emp::Random>(base_seed);
+    destinations.assign((size_t)num_ranks, 0);
+    send_buffers.resize((size_t)num_ranks);
+    recv_buffers.resize((size_t)num_ranks);
+    local_stats.assign(NUM_STATS, 0.0);
+    if (rank == 0) {
+      gathered_stats.assign((size_t)num_ranks * NUM_STATS, 0.0);
+      SetupStatsFile();
+      std::cout << "Running " << num_ranks << " islands (one per rank)." << std::endl;
+    }
+    return true;
+  }
+
+  /// Run for the configured number of generations (as AagosWorld::Run does).
+  void Run() {
+    for (size_t gen = 0; gen <= config.MAX_GENS(); ++gen) Step();
+    if (config.PHASE_2_ACTIVE()) {
+      island->ActivateEvoPhaseTwo();
+      for (size_t gen = 0; gen <= config.PHASE_2_MAX_GENS(); ++gen) Step();
+    }
+    FinishMigration(); // Complete any migration still in flight (its migrants are dropped).
+  }
+};
+
+}
+
+int main(int argc, char* argv[])
+{
+  MPI_Init(&argc, &argv);
+  int rank = 0;
+  int num_ranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+  std::string config_fname = "Aagos.cfg";
+  aagos::AagosConfig config;
+  // Every rank loads the same configuration (config file and command line args).
+  config.Read(config_fname);
+  auto args = emp::cl::ArgManager(argc, argv);
+  if (args.ProcessConfigOptions(config, std::cout, "Aagos.cfg", "Aagos-macros.h") == false
+      || args.TestUnknown() == false) {
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (rank == 0) {
+    std::cout << "==============================" << std::endl;
+    std::cout << "|    How am I configured?    |" << std::endl;
+    std::cout << "==============================" << std::endl;
+    config.Write(std::cout);
+    std::cout << "==============================\n" << std::endl;
+  }
+
+  int status = 0;
+  {
+    aagos::AagosMPIIsland island(config, rank, num_ranks);
+    if (island.Setup()) island.Run();
+    else status = -1;
+  }
+  MPI_Finalize();
+  return status;
+}
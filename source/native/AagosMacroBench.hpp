@@ -0,0 +1,177 @@
+#ifndef AAGOS_MACRO_BENCH_HPP
+#define AAGOS_MACRO_BENCH_HPP
+
+#include "emp/base/vector.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosWorld.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace aagos {
+
+/// End-to-end throughput benchmarks. Each canonical configuration is run start-to-finish in its own
+/// child process (so peak RSS is attributable to a single configuration) with outputs directed to tmpfs.
+namespace macro_bench {
+
+using config_fun_t = std::function<void(AagosConfig &)>;
+
+/// Settings used by the web visualization (source/web/Aagos-web.cc).
+inline void ConfigureWeb(AagosConfig & cfg) {
+  cfg.POP_SIZE(500);
+  cfg.SEED(1);
+  cfg.TOURNAMENT_SIZE(8);
+  cfg.GRADIENT_MODEL(true);
+  cfg.CHANGE_MAGNITUDE(1);
+  cfg.CHANGE_FREQUENCY(4);
+  cfg.NUM_BITS(32);
+  cfg.NUM_GENES(8);
+  cfg.GENE_SIZE(8);
+  cfg.MIN_SIZE(8);
+  cfg.MAX_SIZE(512);
+  cfg.GENE_MOVE_PROB(0.001);
+  cfg.BIT_FLIP_PROB(0.001);
+  cfg.BIT_INS_PROB(0.002);
+  cfg.BIT_DEL_PROB(0.002);
+}
+
+/// 16-gene, 128-bit pivot settings from notes/2020-05-18--redesign.md.
+inline void ConfigureRedesign(AagosConfig & cfg, bool gradient) {
+  cfg.POP_SIZE(1000);
+  cfg.SEED(1);
+  cfg.TOURNAMENT_SIZE(8);
+  cfg.GRADIENT_MODEL(gradient);
+  cfg.CHANGE_MAGNITUDE(1);
+  cfg.CHANGE_FREQUENCY(4);
+  cfg.NUM_BITS(128);
+  cfg.NUM_GENES(16);
+  cfg.GENE_SIZE(8);
+  cfg.MIN_SIZE(8);
+  cfg.MAX_SIZE(1024);
+  cfg.GENE_MOVE_PROB(0.003);
+  cfg.BIT_FLIP_PROB(0.003);
+  cfg.BIT_INS_PROB(0.001);
+  cfg.BIT_DEL_PROB(0.001);
+}
+
+inline emp::vector<std::pair<std::string, config_fun_t>> GetCanonicalConfigs() {
+  return {
+    {"web", [](AagosConfig & cfg) { ConfigureWeb(cfg); }},
+    {"nk-16", [](AagosConfig & cfg) { ConfigureRedesign(cfg, false); }},
+    {"gradient-16", [](AagosConfig & cfg) { ConfigureRedesign(cfg, true); }}
+  };
+}
+
+/// Peak resident set size of this process (in MB).
+inline double GetPeakRSSMB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (double)usage.ru_maxrss / 1024.0; // ru_maxrss is in KB on Linux.
+}
+
+/// Run a single benchmark configuration in this process and append the result to results_path.
+inline void RunOne(const std::string & name, const config_fun_t & configure, size_t gens,
+                   const std::string & results_path)
+{
+  using clock_t = std::chrono::steady_clock;
+  // Prefer tmpfs for outputs so disk doesn't dominate measurements.
+  struct stat shm_info;
+  const std::string out_root = (stat("/dev/shm", &shm_info) == 0) ? "/dev/shm/aagos-bench/" : "./bench_output/";
+  mkdir(out_root.c_str(), ACCESSPERMS);
+
+  AagosConfig config;
+  configure(config);
+  config.MAX_GENS(gens);
+  config.PHASE_2_ACTIVE(false);
+  config.PRINT_INTERVAL(gens);
+  config.SUMMARY_INTERVAL(gens);
+  config.SNAPSHOT_INTERVAL(gens);
+  config.DATA_FILEPATH(out_root + name + "/");
+
+  const auto setup_start = clock_t::now();
+  AagosWorld world(config);
+  world.Setup();
+  const auto run_start = clock_t::now();
+  world.Run();
+  const auto run_end = clock_t::now();
+
+  const double setup_sec = std::chrono::duration<double>(run_start - setup_start).count();
+  const double run_sec = std::chrono::duration<double>(run_end - run_start).count();
+  const double gens_run = (double)(gens + 1); // Run covers generations [0, MAX_GENS].
+  const double gens_per_sec = gens_run / run_sec;
+  const double orgs_per_sec = gens_run * (double)config.POP_SIZE() / run_sec;
+  const double peak_rss_mb = GetPeakRSSMB();
+
+  std::cout << "BENCH " << name
+            << ": generations/sec=" << gens_per_sec
+            << "; organisms evaluated/sec=" << orgs_per_sec
+            << "; peak RSS (MB)=" << peak_rss_mb
+            << "; setup (s)=" << setup_sec
+            << "; run (s)=" << run_sec << std::endl;
+
+  std::ofstream results(results_path, std::ios::app);
+  results << name << "," << config.POP_SIZE() << "," << (gens + 1) << ","
+          << setup_sec << "," << run_sec << "," << gens_per_sec << ","
+          << orgs_per_sec << "," << peak_rss_mb << "\n";
+}
+
+/// Run the named canonical configuration ("all" runs every configuration). Returns false if
+/// the name is unknown, gens is zero, or a configuration fails.
+inline bool Run(const std::string & which, size_t gens, const std::string & results_path) {
+  // Output intervals are set to gens, so it must be positive.
+  if (gens == 0) {
+    std::cout << "Macro benchmarks need at least one generation (--bench-gens)." << std::endl;
+    return false;
+  }
+  bool found = false;
+  bool success = true;
+  {
+    std::ofstream results(results_path);
+    results << "config,pop_size,generations,setup_sec,run_sec,generations_per_sec,organisms_per_sec,peak_rss_mb\n";
+  }
+  for (const auto & entry : GetCanonicalConfigs()) {
+    if (which != "all" && which != entry.first) continue;
+    found = true;
+    std::cout << "==> Macro benchmark: " << entry.first << " (" << gens << " generations) <==" << std::endl;
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+      RunOne(entry.first, entry.second, gens, results_path);
+      std::cout.flush();
+      _exit(0);
+    } else if (pid < 0) {
+      std::cout << "Failed to fork benchmark process for " << entry.first << "." << std::endl;
+      success = false;
+      continue;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cout << "Benchmark " << entry.first << " failed." << std::endl;
+      success = false;
+    }
+  }
+  if (!found) {
+    std::cout << "Unknown benchmark configuration (" << which << "). Options: all";
+    for (const auto & entry : GetCanonicalConfigs()) std::cout << ", " << entry.first;
+    std::cout << std::endl;
+    return false;
+  }
+  std::cout << "Benchmark results written to " << results_path << std::endl;
+  return success;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef AAGOS_SWEEP_HPP
+#define AAGOS_SWEEP_HPP
+
+#include "emp/base/vector.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosWorld.hpp"
+#include "../AagosIslands.hpp"
+#include "AagosBranches.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace aagos {
+
+/// Parameter sweeps run from a directory-based job queue. Any number of coordinators (on one or
+/// more machines sharing the directory) fork worker processes that claim jobs one at a time; every
+/// job runs in its own process.
+///
+/// Sweep directory layout:
+///   - jobs/<job>.job: settings for the job (one "NAME value" per line; see CreateJobs)
+///   - locks/<job>.lock: job claimed by a worker (created atomically with O_EXCL; holds the worker's
+///     host, pid, boot id, and process start time; its mtime is a heartbeat refreshed while the job runs)
+///   - done/<job>.done: job finished
+///   - failed/<job>.failed: job exited with an error (delete the marker to retry it)
+///   - runs/<job>/: job output (DATA_FILEPATH) and console log (log.txt)
+///
+/// Finished and failed jobs are skipped. A job whose worker died (e.g., the machine crashed) leaves
+/// a stale lock, which is reclaimed when a coordinator starts, and the job is rerun from the start (a
+/// world can't be restored mid-run, so its partial output is cleared). Locks from this host are stale
+/// once the machine has rebooted or the worker process is gone; locks from any host are stale once
+/// their heartbeat is older than STALE_LOCK_SECONDS. A worker that finds its lock reclaimed stops its
+/// job and leaves it to the new owner.
+class AagosSweep {
+public:
+  static constexpr int HEARTBEAT_SECONDS = 30;
+  static constexpr int STALE_LOCK_SECONDS = 600;
+
+protected:
+  /// Returned by RunJob if the job's lock was reclaimed while it ran.
+  static constexpr int LOST_LOCK = -2;
+
+  std::string dir;
+  std::string host;
+  std::string boot_id;    ///< Changes when the machine reboots ("-" if unknown).
+
+  std::string JobPath(const std::string & job) const { return dir + "jobs/" + job + ".job"; }
+  std::string LockPath(const std::string & job) const { return dir + "locks/" + job + ".lock"; }
+  std::string DonePath(const std::string & job) const { return dir + "done/" + job + ".done"; }
+  std::string FailedPath(const std::string & job) const { return dir + "failed/" + job + ".failed"; }
+  std::string RunPath(const std::string & job) const { return dir + "runs/" + job + "/"; }
+
+  static bool Exists(const std::string & path) { return std::filesystem::exists(path); }
+
+  /// Start time of process pid (in clock ticks since boot; "-" if unknown). Together with the boot
+  /// id, this tells a live worker apart from an unrelated process that reused its pid.
+  static std::string GetStartTime(long pid) {
+    std::ifstream stat_file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat;
+    std::getline(stat_file, stat);
+    // Fields after the command name (which may contain spaces): state is field 3, starttime field 22.
+    const size_t comm_end = stat.rfind(')');
+    if (comm_end == std::string::npos) return "-";
+    std::istringstream fields(stat.substr(comm_end + 1));
+    std::string field;
+    for (size_t i = 3; i <= 22; ++i) {
+      if (!(fields >> field)) return "-";
+    }
+    return field;
+  }
+
+  /// Contents of a lock held by this process.
+  std::string GetLockOwner() const {
+    const long pid = (long)getpid();
+    return host + " " + std::to_string(pid) + " " + boot_id + " " + GetStartTime(pid) + "\n";
+  }
+
+  /// Refresh the heartbeat (mtime) of job's lock. Returns false if this process no longer holds it.
+  bool Heartbeat(const std::string & job) const {
+    std::ifstream lock_file(LockPath(job));
+    const std::string contents((std::istreambuf_iterator<char>(lock_file)), std::istreambuf_iterator<char>());
+    if (contents != GetLockOwner()) return false;
+    return utimensat(AT_FDCWD, LockPath(job).c_str(), nullptr, 0) == 0;
+  }
+
+  /// Is the lock at path stale? If so, sets reason.
+  bool IsStaleLock(const std::filesystem::path & path, std::string & reason) const {
+    std::ifstream lock_file(path);
+    std::string lock_host, lock_boot_id, lock_start_time;
+    long pid = 0;
+    lock_file >> lock_host >> pid >> lock_boot_id >> lock_start_time;
+    if (lock_host == host && pid > 0) {
+      if (lock_boot_id.size() && lock_boot_id != "-" && lock_boot_id != boot_id) {
+        reason = "host rebooted since worker " + std::to_string(pid) + " claimed it";
+        return true;
+      }
+      if (kill((pid_t)pid, 0) != 0 && errno == ESRCH) {
+        reason = "worker " + std::to_string(pid) + " is gone";
+        return true;
+      }
+      if (lock_start_time.size() && lock_start_time != "-" && lock_start_time != GetStartTime(pid)) {
+        reason = "worker " + std::to_string(pid) + " is gone; its pid was reused";
+        return true;
+      }
+      return false; // Still running.
+    }
+    // Another host's lock (or one that hasn't been written yet): go by its heartbeat.
+    std::error_code error;
+    const auto mtime = std::filesystem::last_write_time(path, error);
+    if (error) return false;
+    const auto age = std::chrono::duration_cast<std::chrono::seconds>(std::filesystem::file_time_type::clock::now() - mtime);
+    if (age.count() <= STALE_LOCK_SECONDS) return false;
+    reason = "no heartbeat from " + (lock_host.size() ? lock_host : std::string("its worker")) + " for "
+             + std::to_string(age.count()) + " s";
+    return true;
+  }
+
+  /// Write a marker file atomically (write a temporary file, then rename it into place).
+  bool WriteMarker(const std::string & path, const std::string & contents) const {
+    const std::string tmp_path = path + ".tmp." + host + "." + std::to_string(getpid());
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      if (!out.is_open()) return false;
+      out << contents;
+      out.close();
+      if (!out) return false;
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+  }
+
+  /// Job names, in order.
+  emp::vector<std::string> GetJobs() const {
+    emp::vector<std::string> jobs;
+    std::error_code error;
+    for (const auto & entry : std::filesystem::directory_iterator(dir + "jobs", error)) {
+      if (entry.path().extension() == ".job") jobs.emplace_back(entry.path().stem().string());
+    }
+    std::sort(jobs.begin(), jobs.end());
+    return jobs;
+  }
+
+  /// Claim the next unfinished, unclaimed job. Returns false if there are none left.
+  bool ClaimNext(std::string & claimed) const {
+    for (const std::string & job : GetJobs()) {
+      if (Exists(DonePath(job)) || Exists(FailedPath(job))) continue;
+      const int fd = open(LockPath(job).c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+      if (fd < 0) continue; // Claimed by someone else.
+      const std::string owner = GetLockOwner();
+      const ssize_t written = write(fd, owner.data(), owner.size());
+      close(fd);
+      // The job may have finished (and its lock been released) since we checked.
+      if (written != (ssize_t)owner.size() || Exists(DonePath(job)) || Exists(FailedPath(job))) {
+        std::remove(LockPath(job).c_str());
+        continue;
+      }
+      claimed = job;
+      return true;
+    }
+    return false;
+  }
+
+  /// Run job in a child process, keeping its lock's heartbeat up; returns its exit status (0 on
+  /// success), or LOST_LOCK if the lock was reclaimed (the child is then killed).
+  int RunJob(AagosConfig & base_config, const std::string & job) const {
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid > 0) {
+      int status = 0;
+      auto last_heartbeat = std::chrono::steady_clock::now();
+      while (true) {
+        const pid_t exited = waitpid(pid, &status, WNOHANG);
+        if (exited < 0) return -1;
+        if (exited == pid) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_heartbeat < std::chrono::seconds(HEARTBEAT_SECONDS)) continue;
+        last_heartbeat = now;
+        if (!Heartbeat(job)) {
+          kill(pid, SIGKILL);
+          waitpid(pid, &status, 0);
+          return LOST_LOCK;
+        }
+      }
+      if (WIFEXITED(status)) return WEXITSTATUS(status);
+      return 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    }
+    // Child: start from a clean output directory, log to it, and run the job.
+    const std::string out_path = RunPath(job);
+    std::error_code error;
+    std::filesystem::remove_all(out_path, error);
+    std::filesystem::create_directories(out_path, error);
+    const int log_fd = open((out_path + "log.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd >= 0) {
+      dup2(log_fd, STDOUT_FILENO);
+      dup2(log_fd, STDERR_FILENO);
+      close(log_fd);
+    }
+    {
+      AagosConfig config;
+      std::stringstream config_stream;
+      base_config.Write(config_stream);
+      config.Read(config_stream);
+      std::ifstream job_file(JobPath(job));
+      std::string line;
+      while (std::getline(job_file, line)) {
+        std::istringstream line_stream(line);
+        std::string name, value;
+        if (!(line_stream >> name) || name[0] == '#') continue;
+        std::getline(line_stream >> std::ws, value);
+        if (!config.Has(name)) {
+          std::cout << JobPath(job) << ": Unknown setting (" << name << ")." << std::endl;
+          _exit(2);
+        }
+        config.Set(name, value);
+      }
+      config.DATA_FILEPATH(out_path);
+      std::cout << "==============================" << std::endl;
+      std::cout << "|    How am I configured?    |" << std::endl;
+      std::cout << "==============================" << std::endl;
+      config.Write(std::cout);
+      std::cout << "==============================\n" << std::endl;
+      if (config.NUM_ISLANDS() > 1) {
+        AagosIslandModel islands(config);
+        islands.Setup();
+        islands.Run();
+      } else {
+        AagosWorld world(config);
+        world.Setup();
+        if (!RunWorld(world, config)) {
+          std::cout.flush();
+          _exit(1);
+        }
+      }
+    }
+    std::cout.flush();
+    _exit(0);
+  }
+
+  /// Claim and run jobs until none are left.
+  void WorkerLoop(AagosConfig & base_config, size_t worker_id) const {
+    std::string job;
+    while (ClaimNext(job)) {
+      std::cout << "[worker " << worker_id << "] Running " << job << std::endl;
+      const int status = RunJob(base_config, job);
+      if (status == LOST_LOCK) {
+        // Another coordinator reclaimed the job (and reruns it); its lock isn't ours to release.
+        std::cout << "[worker " << worker_id << "] Stopped " << job << " (its lock was reclaimed)." << std::endl;
+        continue;
+      }
+      if (status == 0) {
+        WriteMarker(DonePath(job), host + " " + std::to_string(getpid()) + "\n");
+        std::cout << "[worker " << worker_id << "] Finished " << job << std::endl;
+      } else {
+        WriteMarker(FailedPath(job), "exit status " + std::to_string(status) + "\n");
+        std::cout << "[worker " << worker_id << "] " << job << " failed (exit status " << status
+                  << "; see " << RunPath(job) << "log.txt)." << std::endl;
+      }
+      std::remove(LockPath(job).c_str());
+    }
+  }
+
+public:
+  AagosSweep(const std::string & sweep_dir) : dir(sweep_dir) {
+    if (dir.empty() || dir.back() != '/') dir += '/';
+    char name[256] = {0};
+    gethostname(name, sizeof(name) - 1);
+    host = name;
+    if (host.empty()) host = "localhost";
+    std::ifstream boot_id_file("/proc/sys/kernel/random/boot_id");
+    if (!(boot_id_file >> boot_id)) boot_id = "-";
+  }
+
+  /// Create the sweep's jobs from a sweep specification file. Each line of the specification is a
+  /// setting followed by the values to sweep over (e.g., "CHANGE_MAGNITUDE 0 1 2 4"), or
+  /// "REPLICATES n"; blank lines and lines starting with # are ignored. One job is created for every
+  /// combination of values and replicate, each with its own SEED (1, 2, ...) unless SEED is swept.
+  bool CreateJobs(const std::string & spec_path, AagosConfig & config) const {
+    std::ifstream spec(spec_path);
+    if (!spec.is_open()) {
+      std::cout << "Unable to open sweep specification (" << spec_path << ")." << std::endl;
+      return false;
+    }
+    if (GetJobs().size()) {
+      std::cout << "Sweep directory (" << dir << ") already has jobs." << std::endl;
+      return false;
+    }
+    size_t replicates = 1;
+    emp::vector<std::pair<std::string, emp::vector<std::string>>> params;
+    std::string line;
+    while (std::getline(spec, line)) {
+      std::istringstream line_stream(line);
+      std::string name, value;
+      if (!(line_stream >> name) || name[0] == '#') continue;
+      emp::vector<std::string> values;
+      while (line_stream >> value) values.emplace_back(value);
+      if (name == "REPLICATES") {
+        if (values.size() != 1 || !(replicates = std::strtoul(values[0].c_str(), nullptr, 10))) {
+          std::cout << spec_path << ": REPLICATES needs a single positive count." << std::endl;
+          return false;
+        }
+        continue;
+      }
+      if (!config.Has(name) || values.empty()) {
+        std::cout << spec_path << ": Expected a setting and its values (" << line << ")." << std::endl;
+        return false;
+      }
+      params.emplace_back(name, values);
+    }
+    const bool swept_seed = std::any_of(params.begin(), params.end(), [](const auto & p) { return p.first == "SEED"; });
+    for (const char * sub_dir : {"jobs", "locks", "done", "failed", "runs"}) {
+      std::error_code error;
+      std::filesystem::create_directories(dir + sub_dir, error);
+    }
+    // Every combination of values (earlier settings vary slowest), then replicates.
+    size_t num_jobs = replicates;
+    for (const auto & param : params) num_jobs *= param.second.size();
+    for (size_t job_id = 0; job_id < num_jobs; ++job_id) {
+      std::ostringstream name;
+      name << "job_" << std::setw(6) << std::setfill('0') << job_id;
+      std::ofstream job_file(JobPath(name.str()), std::ios::trunc);
+      size_t remainder = job_id / replicates;
+      emp::vector<std::string> settings(params.size());
+      for (size_t p = params.size(); p-- > 0; ) {
+        const auto & values = params[p].second;
+        settings[p] = params[p].first + " " + values[remainder % values.size()];
+        remainder /= values.size();
+      }
+      for (const std::string & setting : settings) job_file << setting << "\n";
+      if (!swept_seed) job_file << "SEED " << (job_id + 1) << "\n";
+      if (!job_file) {
+        std::cout << "Unable to write " << JobPath(name.str()) << "." << std::endl;
+        return false;
+      }
+    }
+    std::cout << "Created " << num_jobs << " jobs in " << dir << "jobs/." << std::endl;
+    return true;
+  }
+
+  /// Release stale locks (see above). Returns the number of locks released.
+  size_t ReclaimStaleLocks() const {
+    size_t released = 0;
+    std::error_code error;
+    for (const auto & entry : std::filesystem::directory_iterator(dir + "locks", error)) {
+      if (entry.path().extension() != ".lock") continue;
+      std::string reason;
+      if (!IsStaleLock(entry.path(), reason)) continue;
+      std::remove(entry.path().c_str());
+      std::cout << "Reclaimed " << entry.path().stem().string() << " (" << reason << ")." << std::endl;
+      ++released;
+    }
+    return released;
+  }
+
+  void PrintStatus(std::ostream & os) const {
+    size_t done = 0, failed = 0, running = 0;
+    const emp::vector<std::string> jobs = GetJobs();
+    for (const std::string & job : jobs) {
+      if (Exists(DonePath(job))) ++done;
+      else if (Exists(FailedPath(job))) ++failed;
+      else if (Exists(LockPath(job))) ++running;
+    }
+    os << "Sweep " << dir << ": " << jobs.size() << " jobs; " << done << " done, " << failed << " failed, "
+       << running << " running, " << (jobs.size() - done - failed - running) << " pending." << std::endl;
+  }
+
+  /// Run the sweep's jobs with num_workers worker processes (0 => one per hardware thread),
+  /// returning once there's nothing left to claim. Returns false if any job failed.
+  bool Run(AagosConfig & base_config, size_t num_workers) const {
+    if (GetJobs().empty()) {
+      std::cout << "No jobs in " << dir << "jobs/ (create them with --sweep-init)." << std::endl;
+      return false;
+    }
+    ReclaimStaleLocks();
+    PrintStatus(std::cout);
+    if (!num_workers) num_workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    emp::vector<pid_t> workers;
+    for (size_t worker_id = 0; worker_id < num_workers; ++worker_id) {
+      std::cout.flush();
+      const pid_t pid = fork();
+      if (pid < 0) {
+        std::cout << "Unable to start worker " << worker_id << "." << std::endl;
+        break;
+      }
+      if (pid == 0) {
+        WorkerLoop(base_config, worker_id);
+        std::cout.flush();
+        _exit(0);
+      }
+      workers.emplace_back(pid);
+    }
+    for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+    PrintStatus(std::cout);
+    const emp::vector<std::string> jobs = GetJobs();
+    return std::none_of(jobs.begin(), jobs.end(), [this](const std::string & job) { return Exists(FailedPath(job)); });
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,1029 @@
+// Behavioral tests for Aagos: file formats and parsers, population structures, tools, and runs that
+// should be equivalent to one another. Each Test* function below covers one feature.
+//
+// Usage: ./AagosTests [scratch directory] [AagosCrossEval binary]
+//
+// The cross-evaluation test runs the AagosCrossEval binary (./AagosCrossEval by default; make test
+// builds it).
+//
+// Prints each failed check; exits with status 1 if any failed.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/bits/Bits.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosEnvBank.hpp"
+#include "../AagosEnvLog.hpp"
+#include "../AagosEvaluators.hpp"
+#include "../AagosGrid.hpp"
+#include "../AagosIslands.hpp"
+#include "../AagosOrg.hpp"
+#include "../AagosParsing.hpp"
+#include "../AagosSnapshot.hpp"
+#include "../AagosThreadPool.hpp"
+#include "../AagosWorld.hpp"
+#include "../GradientFitnessModel.hpp"
+#include "../NKFitnessModel.hpp"
+#include "AagosSweep.hpp"
+
+namespace {
+
+using genome_t = aagos::AagosOrg::Genome;
+
+/// Exposes AagosWorld internals that the tests check directly.
+class TestWorld : public aagos::AagosWorld {
+public:
+  using aagos::AagosWorld::AagosWorld;
+
+  void Snapshot() { DoPopulationSnapshot(); }
+};
+
+/// Exposes AagosSweep's job claiming and lock handling.
+class SweepHarness : public aagos::AagosSweep {
+public:
+  using aagos::AagosSweep::AagosSweep;
+  using aagos::AagosSweep::ClaimNext;
+  using aagos::AagosSweep::GetLockOwner;
+  using aagos::AagosSweep::Heartbeat;
+  using aagos::AagosSweep::IsStaleLock;
+  using aagos::AagosSweep::LockPath;
+
+  const std::string & GetHost() const { return host; }
+  const std::string & GetBootId() const { return boot_id; }
+};
+
+std::string scratch_dir = "./aagos_tests/";
+std::string cross_eval_path = "./AagosCrossEval";
+size_t num_checks = 0;
+size_t num_failures = 0;
+
+void Check(bool condition, const std::string & what) {
+  ++num_checks;
+  if (condition) return;
+  ++num_failures;
+  std::cout << "  FAILED: " << what << std::endl;
+}
+
+/// Fresh scratch directory for a test (ends with '/').
+std::string MakeDir(const std::string & name) {
+  const std::string dir = scratch_dir + name + "/";
+  std::error_code error;
+  std::filesystem::remove_all(dir, error);
+  std::filesystem::create_directories(dir, error);
+  return dir;
+}
+
+std::string ReadFile(const std::string & path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string & path, const std::string & contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+}
+
+/// Values in the named column of a csv file written by emp::DataFile (one per row after the header).
+emp::vector<std::string> ReadColumn(const std::string & path, const std::string & column) {
+  std::istringstream lines(ReadFile(path));
+  std::string line;
+  emp::vector<std::string> values;
+  size_t column_id = (size_t)-1;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string field;
+    for (size_t field_id = 0; std::getline(fields, field, ','); ++field_id) {
+      if (column_id == (size_t)-1 && field == column) column_id = field_id;
+      else if (field_id == column_id) values.emplace_back(field);
+    }
+    if (column_id == (size_t)-1) break;
+  }
+  return values;
+}
+
+/// Small, fast run settings (override as needed).
+void Configure(aagos::AagosConfig & config, const std::string & out_dir) {
+  config.SEED(3);
+  config.POP_SIZE(64);
+  config.MAX_GENS(40);
+  config.NUM_BITS(32);
+  config.NUM_GENES(4);
+  config.GENE_SIZE(4);
+  config.MIN_SIZE(8);
+  config.MAX_SIZE(64);
+  config.CHANGE_MAGNITUDE(2);
+  config.CHANGE_FREQUENCY(3);
+  config.PRINT_INTERVAL(1000);
+  config.SUMMARY_INTERVAL(5);
+  config.SNAPSHOT_INTERVAL(10);
+  config.DATA_FILEPATH(out_dir);
+}
+
+bool SamePopulation(aagos::AagosWorld & a, aagos::AagosWorld & b) {
+  if (a.GetSize() != b.GetSize()) return false;
+  for (size_t org_id = 0; org_id < a.GetSize(); ++org_id) {
+    if (a.GetOrg(org_id).GetGenome() != b.GetOrg(org_id).GetGenome()) return false;
+  }
+  return true;
+}
+
+/// Run fun in a child process (output discarded); did it exit with a failure status?
+bool ExitsWithFailure(const std::function<void()> & fun) {
+  std::cout.flush();
+  const pid_t pid = fork();
+  if (pid == 0) {
+    if (!std::freopen("/dev/null", "w", stdout)) _exit(0);
+    fun();
+    std::cout.flush();
+    _exit(0);
+  }
+  int status = 0;
+  if (pid < 0 || waitpid(pid, &status, 0) != pid) return false;
+  return WIFEXITED(status) && WEXITSTATUS(status) != 0;
+}
+
+/// Run the program at path with args (output discarded); returns its exit status (-1 if it didn't exit).
+int RunProgram(const std::string & path, const emp::vector<std::string> & args) {
+  std::cout.flush();
+  const pid_t pid = fork();
+  if (pid == 0) {
+    if (!std::freopen("/dev/null", "w", stdout)) _exit(127);
+    emp::vector<char *> argv{const_cast<char *>(path.c_str())};
+    for (const std::string & arg : args) argv.emplace_back(const_cast<char *>(arg.c_str()));
+    argv.emplace_back(nullptr);
+    execv(path.c_str(), argv.data());
+    _exit(127);
+  }
+  int status = 0;
+  if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return -1;
+  return WEXITSTATUS(status);
+}
+
+/// Do a and b have the same landscape values (to within tolerance)?
+bool SameLandscape(const aagos::NKFitnessModel & a, const aagos::NKFitnessModel & b, double tolerance=0.0) {
+  if (a.landscape.GetN() != b.landscape.GetN() || a.landscape.GetStateCount() != b.landscape.GetStateCount()) return false;
+  for (size_t n = 0; n < a.landscape.GetN(); ++n) {
+    for (size_t state = 0; state < a.landscape.GetStateCount(); ++state) {
+      if (std::abs(a.landscape.GetFitness(n, state) - b.landscape.GetFitness(n, state)) > tolerance) return false;
+    }
+  }
+  return true;
+}
+
+bool SameTargets(const aagos::GradientFitnessModel & a, const aagos::GradientFitnessModel & b) {
+  return a.targets == b.targets && a.target_words == b.target_words;
+}
+
+void TestParsers() {
+  size_t value = 0;
+  Check(aagos::parsing::ParseSize("1024", value) && value == 1024, "ParseSize: whole number");
+  for (const char * bad : {"", "-1", "12x", " 12", "1.5", "99999999999999999999999"}) {
+    Check(!aagos::parsing::ParseSize(bad, value), std::string("ParseSize: rejects '") + bad + "'");
+  }
+  const std::string numbers = "0.25 -3e2 1e-300 abc";
+  aagos::parsing::Cursor cursor(numbers.data(), numbers.data() + numbers.size());
+  double number = 0.0;
+  bool parsed = true;
+  for (double expected : {0.25, -300.0, 1e-300}) {
+    cursor.SkipSpaces();
+    parsed = parsed && cursor.ParseDouble(number) && number == expected;
+  }
+  Check(parsed, "ParseDouble: numbers");
+  cursor.SkipSpaces();
+  Check(!cursor.ParseDouble(number) && cursor.Peek() == 'a', "ParseDouble: rejects a non-number without consuming it");
+  // Bitstrings (first character is the highest-order bit) of assorted lengths.
+  emp::Random random(1);
+  for (size_t num_bits : {1, 63, 64, 65, 130}) {
+    emp::BitVector bits(num_bits);
+    emp::RandomizeBitVector(bits, random);
+    std::ostringstream stream;
+    bits.Print(stream);
+    const std::string text = stream.str() + ",";
+    aagos::parsing::Cursor bit_cursor(text.data(), text.data() + text.size());
+    emp::BitVector parsed_bits;
+    Check(bit_cursor.ParseBits(parsed_bits) == num_bits && parsed_bits == bits && bit_cursor.Peek() == ',',
+          "ParseBits: " + std::to_string(num_bits) + " bits");
+  }
+}
+
+void TestTextEnvFiles() {
+  const std::string dir = MakeDir("text_env");
+  for (bool procedural : {false, true}) {
+    const std::string label = procedural ? "procedural NK landscape" : "NK landscape";
+    emp::Random random(1);
+    aagos::NKFitnessModel nk(random, 5, 4, procedural);
+    nk.RandomizeLandscapeBits(random, 10);
+    {
+      // Lines before the landscape (e.g., comments) are skipped.
+      std::ofstream text(dir + "env.env");
+      text << "# landscape\nnot a landscape\n";
+      nk.PrintLandscape(text);
+      text << std::endl;
+    }
+    emp::Random other_random(2);
+    aagos::NKFitnessModel from_text(other_random, 5, 4);
+    Check(from_text.LoadLandscape(dir + "env.env"), label + ": text load (" + from_text.GetLoadError() + ")");
+    // Text landscapes are printed with 6 significant digits.
+    Check(SameLandscape(nk, from_text, 1e-5), label + ": text round trip");
+  }
+  emp::Random random(1);
+  aagos::GradientFitnessModel gradient(random, 5, 70);  // Targets span more than one word.
+  gradient.RandomizeTargetBits(random, 20);
+  {
+    std::ofstream text(dir + "env.env");
+    gradient.PrintTargets(text);
+    text << std::endl;
+  }
+  emp::Random other_random(2);
+  aagos::GradientFitnessModel from_text(other_random, 5, 70);
+  Check(from_text.LoadTargets(dir + "env.env"), "gradient: text load (" + from_text.GetLoadError() + ")");
+  Check(SameTargets(gradient, from_text), "gradient: text round trip");
+}
+
+void TestBinaryEnvFiles() {
+  const std::string dir = MakeDir("binary_env");
+  for (bool procedural : {false, true}) {
+    const std::string label = procedural ? "procedural NK landscape" : "NK landscape";
+    emp::Random random(1);
+    aagos::NKFitnessModel nk(random, 5, 4, procedural);
+    nk.RandomizeLandscapeBits(random, 10);
+    Check(nk.SaveLandscapeBinary(dir + "env.envb"), label + ": binary save");
+    emp::Random other_random(2);
+    aagos::NKFitnessModel loaded(other_random, 5, 4);
+    Check(loaded.LoadLandscape(dir + "env.envb"), label + ": binary load (" + loaded.GetLoadError() + ")");
+    Check(SameLandscape(nk, loaded), label + ": binary round trip");
+    // Loaded landscapes are copied into the model's own table; only AttachBinary maps the file.
+    Check(loaded.landscape.HasTable() && !loaded.landscape.IsShared(), label + ": binary load copies the table");
+    loaded.landscape.SetState(0, 0, 0.5);
+    Check(loaded.landscape.GetNumOverrides() == 0, label + ": changes to a loaded landscape go to its table");
+    aagos::NKFitnessModel attached(other_random, 5, 4);
+    Check(attached.AttachBinary(dir + "env.envb") && attached.landscape.IsShared(), label + ": binary attach");
+    Check(SameLandscape(nk, attached), label + ": attached landscape matches");
+    aagos::NKFitnessModel mismatched(other_random, 4, 4);
+    Check(!mismatched.LoadLandscape(dir + "env.envb"), label + ": binary load with the wrong dimensions");
+  }
+
+  emp::Random random(1);
+  aagos::GradientFitnessModel gradient(random, 5, 70);  // Targets span more than one word.
+  gradient.RandomizeTargetBits(random, 20);
+  Check(gradient.SaveTargetsBinary(dir + "gradient.envb"), "gradient: binary save");
+  emp::Random other_random(2);
+  aagos::GradientFitnessModel loaded(other_random, 5, 70);
+  Check(loaded.LoadTargets(dir + "gradient.envb"), "gradient: binary load (" + loaded.GetLoadError() + ")");
+  Check(SameTargets(gradient, loaded), "gradient: binary round trip");
+
+  // Damaged or mismatched files are rejected.
+  const std::string good = ReadFile(dir + "env.envb");
+  std::string bad_version = good;
+  bad_version[8] = 9;
+  const emp::vector<std::pair<std::string, std::string>> bad_files = {
+    {"truncated header", good.substr(0, 20)},
+    {"truncated payload", good.substr(0, good.size() - 8)},
+    {"extra payload", good + "x"},
+    {"unknown version", bad_version},
+    {"gradient environment", ReadFile(dir + "gradient.envb")}
+  };
+  aagos::NKFitnessModel nk(other_random, 5, 4);
+  for (const auto & [name, contents] : bad_files) {
+    WriteFile(dir + "bad.envb", contents);
+    Check(!nk.LoadLandscape(dir + "bad.envb") && nk.GetLoadError().size(), "NK landscape: rejects " + name);
+  }
+}
+
+void TestSnapshots() {
+  const std::string dir = MakeDir("snapshots");
+  // Binary snapshots of genomes of assorted lengths (including partial and multiple words).
+  emp::Random random(1);
+  const size_t num_genes = 3;
+  const size_t gene_size = 5;
+  emp::vector<genome_t> genomes;
+  for (size_t num_bits : {8, 63, 64, 65, 200}) {
+    genome_t genome(num_bits, num_genes, gene_size);
+    genome.Randomize(random);
+    genome.ancestral_id = num_bits % 7;
+    genomes.emplace_back(std::move(genome));
+  }
+  const bool written = aagos::snapshot::WriteBinary(dir + "pop.bin", 12, 1, genomes.size(), num_genes, gene_size,
+    [&genomes](size_t org_id) -> const genome_t & { return genomes[org_id]; });
+  Check(written, "snapshot: binary write");
+  {
+    aagos::parsing::MappedFile file(dir + "pop.bin");
+    emp::vector<genome_t> loaded;
+    std::string error;
+    Check(aagos::snapshot::IsBinarySnapshot(file), "snapshot: binary format detected");
+    Check(aagos::snapshot::LoadBinary(file, dir + "pop.bin", num_genes, gene_size, 1, loaded, error), "snapshot: binary load (" + error + ")");
+    Check(loaded == genomes, "snapshot: binary round trip");
+    Check(!aagos::snapshot::LoadBinary(file, dir + "pop.bin", num_genes + 1, gene_size, 1, loaded, error),
+          "snapshot: binary load with the wrong number of genes");
+  }
+  // Records packed for migration (see AagosMPI.cc) use the same layout.
+  emp::vector<uint64_t> words;
+  for (const genome_t & genome : genomes) aagos::snapshot::PackRecord(genome, num_genes, words);
+  emp::vector<genome_t> unpacked;
+  size_t pos = 0;
+  while (pos < words.size() && aagos::snapshot::UnpackRecord(words.data(), words.size(), pos, num_genes, gene_size, unpacked)) { ; }
+  Check(unpacked == genomes, "snapshot: packed records round trip");
+  const std::string written_file = ReadFile(dir + "pop.bin");
+  const size_t records_start = sizeof(aagos::snapshot::Header) + genomes.size() * sizeof(uint64_t);
+  Check(written_file.size() == records_start + words.size() * sizeof(uint64_t)
+        && std::memcmp(written_file.data() + records_start, words.data(), words.size() * sizeof(uint64_t)) == 0,
+        "snapshot: written records match packed records");
+
+  // Corrupt counts and offsets are rejected rather than read out of range.
+  auto corrupt = [&](size_t file_offset, uint64_t value) {
+    std::string contents = written_file;
+    std::memcpy(contents.data() + file_offset, &value, sizeof(value));
+    WriteFile(dir + "bad.bin", contents);
+    aagos::parsing::MappedFile file(dir + "bad.bin");
+    emp::vector<genome_t> loaded;
+    std::string error;
+    return !aagos::snapshot::LoadBinary(file, dir + "bad.bin", num_genes, gene_size, 1, loaded, error) && error.size();
+  };
+  const size_t pop_size_field = offsetof(aagos::snapshot::Header, pop_size);
+  const size_t first_offset = sizeof(aagos::snapshot::Header);
+  const size_t first_num_bits = records_start + sizeof(uint64_t);
+  Check(corrupt(pop_size_field, UINT64_MAX / 4), "snapshot: rejects a huge pop_size");
+  Check(corrupt(first_offset, UINT64_MAX - 8), "snapshot: rejects an offset past the end of the file");
+  Check(corrupt(first_offset, written_file.size() - 8), "snapshot: rejects a truncated record");
+  Check(corrupt(first_num_bits, UINT64_MAX - 30), "snapshot: rejects a huge genome size");
+  Check(corrupt(first_num_bits, 5000), "snapshot: rejects a genome that runs past the end of the file");
+
+  // A world's csv and binary snapshots hold its population.
+  aagos::AagosConfig config;
+  Configure(config, dir + "run/");
+  config.SNAPSHOT_BINARY(true);
+  TestWorld world(config);
+  world.Setup();
+  for (size_t u = 0; u < 7; ++u) world.RunStep();
+  world.EvaluatePopulation();
+  world.Snapshot();
+  emp::vector<genome_t> expected;
+  for (size_t org_id = 0; org_id < world.GetSize(); ++org_id) expected.emplace_back(world.GetOrg(org_id).GetGenome());
+  const std::string prefix = dir + "run/pop_" + std::to_string(world.GetUpdate());
+  for (bool binary : {false, true}) {
+    const std::string path = prefix + (binary ? ".bin" : ".csv");
+    aagos::parsing::MappedFile file(path);
+    emp::vector<genome_t> loaded;
+    std::string error(file.GetError());
+    const bool loaded_ok = file.IsOpen() && (binary
+      ? aagos::snapshot::LoadBinary(file, path, config.NUM_GENES(), config.GENE_SIZE(), 2, loaded, error)
+      : aagos::snapshot::LoadCSV(file, path, config.NUM_GENES(), config.GENE_SIZE(), 2, loaded, error));
+    Check(loaded_ok, "snapshot: load " + path + " (" + error + ")");
+    Check(loaded == expected, "snapshot: " + path + " holds the world's population");
+  }
+}
+
+/// Islands split POP_SIZE, migrate on schedule, and repeat exactly although they step on several
+/// threads.
+void TestIslands() {
+  using model_t = aagos::AagosIslandModel;
+  using TOPOLOGY = model_t::TOPOLOGY;
+  const std::string dir = MakeDir("islands");
+  aagos::AagosConfig config;
+  Configure(config, dir);
+  config.POP_SIZE(31);
+  Check(model_t::GetIslandSize(config, 3, 0) == 11 && model_t::GetIslandSize(config, 3, 1) == 10
+        && model_t::GetIslandSize(config, 3, 2) == 10, "islands: POP_SIZE split between islands");
+  Check(model_t::GetDestination(TOPOLOGY::RING, 3, 2, 0, 0, 0) == 0, "islands: ring topology wraps around");
+  bool spread = true;
+  for (size_t src = 0; src < 4; ++src) {
+    emp::vector<size_t> counts(4, 0);
+    for (size_t k = 0; k < 6; ++k) ++counts[model_t::GetDestination(TOPOLOGY::FULL, 4, src, k, 1, 0)];
+    for (size_t dst = 0; dst < 4; ++dst) spread = spread && counts[dst] == (dst == src ? 0 : 2);
+  }
+  Check(spread, "islands: full topology spreads emigrants evenly over the other islands");
+
+  emp::vector<emp::Ptr<aagos::AagosConfig>> configs;
+  emp::vector<emp::Ptr<model_t>> models;
+  for (const char * run : {"a/", "b/"}) {
+    configs.emplace_back(emp::NewPtr<aagos::AagosConfig>());
+    Configure(*configs.back(), dir + run);
+    configs.back()->POP_SIZE(48);
+    configs.back()->MAX_GENS(20);
+    configs.back()->NUM_ISLANDS(3);
+    configs.back()->MIGRATION_INTERVAL(5);
+    configs.back()->MIGRATION_RATE(0.25);
+    configs.back()->MIGRATION_TOPOLOGY("ring");
+    models.emplace_back(emp::NewPtr<model_t>(*configs.back()));
+    models.back()->Setup();
+    models.back()->Run();
+  }
+  bool same = true;
+  for (size_t island_id = 0; island_id < 3; ++island_id) {
+    same = same && SamePopulation(models[0]->GetIsland(island_id), models[1]->GetIsland(island_id));
+  }
+  Check(same, "islands: identically seeded runs match");
+  // Stats are written before migrating, so the last row (update 20) counts migrations at 5, 10 and 15;
+  // each of those sends round(0.25 * 16) = 4 organisms to the next island.
+  for (size_t island_id = 0; island_id < 3; ++island_id) {
+    const auto immigrants = ReadColumn(dir + "a/island_stats.csv", "island_" + std::to_string(island_id) + "_immigrants");
+    Check(immigrants.size() && immigrants.back() == "12", "islands: island " + std::to_string(island_id) + " received 12 immigrants");
+  }
+  for (auto model : models) model.Delete();
+  for (auto model_config : configs) model_config.Delete();
+}
+
+/// Grid tournaments pick parents from each cell's neighborhood, independent of tiling and thread count.
+void TestGrid() {
+  const size_t width = 9;
+  const size_t height = 7;
+  const size_t radius = 1;
+  emp::Random random(1);
+  emp::vector<double> fitness(width * height);
+  for (double & value : fitness) value = random.GetDouble();
+  auto get_fitness = [&fitness](size_t org_id) { return fitness[org_id]; };
+  emp::vector<size_t> expected;
+  {
+    aagos::AagosThreadPool pool(1);
+    aagos::AagosGrid(width, height, radius, 1).SelectParents(3, 42, 5, get_fitness, pool, expected);
+  }
+  auto wrapped_distance = [](size_t a, size_t b, size_t size) {
+    const size_t d = (a > b) ? a - b : b - a;
+    return std::min(d, size - d);
+  };
+  bool local = expected.size() == width * height;
+  for (size_t cell = 0; local && cell < expected.size(); ++cell) {
+    local = wrapped_distance(cell % width, expected[cell] % width, width) <= radius
+            && wrapped_distance(cell / width, expected[cell] / width, height) <= radius;
+  }
+  Check(local, "grid: parents come from each cell's neighborhood");
+  for (size_t num_threads : {1, 2, 4}) {
+    aagos::AagosThreadPool pool(num_threads);
+    for (size_t tile_size : {1, 2, 4, 16}) {
+      emp::vector<size_t> parents;
+      aagos::AagosGrid(width, height, radius, tile_size).SelectParents(3, 42, 5, get_fitness, pool, parents);
+      Check(parents == expected, "grid: same parents with " + std::to_string(num_threads) + " threads and "
+            + std::to_string(tile_size) + "x" + std::to_string(tile_size) + " tiles");
+    }
+  }
+  {
+    aagos::AagosThreadPool pool(2);
+    emp::vector<size_t> parents;
+    aagos::AagosGrid(width, height, 0, 4).SelectParents(3, 42, 5, get_fitness, pool, parents);
+    bool own = true;
+    for (size_t cell = 0; cell < parents.size(); ++cell) own = own && parents[cell] == cell;
+    Check(own, "grid: with radius 0, every cell is its own parent");
+  }
+
+  // Whole runs on a grid match across evaluation thread counts and tile sizes.
+  const std::string dir = MakeDir("grid");
+  aagos::AagosConfig base_config;
+  aagos::AagosConfig threaded_config;
+  Configure(base_config, dir + "base/");
+  Configure(threaded_config, dir + "threaded/");
+  for (auto config : {&base_config, &threaded_config}) {
+    config->GRID_WIDTH(8);
+    config->GRID_NEIGHBORHOOD_RADIUS(1);
+    config->TOURNAMENT_SIZE(3);
+  }
+  base_config.EVAL_THREADS(1);
+  base_config.GRID_TILE_SIZE(8);
+  threaded_config.EVAL_THREADS(4);
+  threaded_config.GRID_TILE_SIZE(3);
+  aagos::AagosWorld base(base_config);
+  aagos::AagosWorld threaded(threaded_config);
+  base.Setup();
+  threaded.Setup();
+  bool same = true;
+  for (size_t gen = 0; gen <= base_config.MAX_GENS(); ++gen) {
+    base.RunStep();
+    threaded.RunStep();
+    same = same && SamePopulation(base, threaded);
+  }
+  Check(same, "grid: runs match with 1 and 4 evaluation threads");
+}
+
+/// Sweep jobs are claimed exactly once, stale locks (and only stale locks) are reclaimed, and a run
+/// marks every job done or failed.
+void TestSweep() {
+  const std::string dir = MakeDir("sweep");
+  WriteFile(dir + "spec.txt", "# Sweep\nCHANGE_MAGNITUDE 0 1\nREPLICATES 2\n");
+  aagos::AagosConfig config;
+  Configure(config, dir + "unused/");
+  config.MAX_GENS(5);
+  SweepHarness sweep(dir + "sweep");
+  Check(sweep.CreateJobs(dir + "spec.txt", config), "sweep: create jobs");
+  Check(ReadFile(dir + "sweep/jobs/job_000003.job") == "CHANGE_MAGNITUDE 1\nSEED 4\n", "sweep: job settings and seed");
+  Check(!sweep.CreateJobs(dir + "spec.txt", config), "sweep: jobs aren't created twice");
+
+  // Two coordinators claim every job exactly once between them.
+  SweepHarness other(dir + "sweep");
+  emp::vector<std::string> claimed;
+  std::string job;
+  for (bool first = true; (first ? sweep : other).ClaimNext(job); first = !first) claimed.emplace_back(job);
+  Check(claimed == emp::vector<std::string>({"job_000000", "job_000001", "job_000002", "job_000003"}),
+        "sweep: each job claimed once");
+  Check(!sweep.ClaimNext(job) && !other.ClaimNext(job), "sweep: nothing left to claim");
+
+  // Lock staleness.
+  const std::string lock = sweep.LockPath("job_000000");
+  std::string reason;
+  auto stale = [&](const std::string & contents) {
+    WriteFile(lock, contents);
+    reason.clear();
+    return sweep.IsStaleLock(lock, reason);
+  };
+  Check(!stale(sweep.GetLockOwner()), "sweep: a live worker's lock is not stale");
+  std::cout.flush();
+  const pid_t child = fork();
+  if (child == 0) _exit(0);
+  waitpid(child, nullptr, 0);
+  const std::string self = std::to_string(getpid());
+  Check(stale(sweep.GetHost() + " " + std::to_string(child) + " " + sweep.GetBootId() + " -\n")
+        && reason.find("is gone") != std::string::npos, "sweep: a lock from a dead worker is stale (" + reason + ")");
+  Check(stale(sweep.GetHost() + " " + self + " another-boot -\n") && reason.find("rebooted") != std::string::npos,
+        "sweep: a lock from before a reboot is stale (" + reason + ")");
+  Check(stale(sweep.GetHost() + " " + self + " " + sweep.GetBootId() + " 1\n") && reason.find("reused") != std::string::npos,
+        "sweep: a lock whose pid was reused is stale (" + reason + ")");
+  Check(!stale("another-host 1 - -\n"), "sweep: another host's fresh lock is not stale");
+  const struct timespec old_times[2] = {{0, UTIME_OMIT}, {time(nullptr) - aagos::AagosSweep::STALE_LOCK_SECONDS - 60, 0}};
+  utimensat(AT_FDCWD, lock.c_str(), old_times, 0);
+  reason.clear();
+  Check(sweep.IsStaleLock(lock, reason) && reason.find("no heartbeat") != std::string::npos,
+        "sweep: another host's lock without a recent heartbeat is stale (" + reason + ")");
+
+  // Heartbeats refresh this worker's lock and notice when it was taken over.
+  WriteFile(lock, sweep.GetLockOwner());
+  utimensat(AT_FDCWD, lock.c_str(), old_times, 0);
+  Check(sweep.Heartbeat("job_000000") && !sweep.IsStaleLock(lock, reason), "sweep: heartbeat refreshes the lock");
+  WriteFile(lock, "another-host 1 - -\n");
+  Check(!sweep.Heartbeat("job_000000"), "sweep: heartbeat notices a reclaimed lock");
+
+  // Reclaiming releases only stale locks.
+  WriteFile(sweep.LockPath("job_000001"), sweep.GetHost() + " " + std::to_string(child) + " " + sweep.GetBootId() + " -\n");
+  WriteFile(sweep.LockPath("job_000002"), sweep.GetLockOwner());
+  std::filesystem::remove(sweep.LockPath("job_000003"));
+  Check(sweep.ReclaimStaleLocks() == 1 && std::filesystem::exists(lock) && !std::filesystem::exists(sweep.LockPath("job_000001"))
+        && std::filesystem::exists(sweep.LockPath("job_000002")), "sweep: only stale locks are reclaimed");
+
+  // A run finishes every unclaimed job, and marks jobs with bad settings as failed.
+  for (const std::string & held : {std::string("job_000000"), std::string("job_000002")}) std::filesystem::remove(sweep.LockPath(held));
+  WriteFile(dir + "sweep/jobs/job_000003.job", "NOT_A_SETTING 1\n");
+  Check(!sweep.Run(config, 2), "sweep: a run with a failed job reports failure");
+  for (size_t job_id = 0; job_id < 4; ++job_id) {
+    const std::string name = "job_00000" + std::to_string(job_id);
+    const bool done = std::filesystem::exists(dir + "sweep/done/" + name + ".done");
+    const bool failed = std::filesystem::exists(dir + "sweep/failed/" + name + ".failed");
+    Check(job_id == 3 ? (failed && !done) : (done && !failed), "sweep: " + name + (job_id == 3 ? " failed" : " done"));
+    Check(!std::filesystem::exists(sweep.LockPath(name)), "sweep: " + name + "'s lock released");
+  }
+  Check(std::filesystem::exists(dir + "sweep/runs/job_000000/fitness.csv"), "sweep: job output written to its run directory");
+}
+
+/// Continuing phase two from a copy of a phase-one world matches running both phases in one world.
+void TestBranchEquivalence(const std::string & name, bool gradient, size_t env_bank_size) {
+  const std::string dir = MakeDir("branch_" + name);
+  aagos::AagosConfig whole_config;
+  aagos::AagosConfig parent_config;
+  aagos::AagosConfig branch_config;
+  for (auto config : {&whole_config, &parent_config, &branch_config}) {
+    Configure(*config, dir + (config == &whole_config ? "whole/" : config == &parent_config ? "parent/" : "branch/"));
+    config->GRADIENT_MODEL(gradient);
+    config->ENV_BANK_SIZE(env_bank_size);
+    config->MAX_GENS(20);
+    config->PHASE_2_ACTIVE(true);
+    config->PHASE_2_MAX_GENS(20);
+    config->PHASE_2_CHANGE_MAGNITUDE(4);
+    config->PHASE_2_CHANGE_FREQUENCY(2);
+  }
+  aagos::AagosWorld whole(whole_config);
+  whole.Setup();
+  whole.Run();
+  aagos::AagosWorld parent(parent_config);
+  parent.Setup();
+  parent.RunPhaseOne();
+  aagos::AagosWorld branch(branch_config);
+  branch.Setup();
+  branch.ContinueFrom(parent);
+  branch.RunPhaseTwo();
+  Check(branch.GetUpdate() == whole.GetUpdate(), name + ": branch ends at the same update");
+  Check(SamePopulation(branch, whole), name + ": branch population matches the unbranched run");
+  const bool same_env = gradient ? SameTargets(branch.GetGradientFitnessModel(), whole.GetGradientFitnessModel())
+                                 : SameLandscape(branch.GetNKFitnessModel(), whole.GetNKFitnessModel());
+  Check(same_env, name + ": branch environment matches the unbranched run");
+}
+
+/// AagosCrossEval's fitness matrix matches evaluating each snapshot organism under each environment
+/// directly, for text and binary environment files and any number of threads.
+void TestCrossEval() {
+  const std::string dir = MakeDir("cross_eval");
+  if (!std::filesystem::exists(cross_eval_path)) {
+    Check(false, "cross-eval: " + cross_eval_path + " not found (build it with make cross-eval)");
+    return;
+  }
+  const size_t num_genes = 4;
+  const size_t gene_size = 4;
+  emp::Random random(5);
+  emp::vector<emp::vector<genome_t>> pops(2);
+  for (size_t pop_id = 0; pop_id < pops.size(); ++pop_id) {
+    for (size_t org_id = 0; org_id < 10 + 5 * pop_id; ++org_id) {
+      pops[pop_id].emplace_back(16 + 3 * org_id, num_genes, gene_size);
+      pops[pop_id].back().Randomize(random);
+    }
+    Check(aagos::snapshot::WriteBinary(dir + "pop_" + std::to_string(pop_id) + ".bin", 0, 1, pops[pop_id].size(), num_genes,
+                                       gene_size, [&](size_t org_id) -> const genome_t & { return pops[pop_id][org_id]; }),
+          "cross-eval: write population " + std::to_string(pop_id));
+  }
+
+  // NK: one text and one binary landscape.
+  aagos::NKFitnessModel text_nk(random, num_genes, gene_size);
+  {
+    std::ofstream out(dir + "nk.txt");
+    text_nk.PrintLandscape(out);
+  }
+  aagos::NKFitnessModel text_loaded(random, num_genes, gene_size);
+  Check(text_loaded.LoadLandscape(dir + "nk.txt"), "cross-eval: text landscape loads");
+  aagos::NKFitnessModel binary_nk(random, num_genes, gene_size);
+  Check(binary_nk.SaveLandscapeBinary(dir + "nk.envb"), "cross-eval: save binary landscape");
+  // Gradient: one binary target set.
+  aagos::GradientFitnessModel targets(random, num_genes, gene_size);
+  Check(targets.SaveTargetsBinary(dir + "targets.envb"), "cross-eval: save binary targets");
+
+  // Read back a fitness matrix written by AagosCrossEval; false if it is malformed.
+  auto read_matrix = [](const std::string & path, size_t & num_orgs, size_t & num_envs, emp::vector<double> & matrix) {
+    const std::string data = ReadFile(path);
+    uint64_t dims[2] = {0, 0};
+    if (data.size() < 8 + sizeof(dims) || data.compare(0, 8, "AAGOSXEV") != 0) return false;
+    std::memcpy(dims, data.data() + 8, sizeof(dims));
+    num_orgs = dims[0];
+    num_envs = dims[1];
+    if (data.size() != 8 + sizeof(dims) + num_orgs * num_envs * sizeof(double)) return false;
+    matrix.resize(num_orgs * num_envs);
+    std::memcpy(matrix.data(), data.data() + 8 + sizeof(dims), matrix.size() * sizeof(double));
+    return true;
+  };
+  const emp::vector<std::string> pop_args = {"--pops", dir + "pop_0.bin", dir + "pop_1.bin"};
+  for (const std::string threads : {"1", "3"}) {
+    const std::string label = "cross-eval (" + threads + " threads)";
+    emp::vector<std::string> args = {"nk", std::to_string(num_genes), std::to_string(gene_size), dir + "nk_" + threads};
+    args.insert(args.end(), pop_args.begin(), pop_args.end());
+    args.insert(args.end(), {"--envs", dir + "nk.txt", dir + "nk.envb", "--threads", threads});
+    Check(RunProgram(cross_eval_path, args) == 0, label + ": nk run succeeds");
+    size_t num_orgs = 0, num_envs = 0;
+    emp::vector<double> matrix;
+    Check(read_matrix(dir + "nk_" + threads + ".bin", num_orgs, num_envs, matrix), label + ": nk matrix readable");
+    Check(num_orgs == pops[0].size() + pops[1].size() && num_envs == 2, label + ": nk matrix dimensions");
+    if (matrix.size() != (pops[0].size() + pops[1].size()) * 2) continue;
+    bool same = true;
+    size_t row = 0;
+    for (const auto & pop : pops) {
+      for (const genome_t & genome : pop) {
+        same &= matrix[row * 2] == aagos::eval::EvaluateNK(text_loaded, genome, num_genes, gene_size);
+        same &= matrix[row * 2 + 1] == aagos::eval::EvaluateNK(binary_nk, genome, num_genes, gene_size);
+        ++row;
+      }
+    }
+    Check(same, label + ": nk fitnesses match direct evaluation");
+    const std::string csv = ReadFile(dir + "nk_" + threads + ".csv");
+    Check((size_t)std::count(csv.begin(), csv.end(), '\n') == num_orgs + 1, label + ": one csv row per organism");
+  }
+
+  emp::vector<std::string> args = {"gradient", std::to_string(num_genes), std::to_string(gene_size), dir + "gradient"};
+  args.insert(args.end(), pop_args.begin(), pop_args.end());
+  args.insert(args.end(), {"--envs", dir + "targets.envb"});
+  Check(RunProgram(cross_eval_path, args) == 0, "cross-eval: gradient run succeeds");
+  size_t num_orgs = 0, num_envs = 0;
+  emp::vector<double> matrix;
+  if (read_matrix(dir + "gradient.bin", num_orgs, num_envs, matrix) && num_envs == 1 && num_orgs == matrix.size()) {
+    bool same = true;
+    size_t row = 0;
+    for (const auto & pop : pops) {
+      for (const genome_t & genome : pop) same &= matrix[row++] == aagos::eval::EvaluateGradient(targets, genome, num_genes, gene_size);
+    }
+    Check(same, "cross-eval: gradient fitnesses match direct evaluation");
+  } else {
+    Check(false, "cross-eval: gradient matrix readable");
+  }
+
+  // Bad inputs fail instead of writing a partial matrix.
+  Check(RunProgram(cross_eval_path, {"nk", "4", "4", dir + "missing", "--pops", dir + "pop_0.bin", "--envs", dir + "nope.envb"}) != 0,
+        "cross-eval: a missing environment fails");
+  Check(!std::filesystem::exists(dir + "missing.bin"), "cross-eval: no matrix written after a failure");
+  Check(RunProgram(cross_eval_path, {"nk", "5", "4", dir + "mismatch", "--pops", dir + "pop_0.bin", "--envs", dir + "nk.envb"}) != 0,
+        "cross-eval: mismatched dimensions fail");
+}
+
+/// Environment bank schedules switch between the bank's environments in order, and each environment's
+/// fitness cache returns stored phenotypes (hits) for genomes it has already seen, without changing a run.
+void TestEnvBank() {
+  const std::string dir = MakeDir("env_bank");
+  emp::Random random(7);
+  aagos::AagosEnvBank<aagos::NKFitnessModel> bank(4, 2);
+  for (size_t env_id = 0; env_id < 3; ++env_id) bank.Add(emp::NewPtr<aagos::NKFitnessModel>(random, 4, 4));
+  std::string error;
+  auto follow = [&](size_t steps) {
+    emp::vector<size_t> ids = {bank.GetCurrentID()};
+    for (size_t step = 0; step < steps; ++step) ids.emplace_back(bank.Next(random));
+    return ids;
+  };
+  Check(bank.SetSchedule("cycle", error), "env bank: cycle schedule");
+  bank.Start();
+  Check(follow(4) == emp::vector<size_t>({0, 1, 2, 0, 1}), "env bank: cycle visits every environment in order");
+  Check(bank.SetSchedule("2,0, 2", error), "env bank: explicit schedule (" + error + ")");
+  bank.Start();
+  Check(follow(4) == emp::vector<size_t>({2, 0, 2, 2, 0}), "env bank: explicit schedule repeats");
+  Check(bank.SetSchedule("random", error), "env bank: random schedule");
+  bank.Start();
+  const emp::vector<size_t> visited = follow(50);
+  bool moves = true;
+  for (size_t step = 1; step < visited.size(); ++step) moves &= visited[step] != visited[step - 1] && visited[step] < 3;
+  Check(moves, "env bank: random schedule always switches to another environment");
+  for (const std::string spec : {"0,3", "0;1", "", "cycles"}) {
+    error.clear();
+    Check(!bank.SetSchedule(spec, error) && error.size(), "env bank: bad schedule (" + spec + ") rejected");
+  }
+
+  // Caches: misses are stored on commit, then hit (from any thread) with the stored phenotype.
+  Check(bank.SetSchedule("cycle", error), "env bank: back to cycle");
+  bank.Start();
+  genome_t genome(24, 4, 4);
+  genome.Randomize(random);
+  genome_t moved(genome);
+  moved.gene_starts[1] = (moved.gene_starts[1] + 1) % 24;  // Same bits, one gene moved.
+  aagos::AagosOrg::Phenotype phen(4);
+  auto cache = bank.GetCurrentCache();
+  Check(cache != nullptr && !cache->Fetch(0, genome, phen), "env bank: first lookup misses");
+  phen.fitness = 1.5;
+  phen.gene_fitness_contributions = {0.5, 1.0, 0.0, 0.0};
+  cache->Store(0, phen);
+  Check(!cache->Fetch(1, genome, phen), "env bank: stored phenotypes aren't visible until committed");
+  cache->Store(1, phen);
+  cache->Commit();
+  aagos::AagosOrg::Phenotype hit(4);
+  Check(cache->Fetch(1, genome, hit) && hit.evaluated && hit.fitness == 1.5
+        && hit.gene_fitness_contributions == emp::vector<double>({0.5, 1.0, 0.0, 0.0}), "env bank: cached phenotype returned");
+  Check(!cache->Fetch(0, moved, hit), "env bank: genomes that differ only in gene starts don't share entries");
+  cache->Commit();
+  Check(cache->GetHits() == 1 && cache->GetMisses() == 2 && cache->GetSize() == 1, "env bank: hits and misses counted");
+  bank.Next(random);
+  Check(bank.GetCurrentCache() != cache && !bank.GetCurrentCache()->Fetch(0, genome, hit),
+        "env bank: each environment has its own cache");
+  bank.Next(random);
+  bank.Next(random);
+  Check(bank.GetCurrentCache() == cache && cache->Fetch(0, genome, hit), "env bank: cache kept while away");
+  for (size_t extra = 0; extra < 4; ++extra) {
+    genome_t other(24, 4, 4);
+    other.Randomize(random);
+    if (!cache->Fetch(0, other, hit)) cache->Store(0, phen);
+  }
+  cache->Commit();
+  Check(cache->GetSize() <= cache->GetCapacity(), "env bank: cache stays within its capacity");
+  aagos::AagosEnvBank<aagos::NKFitnessModel> copy(4, 2);
+  for (size_t env_id = 0; env_id < 3; ++env_id) copy.Add(emp::NewPtr<aagos::NKFitnessModel>(random, 4, 4));
+  bank.Next(random);
+  copy.CopyStateFrom(bank);
+  Check(copy.GetCurrentID() == 1 && SameLandscape(*copy.GetEnv(2), *bank.GetEnv(2)), "env bank: copy takes environments and position");
+  Check(copy.GetCurrentCache()->GetSize() == 0, "env bank: copy starts with empty caches");
+
+  // Caching changes nothing about a run, and a run with a bank revisits environments often enough to hit.
+  aagos::AagosConfig cached_config;
+  aagos::AagosConfig uncached_config;
+  for (auto config : {&cached_config, &uncached_config}) {
+    Configure(*config, dir + (config == &cached_config ? "cached/" : "uncached/"));
+    config->ENV_BANK_SIZE(3);
+    config->ENV_BANK_SCHEDULE("cycle");
+    config->ENV_BANK_CACHE_SIZE(config == &cached_config ? 10000 : 0);
+  }
+  aagos::AagosWorld cached(cached_config);
+  cached.Setup();
+  cached.Run();
+  aagos::AagosWorld uncached(uncached_config);
+  uncached.Setup();
+  uncached.Run();
+  Check(SamePopulation(cached, uncached), "env bank: cached run matches uncached run");
+  Check(ReadFile(dir + "cached/fitness.csv") == ReadFile(dir + "uncached/fitness.csv"), "env bank: same fitness data with and without the cache");
+}
+
+/// Run a world with ENV_LOG, recording the environment in effect at every update, then check that
+/// the log rebuilds each of them.
+void TestEnvLog(const std::string & name, bool gradient, bool procedural) {
+  const std::string dir = MakeDir("env_log_" + name);
+  aagos::AagosConfig config;
+  Configure(config, dir);
+  config.ENV_LOG(true);
+  config.GRADIENT_MODEL(gradient);
+  config.NK_PROCEDURAL_LANDSCAPE(procedural);
+  config.CHANGE_FREQUENCY(2);
+  config.PHASE_2_ACTIVE(true);
+  config.PHASE_2_MAX_GENS(10);
+  config.PHASE_2_CHANGE_MAGNITUDE(3);
+  config.PHASE_2_CHANGE_FREQUENCY(1);
+  emp::vector<aagos::NKFitnessModel> nk_envs;
+  emp::vector<aagos::GradientFitnessModel> gradient_envs;
+  {
+    aagos::AagosWorld world(config);
+    world.Setup();
+    world.OnStepEnd([&](size_t) {
+      if (gradient) gradient_envs.emplace_back(world.GetGradientFitnessModel());
+      else nk_envs.emplace_back(world.GetNKFitnessModel());
+    });
+    world.Run();
+  }
+  aagos::env_log::Reader log(dir);
+  Check(log.IsOpen(), name + ": open environment log (" + log.GetError() + ")");
+  if (!log.IsOpen()) return;
+  if (!gradient) {
+    std::error_code error;
+    const bool compact = std::filesystem::exists(aagos::env_log::GetNKKeyframePath(dir, 0), error);
+    Check(compact == procedural, name + ": compact NK keyframes only for procedural landscapes");
+  }
+  const size_t num_updates = gradient ? gradient_envs.size() : nk_envs.size();
+  Check(num_updates == config.MAX_GENS() + config.PHASE_2_MAX_GENS() + 2, name + ": recorded every update");
+  emp::Random random(9);
+  aagos::env_log::Reader::RebuildInfo info;
+  for (size_t u = 0; u < num_updates; ++u) {
+    bool same = false;
+    if (gradient) {
+      aagos::GradientFitnessModel rebuilt(random, config.NUM_GENES(), config.GENE_SIZE());
+      same = log.Rebuild(u, rebuilt, info) && SameTargets(rebuilt, gradient_envs[u]);
+    } else {
+      aagos::NKFitnessModel rebuilt(random, config.NUM_GENES(), config.GENE_SIZE(), true);
+      same = log.Rebuild(u, rebuilt, info) && SameLandscape(rebuilt, nk_envs[u]);
+    }
+    Check(same, name + ": environment rebuilt for update " + std::to_string(u) + " " + log.GetError());
+  }
+  // Rebuilding for the wrong model, or from a directory without a log, fails.
+  aagos::NKFitnessModel wrong_nk(random, config.NUM_GENES(), config.GENE_SIZE(), true);
+  aagos::GradientFitnessModel wrong_gradient(random, config.NUM_GENES(), config.GENE_SIZE());
+  Check(gradient ? !log.Rebuild(0, wrong_nk, info) : !log.Rebuild(0, wrong_gradient, info), name + ": rebuild for the wrong model fails");
+  Check(!aagos::env_log::Reader(MakeDir("env_log_" + name + "_missing")).IsOpen(), name + ": no log to open");
+}
+
+/// DRIFT_MODE (with tournament size 1) only evaluates the population at updates that report on it;
+/// that must not change the run. With phylogeny tracking, drift mode is ignored, so taxa between
+/// outputs still get fitness data.
+void TestDriftEquivalence() {
+  const std::string dir = MakeDir("drift");
+  for (bool phylogeny : {false, true}) {
+    const std::string label = phylogeny ? "drift with phylogeny: " : "drift: ";
+    const std::string skip_dir = dir + (phylogeny ? "phylo_skip/" : "skip/");
+    const std::string eval_dir = dir + (phylogeny ? "phylo_eval/" : "eval/");
+    aagos::AagosConfig skip_config;
+    aagos::AagosConfig eval_config;
+    Configure(skip_config, skip_dir);
+    Configure(eval_config, eval_dir);
+    for (auto config : {&skip_config, &eval_config}) {
+      config->TOURNAMENT_SIZE(1);
+      config->PHYLOGENY_TRACKING(phylogeny);
+      config->DRIFT_MODE(config == &skip_config);
+    }
+    {
+      aagos::AagosWorld skip_world(skip_config);
+      aagos::AagosWorld eval_world(eval_config);
+      skip_world.Setup();
+      eval_world.Setup();
+      bool same = true;
+      for (size_t gen = 0; gen <= skip_config.MAX_GENS(); ++gen) {
+        skip_world.RunStep();
+        eval_world.RunStep();
+        same = same && SamePopulation(skip_world, eval_world);
+      }
+      Check(same, label + "populations match at every update");
+    }
+    emp::vector<std::string> files = {"fitness.csv", "gene_stats.csv", "representative_org.csv", "environment.csv", "pop_20.csv", "pop_40.csv"};
+    if (phylogeny) files.insert(files.end(), {"systematics.csv", "phylo_20.csv", "phylo_40.csv"});
+    for (const std::string & file : files) {
+      const std::string skip_output = ReadFile(skip_dir + file);
+      Check(skip_output.size() && skip_output == ReadFile(eval_dir + file), label + file + " matches");
+    }
+  }
+}
+
+/// Malformed environment and ancestor files are reported (with the line) and change nothing.
+void TestParseErrors() {
+  const std::string dir = MakeDir("parse_errors");
+  emp::Random random(1);
+  aagos::NKFitnessModel nk(random, 2, 2);
+  aagos::NKFitnessModel original(random, 2, 2);
+  original.landscape.SetTable({{0.1, 0.2, 0.3, 0.4}, {0.5, 0.6, 0.7, 0.8}});
+  const emp::vector<std::pair<std::string, std::string>> bad_landscapes = {
+    {"no landscape", "# nothing here\n"},
+    {"too few genes", "[ [ 0.1 0.2 0.3 0.4 ] ]\n"},
+    {"too many genes", "[ [ 0.1 0.2 0.3 0.4 ] [ 0.5 0.6 0.7 0.8 ] [ 0.1 0.2 0.3 0.4 ] ]\n"},
+    {"too few values", "\n[ [ 0.1 0.2 0.3 ] [ 0.5 0.6 0.7 0.8 ] ]\n"},
+    {"too many values", "[ [ 0.1 0.2 0.3 0.4 0.5 ] [ 0.5 0.6 0.7 0.8 ] ]\n"},
+    {"non-numeric value", "[ [ 0.1 0.2 x 0.4 ] [ 0.5 0.6 0.7 0.8 ] ]\n"},
+    {"truncated", "[ [ 0.1 0.2 0.3 0.4 ] [ 0.5"}
+  };
+  for (const auto & [name, contents] : bad_landscapes) {
+    WriteFile(dir + "bad.env", contents);
+    nk.landscape.SetTable({{0.1, 0.2, 0.3, 0.4}, {0.5, 0.6, 0.7, 0.8}});
+    const bool loaded = nk.LoadLandscape(dir + "bad.env");
+    Check(!loaded && nk.GetLoadError().find(dir + "bad.env:") == 0, "NK landscape: " + name + " is reported (" + nk.GetLoadError() + ")");
+    Check(SameLandscape(nk, original), "NK landscape: " + name + " leaves the landscape untouched");
+  }
+  Check(!nk.LoadLandscape(dir + "missing.env") && nk.GetLoadError().size(), "NK landscape: missing file is reported");
+
+  aagos::GradientFitnessModel gradient(random, 2, 4);
+  aagos::GradientFitnessModel original_gradient(gradient);
+  const emp::vector<std::pair<std::string, std::string>> bad_targets = {
+    {"no targets", "\n"},
+    {"too few targets", "[ 0101 ]\n"},
+    {"too many targets", "[ 0101 1100 0011 ]\n"},
+    {"wrong target size", "[ 0101 11001 ]\n"},
+    {"non-binary target", "[ 0101 1a00 ]\n"}
+  };
+  for (const auto & [name, contents] : bad_targets) {
+    WriteFile(dir + "bad.env", contents);
+    Check(!gradient.LoadTargets(dir + "bad.env") && gradient.GetLoadError().find(dir + "bad.env:") == 0,
+          "gradient: " + name + " is reported (" + gradient.GetLoadError() + ")");
+    Check(SameTargets(gradient, original_gradient), "gradient: " + name + " leaves the targets untouched");
+  }
+
+  // Ancestor lists: a valid list seeds the population; a malformed one stops setup.
+  aagos::AagosConfig config;
+  Configure(config, dir + "run/");
+  config.POP_SIZE(4);
+  config.LOAD_ANCESTOR(true);
+  config.LOAD_ANCESTOR_FILE(dir + "ancestors.txt");
+  genome_t ancestor(12, config.NUM_GENES(), config.GENE_SIZE());
+  ancestor.Randomize(random);
+  std::ostringstream line;
+  for (size_t start : ancestor.gene_starts) line << start << ",";
+  ancestor.bits.Print(line);
+  WriteFile(dir + "ancestors.txt", "# ancestor\n" + line.str() + "\n");
+  {
+    aagos::AagosWorld world(config);
+    world.Setup();
+    bool seeded = world.GetSize() == config.POP_SIZE();
+    for (size_t org_id = 0; seeded && org_id < world.GetSize(); ++org_id) {
+      seeded = world.GetOrg(org_id).GetGenome().bits == ancestor.bits
+               && world.GetOrg(org_id).GetGenome().gene_starts == ancestor.gene_starts;
+    }
+    Check(seeded, "ancestor list: population seeded from the list");
+  }
+  const emp::vector<std::pair<std::string, std::string>> bad_ancestors = {
+    {"missing gene start", "1,2,3,010101010101\n"},
+    {"missing bits", "1,2,3,4,\n"},
+    {"trailing characters", "1,2,3,4,010101010101 x\n"},
+    {"genome too small", "1,2,3,4,0101\n"},
+    {"gene start past the end", "1,2,3,40,010101010101\n"}
+  };
+  for (const auto & [name, contents] : bad_ancestors) {
+    WriteFile(dir + "ancestors.txt", contents);
+    Check(ExitsWithFailure([&config]() { aagos::AagosWorld world(config); world.Setup(); }),
+          "ancestor list: " + name + " stops setup");
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    scratch_dir = argv[1];
+    if (scratch_dir.back() != '/') scratch_dir += '/';
+  }
+  if (argc > 2) cross_eval_path = argv[2];
+  const emp::vector<std::pair<std::string, std::function<void()>>> tests = {
+    {"parsers", TestParsers},
+    {"text environment files", TestTextEnvFiles},
+    {"binary environment files", TestBinaryEnvFiles},
+    {"parse errors", TestParseErrors},
+    {"population snapshots", TestSnapshots},
+    {"island model", TestIslands},
+    {"spatial grid", TestGrid},
+    {"sweep queue", TestSweep},
+    {"nk branch equivalence", []() { TestBranchEquivalence("nk", false, 0); }},
+    {"gradient branch equivalence", []() { TestBranchEquivalence("gradient", true, 0); }},
+    {"environment bank branch equivalence", []() { TestBranchEquivalence("env_bank", false, 3); }},
+    {"cross-evaluation", TestCrossEval},
+    {"environment bank", TestEnvBank},
+    {"nk environment log", []() { TestEnvLog("nk", false, false); }},
+    {"procedural nk environment log", []() { TestEnvLog("nk_procedural", false, true); }},
+    {"gradient environment log", []() { TestEnvLog("gradient", true, false); }},
+    {"drift mode equivalence", TestDriftEquivalence}
+  };
+  emp::vector<std::string> failed;
+  for (const auto & test : tests) {
+    std::cout << "== " << test.first << " ==" << std::endl;
+    const size_t failures_before = num_failures;
+    test.second();
+    if (num_failures > failures_before) failed.emplace_back(test.first);
+  }
+  std::cout << "==============================" << std::endl;
+  std::cout << num_checks << " checks; " << num_failures << " failed." << std::endl;
+  for (const std::string & name : failed) std::cout << "  Failed: " << name << std::endl;
+  return num_failures ? 1 : 0;
+}
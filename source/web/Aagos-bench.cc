@@ -0,0 +1,63 @@
+//  This file is part of Project Name
+//  Copyright (C) Michigan State University, 2017.
+//  Released under the MIT Software license; see doc/LICENSE
+//
+// Headless benchmark of the web builds (see make web-bench and scripts/web_bench.js). Runs the
+// canonical macro benchmark configurations under Node and reports generations/sec for whichever
+// variant (scalar, wasm SIMD, pthreads) this was compiled as.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+#include "../AagosConfig.hpp"
+#include "../AagosWorld.hpp"
+#include "../native/AagosMacroBench.hpp"
+
+#if defined(__EMSCRIPTEN_PTHREADS__)
+constexpr const char * VARIANT = "threads";
+#elif defined(__wasm_simd128__)
+constexpr const char * VARIANT = "simd";
+#else
+constexpr const char * VARIANT = "scalar";
+#endif
+
+/// Usage: node Aagos-bench-<variant>.js [configuration (default: all)] [generations (default: 200)]
+int main(int argc, char* argv[]) {
+  using clock_t = std::chrono::steady_clock;
+  const std::string which = (argc > 1) ? argv[1] : "all";
+  const size_t gens = (argc > 2) ? (size_t)std::strtoul(argv[2], nullptr, 10) : 200;
+  bool found = false;
+  for (const auto & entry : aagos::macro_bench::GetCanonicalConfigs()) {
+    if (which != "all" && which != entry.first) continue;
+    found = true;
+    const std::string out_path = "/tmp/aagos-web-bench-" + entry.first + "/";
+    mkdir(out_path.c_str(), 0777);
+    aagos::AagosConfig config;
+    entry.second(config);
+    config.MAX_GENS(gens);
+    config.PHASE_2_ACTIVE(false);
+    config.PRINT_INTERVAL(gens);
+    config.SUMMARY_INTERVAL(gens);
+    config.SNAPSHOT_INTERVAL(gens);
+    config.EVAL_THREADS(0); // Only the pthreads variant has more than one.
+    config.DATA_FILEPATH(out_path);
+
+    aagos::AagosWorld world(config);
+    world.Setup();
+    const auto run_start = clock_t::now();
+    world.Run();
+    const double run_sec = std::chrono::duration<double>(clock_t::now() - run_start).count();
+    const double gens_per_sec = (double)(gens + 1) / run_sec; // Run covers generations [0, MAX_GENS].
+    // Parsed by scripts/web_bench.js.
+    std::cout << "RESULT," << VARIANT << "," << entry.first << "," << (gens + 1) << ","
+              << run_sec << "," << gens_per_sec << std::endl;
+  }
+  if (!found) {
+    std::cout << "Unknown benchmark configuration (" << which << ")." << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -3,12 +3,12 @@
 //  Released under the MIT Software license; see doc/LICENSE
 
 #include "emp/web/web.hpp"
-#include "../AagosConfig.h"
-#include "../AagosWeb.h"
+#include "../AagosConfig.hpp"
+#include "../AagosWeb.hpp"
 // #include "Evolve/NK.h"
 
 struct AagosWebWrapper {
-  AagosConfig cfg;
+  aagos::AagosConfig cfg;
   emp::Ptr<AagosWebInterface> interface;
 
   AagosWebWrapper() {
@@ -39,6 +39,9 @@ struct AagosWebWrapper {
     cfg.PHASE_2_BIT_FLIP_PROB(cfg.BIT_FLIP_PROB());
     cfg.PHASE_2_BIT_INS_PROB(0.0);
     cfg.PHASE_2_BIT_DEL_PROB(0.0);
+    #ifdef __EMSCRIPTEN_PTHREADS__
+    cfg.EVAL_THREADS(0);      // make web-threads: evaluate with every thread in the pool.
+    #endif
     interface = emp::NewPtr<AagosWebInterface>(cfg);
   }
 
@@ -0,0 +1,150 @@
+//  This file is part of Project Name
+//  Copyright (C) Michigan State University, 2017.
+//  Released under the MIT Software license; see doc/LICENSE
+//
+// Web Worker host for the Aagos world (see make web-worker). The UI thread (AagosWebInterface built
+// with AAGOS_WEB_WORKER) sends the configuration and step requests; the worker steps the world and
+// responds with serialized AagosPopFrames.
+
+#include <emscripten.h>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+
+#include "../AagosConfig.hpp"
+#include "../AagosWorld.hpp"
+#include "../AagosPopFrame.hpp"
+
+namespace {
+
+/// Steps the world the same way AagosWebInterface::DoFrame does, minus the drawing.
+class WorkerWorld : public aagos::AagosWorld {
+public:
+  using aagos::AagosWorld::AagosWorld;
+
+  bool finished=false;
+
+  /// Run a single generation. If capture is true (or this generation should be drawn), frame is
+  /// updated before the world advances. Returns whether frame was updated.
+  /// If stop_time is nonzero (time-budgeted stepping), frame is instead updated once stop_time (as
+  /// given by emscripten_get_now) has passed, and draw_pending tracks whether any generation since
+  /// the last frame should have been drawn.
+  bool StepGeneration(aagos::AagosPopFrame & frame, size_t draw_frequency, bool full_pop, bool summary,
+                      bool capture, double stop_time, bool & draw_pending) {
+    RunStep(false);
+    const size_t u = GetUpdate();
+    const bool phase_end = (u == config.MAX_GENS()) || (u == TOTAL_GENS);
+    const bool draw_gen = (draw_frequency && (u % draw_frequency == 0)) || phase_end;
+    draw_pending = draw_pending || draw_gen;
+    if (stop_time > 0) {
+      capture = capture || phase_end || (emscripten_get_now() >= stop_time);
+    } else {
+      capture = capture || draw_gen;
+      draw_pending = draw_pending || capture; // Without a budget, every captured frame is drawn.
+    }
+    if (capture) frame.Capture(*this, full_pop && draw_pending, draw_pending, summary && draw_pending);
+    // Phase transitions/end of run.
+    if ((cur_phase == 0) && (u >= config.MAX_GENS())) {
+      if (config.PHASE_2_ACTIVE()) ActivateEvoPhaseTwo();
+      else finished = true;
+    } else if (cur_phase == 1 && u >= TOTAL_GENS) {
+      finished = true;
+    }
+    if (finished && !capture) {
+      frame.Capture(*this, full_pop, true, summary);
+      capture = true;
+      draw_pending = true;
+    }
+    frame.draw = draw_pending;
+    frame.finished = finished;
+    AdvanceWorld();
+    return capture;
+  }
+};
+
+aagos::AagosConfig config;
+emp::Ptr<WorkerWorld> world;
+aagos::AagosPopFrame frame;
+aagos::AagosPopFrame last_frame;        ///< Frame most recently sent to the UI thread.
+size_t num_frames_sent=0;               ///< Frame ids are never reused (see AagosPopFrame).
+emp::vector<emp::BitVector> last_env;   ///< Environment most recently sent to the UI thread.
+emp::vector<unsigned char> buffer;
+
+/// Only send the environment when it has changed, and organisms that weren't in the last frame sent
+/// (unless forced, e.g., because the UI thread no longer holds that frame).
+void RespondWithFrame(bool force) {
+  if (frame.has_env) {
+    if (!force && frame.gradient_env == last_env) frame.has_env = false;
+    else last_env = frame.gradient_env;
+  }
+  frame.frame_id = ++num_frames_sent;
+  frame.Serialize(buffer, (force || !last_frame.frame_id) ? nullptr : &last_frame);
+  last_frame = frame;
+  emscripten_worker_respond((char *)buffer.data(), (int)buffer.size());
+}
+
+}
+
+extern "C" {
+
+/// Data: configuration (as written by emp::Config::Write). Sets up a new world, runs the first
+/// generation, and responds with its frame.
+EMSCRIPTEN_KEEPALIVE void aagos_worker_configure(char * data, int size) {
+  std::istringstream stream(std::string(data, (size_t)size));
+  config.Read(stream);
+  if (world == nullptr) world = emp::NewPtr<WorkerWorld>(config);
+  world->finished = false;
+  world->Setup();
+  last_env.clear();
+  bool draw_pending = false;
+  world->StepGeneration(frame, 1, false, false, true, 0.0, draw_pending);
+  RespondWithFrame(true);
+}
+
+/// Data: uint32_t[6] = {max generations, draw frequency, full population?, force full frame?,
+///                      step budget (microseconds), population summary?}
+/// Runs generations until reaching a generation that should be drawn (or max generations), then
+/// responds with that generation's frame. With a nonzero step budget, instead runs generations
+/// until the budget is spent (or max generations); the frame is marked for drawing if any of those
+/// generations should have been drawn. If max generations is 0, re-sends the last frame
+/// (recaptured if the full population is requested but the last frame only had the most fit org).
+EMSCRIPTEN_KEEPALIVE void aagos_worker_step(char * data, int size) {
+  uint32_t request[6] = {0, 0, 0, 0, 0, 0};
+  std::memcpy(request, data, emp::Min(sizeof(request), (size_t)size));
+  const size_t max_gens = request[0];
+  const size_t draw_frequency = request[1];
+  const bool full_pop = request[2];
+  const bool force = request[3];
+  const double budget_ms = request[4] / 1000.0;
+  const bool summary = request[5];
+  if (world == nullptr || !world->IsSetup()) {
+    emscripten_worker_respond(nullptr, 0);
+    return;
+  }
+  if (max_gens == 0 || world->finished) {
+    if (full_pop != frame.full_pop || summary != frame.has_summary) {
+      // As with redrawing after a draw mode toggle in the main-thread build, this recaptures the
+      // current generation (Capture evaluates it first if drift mode skipped its evaluation).
+      const bool was_finished = frame.finished;
+      frame.Capture(*world, full_pop, true, summary);
+      frame.finished = was_finished;
+    }
+    frame.draw = true;
+    RespondWithFrame(force);
+    return;
+  }
+  const double stop_time = (budget_ms > 0) ? emscripten_get_now() + budget_ms : 0.0;
+  bool draw_pending = false;
+  for (size_t i = 0; i < max_gens && !world->finished; ++i) {
+    const bool last = (i + 1 == max_gens);
+    if (world->StepGeneration(frame, draw_frequency, full_pop, summary, last, stop_time, draw_pending)) break;
+  }
+  RespondWithFrame(force);
+}
+
+}